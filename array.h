@@ -3,6 +3,8 @@
 
 
 #include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 void        *__array_at(void *arr, size_t idx);
 void        *__array_create(size_t item_size);
@@ -11,6 +13,36 @@ void        __array_clear(void *arr);
 void        *__array_pop(void *arr);
 size_t      __array_length(void *arr);
 void        __array_destroy(void *arr);
+void        *__array_insert_n(void *arr, size_t idx, const void *items, size_t count);
+void        __array_remove(void *arr, size_t idx);
+void        __array_remove_range(void *arr, size_t lower, size_t upper);
+void        *__array_swap_remove(void *arr, size_t idx);
+void        __array_truncate(void *arr, size_t length);
+void        *__array_reserve(void *arr, size_t capacity);
+size_t      __array_capacity(void *arr);
+void        __array_sort(void *arr, int (*cmp)(const void *, const void *));
+void        __array_radix_sort(void *arr, int kind);
+size_t      __array_find(void *arr, const void *value, int kind);
+size_t      __array_count(void *arr, const void *value, int kind);
+void        *__array_min(void *arr, int kind);
+void        *__array_max(void *arr, int kind);
+int64_t     __array_sum_int(void *arr, int kind);
+double      __array_sum_float(void *arr);
+size_t      __array_lower_bound(void *arr, const void *value, int kind);
+size_t      __array_upper_bound(void *arr, const void *value, int kind);
+void        *__array_eytzinger_build(void *arr);
+size_t      __array_eytzinger_lower_bound(void *arr, const void *value, int kind);
+
+// Span entry points behind the functions above: they take a plain pointer,
+// length and element size, so other containers and views reuse the kernels.
+size_t      __array_find_n(const void *data, size_t n, size_t item_size, const void *value, int kind);
+size_t      __array_count_n(const void *data, size_t n, size_t item_size, const void *value, int kind);
+size_t      __array_min_n(const void *data, size_t n, size_t item_size, int kind);
+size_t      __array_max_n(const void *data, size_t n, size_t item_size, int kind);
+int64_t     __array_sum_int_n(const void *data, size_t n, size_t item_size, int kind);
+double      __array_sum_float_n(const void *data, size_t n, size_t item_size);
+size_t      __array_lower_bound_n(const void *data, size_t n, size_t item_size, const void *value, int kind);
+size_t      __array_upper_bound_n(const void *data, size_t n, size_t item_size, const void *value, int kind);
 
 /**
  * @brief Defines a generic array type for a given element type.
@@ -134,12 +166,448 @@ void        __array_destroy(void *arr);
  */
 #define array_destroy(p)            (__array_destroy(p))
 
+/**
+ * @brief Inserts an element at a given position, shifting the tail right.
+ *
+ * Elements from `idx` onwards are moved up by one slot with a single `memmove`.
+ * `idx == array_length(p)` appends. The pointer returned may differ from the
+ * original if reallocation occurs.
+ *
+ * Example:
+ * ```c
+ * arr = array_insert(int, arr, 0, 42); // prepend
+ * ```
+ *
+ * @tparam T  The element type.
+ * @param p   Pointer to the array.
+ * @param idx Position of the new element (0-based, at most the length).
+ * @param v   The value to insert.
+ * @return Updated pointer to the array data.
+ */
+#define array_insert(T, p, idx, v)          ((T *)__array_insert_n(p, idx, (T[]){ (v) }, 1))
+
+/**
+ * @brief Inserts `n` consecutive elements at a given position.
+ *
+ * The tail is shifted once, then the items are copied in. If `items` is `NULL`
+ * the new slots are left uninitialized for the caller to fill. `items` must
+ * not point into the array itself, since the array may be reallocated.
+ *
+ * Example:
+ * ```c
+ * int batch[3] = { 1, 2, 3 };
+ * arr = array_insert_n(int, arr, 2, batch, 3);
+ * ```
+ *
+ * @tparam T    The element type.
+ * @param p     Pointer to the array.
+ * @param idx   Position of the first new element.
+ * @param items Pointer to `n` elements to copy, or `NULL`.
+ * @param n     Number of elements to insert.
+ * @return Updated pointer to the array data.
+ */
+#define array_insert_n(T, p, idx, items, n) ((T *)__array_insert_n(p, idx, items, n))
+
+/**
+ * @brief Removes the element at a given position, preserving order.
+ *
+ * Example:
+ * ```c
+ * array_remove(arr, 3);
+ * ```
+ *
+ * @param p   Pointer to the array.
+ * @param idx Index of the element to remove.
+ */
+#define array_remove(p, idx)                (__array_remove(p, idx))
+
+/**
+ * @brief Removes the elements in `[lower, upper)`, preserving order.
+ *
+ * The tail is moved down with a single `memmove`.
+ *
+ * Example:
+ * ```c
+ * array_remove_range(arr, 10, 20); // drops 10 elements
+ * ```
+ *
+ * @param p     Pointer to the array.
+ * @param lower Index of the first element to remove (inclusive).
+ * @param upper Index one past the last element to remove (exclusive).
+ */
+#define array_remove_range(p, lower, upper) (__array_remove_range(p, lower, upper))
+
+/**
+ * @brief Removes an element in O(1) by moving the last element into its slot.
+ *
+ * Order is not preserved. Like `array_pop`, the removed value is returned.
+ *
+ * Example:
+ * ```c
+ * Entity dead = array_swap_remove(Entity, entities, i);
+ * ```
+ *
+ * @tparam T  The element type.
+ * @param p   Pointer to the array.
+ * @param idx Index of the element to remove.
+ * @return The element that was removed.
+ */
+#define array_swap_remove(T, p, idx)        (*((T *)__array_swap_remove(p, idx)))
+
+/**
+ * @brief Shrinks the logical length of the array, keeping its capacity.
+ *
+ * Example:
+ * ```c
+ * array_truncate(arr, 10); // keep the first 10 elements
+ * ```
+ *
+ * @param p      Pointer to the array.
+ * @param length New length, at most the current one.
+ */
+#define array_truncate(p, length)           (__array_truncate(p, length))
+
+/**
+ * @brief Grows the capacity of the array to at least `capacity` elements.
+ *
+ * Allocates exactly the requested capacity (no rounding up), so later appends
+ * and inserts up to that many elements never reallocate. Does nothing if the
+ * array is already large enough; the length is unchanged.
+ *
+ * Example:
+ * ```c
+ * arr = array_reserve(int, arr, 1000);
+ * ```
+ *
+ * @tparam T       The element type.
+ * @param p        Pointer to the array.
+ * @param capacity Number of elements the array must be able to hold.
+ * @return The array, possibly moved.
+ */
+#define array_reserve(T, p, capacity)       ((T *)__array_reserve(p, capacity))
+
+/**
+ * @brief Returns the number of elements the array can hold without reallocating.
+ *
+ * @param p Pointer to the array.
+ * @return The capacity.
+ */
+#define array_capacity(p)                   (__array_capacity(p))
+
+/**
+ * @brief Removes every element for which `cond` holds, preserving order.
+ *
+ * Single pass stable compaction: each element is bound to the name `x`, written
+ * to the next output slot unconditionally, and the output cursor only advances
+ * when `cond` is false. Because the predicate is an inline expression and the
+ * loop has no branches on the data, compilers can vectorize it for primitive
+ * element types.
+ *
+ * Example:
+ * ```c
+ * array_remove_if(int, arr, x, x < 0);        // drop negatives
+ * array_remove_if(Row, rows, r, r.deleted);
+ * ```
+ *
+ * @tparam T  The element type.
+ * @param p   Pointer to the array.
+ * @param x   Name bound to the current element inside `cond`.
+ * @param cond Expression using `x`; elements for which it is true are removed.
+ */
+#define array_remove_if(T, p, x, cond) \
+    do { \
+        T *__arr = (p); \
+        size_t __len = array_length(__arr), __out = 0; \
+        for(size_t __i = 0; __i < __len; ++__i) { \
+            T x = __arr[__i]; \
+            __arr[__out] = x; \
+            __out += !(cond); \
+        } \
+        __array_truncate(__arr, __out); \
+    } while(0)
+
+/**
+ * @brief Sorts the array in place using a comparison function.
+ *
+ * Uses pattern-defeating quicksort (introsort-like, O(n log n) worst case) and
+ * switches to a multi-threaded merge sort once the array holds more than
+ * `__ARRAY_PARALLEL_SORT_THRESHOLD` elements. If scheduler.h is included
+ * before the array.h implementation, the merge sort runs on the shared
+ * work-stealing scheduler instead of starting its own threads. The comparator
+ * has the same contract as the one passed to `qsort`. The sort is not stable.
+ *
+ * Example:
+ * ```c
+ * int cmp_int(const void *a, const void *b) {
+ *     return (*(int *)a > *(int *)b) - (*(int *)a < *(int *)b);
+ * }
+ * array_sort(arr, cmp_int);
+ * ```
+ *
+ * @param p   Pointer to the array.
+ * @param cmp Comparison function returning <0, 0 or >0.
+ */
+#define array_sort(p, cmp)          (__array_sort(p, cmp))
+
+#define __ARRAY_KEY_UNSIGNED        0
+#define __ARRAY_KEY_SIGNED          1
+#define __ARRAY_KEY_FLOAT           2
+
+#define __array_key_kind(T) \
+    _Generic((T)0, float: __ARRAY_KEY_FLOAT, double: __ARRAY_KEY_FLOAT, \
+             default: (((T)-1 < (T)1) ? __ARRAY_KEY_SIGNED : __ARRAY_KEY_UNSIGNED))
+
+/**
+ * @brief Sorts an array of integers or floats in ascending order using LSD radix sort.
+ *
+ * Runs in O(n) for 1, 2, 4 and 8 byte integer types as well as `float` and `double`.
+ * Byte positions on which every key agrees are skipped, so narrow value ranges
+ * only pay for the passes they need. Negative zero sorts before positive zero.
+ *
+ * Example:
+ * ```c
+ * Array(int32_t) ids = array_create(int32_t);
+ * // ...
+ * array_radix_sort(int32_t, ids);
+ * ```
+ *
+ * @tparam T The arithmetic element type.
+ * @param p  Pointer to the array.
+ */
+#define array_radix_sort(T, p)      (__array_radix_sort(p, __array_key_kind(T)))
+
+/**
+ * @brief Index value returned by search functions when no element matches.
+ */
+#define ARRAY_NPOS                  ((size_t)-1)
+
+/**
+ * @brief Returns the index of the first element equal to a value.
+ *
+ * Works directly on the array data. For 4 and 8 byte integers, `float` and
+ * `double` the scan uses SSE2 or, when the CPU supports it, AVX2 (selected at
+ * runtime); other element types use a scalar loop. Floats compare with `==`,
+ * so `NAN` is never found and `-0.0` matches `0.0`.
+ *
+ * Example:
+ * ```c
+ * size_t idx = array_find(int32_t, ids, 42);
+ * if (idx != ARRAY_NPOS) { ... }
+ * ```
+ *
+ * @tparam T The arithmetic element type.
+ * @param p  Pointer to the array.
+ * @param v  Value to search for.
+ * @return Index of the first match, or `ARRAY_NPOS`.
+ */
+#define array_find(T, p, v)         (__array_find(p, (T[]){ (v) }, __array_key_kind(T)))
+
+/**
+ * @brief Counts the elements equal to a value.
+ *
+ * Uses the same vectorized kernels as `array_find`.
+ *
+ * Example:
+ * ```c
+ * size_t zeros = array_count(float, weights, 0.0f);
+ * ```
+ *
+ * @tparam T The arithmetic element type.
+ * @param p  Pointer to the array.
+ * @param v  Value to count.
+ * @return Number of matching elements.
+ */
+#define array_count(T, p, v)        (__array_count(p, (T[]){ (v) }, __array_key_kind(T)))
+
+/**
+ * @brief Checks whether the array contains a value.
+ *
+ * Example:
+ * ```c
+ * if (array_contains(uint64_t, seen, id)) { ... }
+ * ```
+ *
+ * @tparam T The arithmetic element type.
+ * @param p  Pointer to the array.
+ * @param v  Value to search for.
+ * @return `true` if at least one element equals `v`.
+ */
+#define array_contains(T, p, v)     (array_find(T, p, v) != ARRAY_NPOS)
+
+/**
+ * @brief Returns the smallest element of a non-empty array.
+ *
+ * When several elements are equal to the minimum, the first one is returned.
+ * The result is unspecified if a floating-point array contains `NAN`.
+ *
+ * Example:
+ * ```c
+ * int32_t lo = array_min(int32_t, arr);
+ * ```
+ *
+ * @tparam T The arithmetic element type.
+ * @param p  Pointer to the array.
+ * @return The minimum element.
+ */
+#define array_min(T, p)             (*((T *)__array_min(p, __array_key_kind(T))))
+
+/**
+ * @brief Returns the largest element of a non-empty array.
+ *
+ * See `array_min` for tie and `NAN` handling.
+ *
+ * Example:
+ * ```c
+ * float hi = array_max(float, arr);
+ * ```
+ *
+ * @tparam T The arithmetic element type.
+ * @param p  Pointer to the array.
+ * @return The maximum element.
+ */
+#define array_max(T, p)             (*((T *)__array_max(p, __array_key_kind(T))))
+
+/**
+ * @brief Sums all elements of the array.
+ *
+ * Integers are accumulated in 64 bits and returned as `int64_t` (wrapping on
+ * overflow; cast to `uint64_t` for unsigned sums). `float` and `double` are
+ * accumulated in double precision and returned as `double`; the summation
+ * order is not sequential, so the last bits may differ from a plain loop.
+ *
+ * Example:
+ * ```c
+ * int64_t total = array_sum(int32_t, arr);
+ * double  mass  = array_sum(float, weights);
+ * ```
+ *
+ * @tparam T The arithmetic element type.
+ * @param p  Pointer to the array.
+ * @return The sum of the elements.
+ */
+#define array_sum(T, p) \
+    _Generic((T)0, float: __array_sum_float(p), double: __array_sum_float(p), \
+             default: __array_sum_int(p, __array_key_kind(T)))
+
+/**
+ * @brief Returns the index of the first element not less than a value.
+ *
+ * The array must be sorted in ascending order. The search is branchless: each
+ * step halves the range with a conditional move, so the loop runs exactly
+ * ceil(log2(n)) iterations regardless of the data and never mispredicts.
+ *
+ * Example:
+ * ```c
+ * size_t i = array_lower_bound(uint64_t, ids, id);
+ * bool found = i < array_length(ids) && ids[i] == id;
+ * ```
+ *
+ * @tparam T The arithmetic element type.
+ * @param p  Pointer to the sorted array.
+ * @param v  Value to search for.
+ * @return Index of the first element `>= v`, or `array_length(p)` if none.
+ */
+#define array_lower_bound(T, p, v)  (__array_lower_bound(p, (T[]){ (v) }, __array_key_kind(T)))
+
+/**
+ * @brief Returns the index of the first element greater than a value.
+ *
+ * Branchless counterpart of `array_lower_bound`.
+ *
+ * Example:
+ * ```c
+ * size_t dups = array_upper_bound(int, arr, 7) - array_lower_bound(int, arr, 7);
+ * ```
+ *
+ * @tparam T The arithmetic element type.
+ * @param p  Pointer to the sorted array.
+ * @param v  Value to search for.
+ * @return Index of the first element `> v`, or `array_length(p)` if none.
+ */
+#define array_upper_bound(T, p, v)  (__array_upper_bound(p, (T[]){ (v) }, __array_key_kind(T)))
+
+/**
+ * @brief Builds an Eytzinger (BFS-ordered) copy of a sorted array.
+ *
+ * Element `k` of the result has its children at `2k + 1` and `2k + 2`, so the
+ * first levels of every search share a few cache lines and the nodes of the
+ * next levels can be prefetched. Search the result with
+ * `array_eytzinger_lower_bound`. The source array is left untouched; the
+ * returned array must be destroyed with `array_destroy`.
+ *
+ * Example:
+ * ```c
+ * Array(uint32_t) tree = array_eytzinger_build(uint32_t, sorted_ids);
+ * ```
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the sorted array.
+ * @return A new array holding the same elements in Eytzinger order.
+ */
+#define array_eytzinger_build(T, p) ((T *)__array_eytzinger_build(p))
+
+/**
+ * @brief Lower bound search on an array built by `array_eytzinger_build`.
+ *
+ * Example:
+ * ```c
+ * size_t i = array_eytzinger_lower_bound(uint32_t, tree, id);
+ * if (i != ARRAY_NPOS && tree[i] == id) { ... }
+ * ```
+ *
+ * @tparam T The arithmetic element type.
+ * @param p  Pointer to the Eytzinger-ordered array.
+ * @param v  Value to search for.
+ * @return Index (in `p`) of the smallest element `>= v`, or `ARRAY_NPOS`.
+ */
+#define array_eytzinger_lower_bound(T, p, v) \
+    (__array_eytzinger_lower_bound(p, (T[]){ (v) }, __array_key_kind(T)))
+
 #ifdef COLLECTIONS_ARRAY_IMPLEMENTATION
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define __ARRAY_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define __ARRAY_SIMD_X86 0
+#endif
 
 #define __ARRAY_INITIAL_CAPACITY 10
 
+/**
+ * Allocation hooks for array storage. Define all three before including the
+ * implementation to route arrays through another allocator. Every call passes
+ * the exact block size, so sized allocators such as pool.h can be plugged in:
+ *
+ * ```c
+ * #define ARRAY_MALLOC(size)                   pool_alloc(size)
+ * #define ARRAY_REALLOC(p, old_size, new_size) pool_realloc(p, old_size, new_size)
+ * #define ARRAY_FREE(p, size)                  pool_free(p, size)
+ * #define COLLECTIONS_ARRAY_IMPLEMENTATION
+ * #include "array.h"
+ * ```
+ */
+#ifndef ARRAY_MALLOC
+#define ARRAY_MALLOC(size)                      malloc(size)
+#define ARRAY_REALLOC(p, old_size, new_size)    realloc(p, new_size)
+#define ARRAY_FREE(p, size)                     free(p)
+#endif
+
+#define __array_block_size__(item_size, cap)    (sizeof(ArrayHeader) + (cap) * (item_size))
+
+#define __ARRAY_INSERTION_SORT_THRESHOLD    24
+#define __ARRAY_NINTHER_THRESHOLD           128
+#define __ARRAY_PARTIAL_INSERTION_LIMIT     8
+#define __ARRAY_PARALLEL_SORT_THRESHOLD     (1 << 17)
+#define __ARRAY_PARALLEL_MERGE_THRESHOLD    (1 << 14)
+#define __ARRAY_SORT_MAX_THREADS            64
+
 typedef struct {
     size_t  length;
     size_t  cap;
@@ -165,8 +633,39 @@ typedef struct {
  */
 #define arrheader(p) ((ArrayHeader *)(p) - 1)
 
+static inline void __array_copy__(char *dst, const char *src, size_t size) {
+    switch(size) {
+        case 4:  memcpy(dst, src, 4);    break;
+        case 8:  memcpy(dst, src, 8);    break;
+        case 16: memcpy(dst, src, 16);   break;
+        default: memcpy(dst, src, size); break;
+    }
+}
+
+static inline void __array_swap__(char *a, char *b, size_t size) {
+    if(size == 4) {
+        uint32_t t; memcpy(&t, a, 4); memcpy(a, b, 4); memcpy(b, &t, 4);
+        return;
+    }
+    if(size == 8) {
+        uint64_t t; memcpy(&t, a, 8); memcpy(a, b, 8); memcpy(b, &t, 8);
+        return;
+    }
+
+    char tmp[64];
+    while(size > 0) {
+        size_t chunk = size < sizeof(tmp) ? size : sizeof(tmp);
+        memcpy(tmp, a, chunk);
+        memcpy(a, b, chunk);
+        memcpy(b, tmp, chunk);
+        a += chunk;
+        b += chunk;
+        size -= chunk;
+    }
+}
+
 void *__array_create(size_t item_size) {
-    void **p = malloc(sizeof(ArrayHeader) + __ARRAY_INITIAL_CAPACITY * item_size);
+    void **p = ARRAY_MALLOC(__array_block_size__(item_size, __ARRAY_INITIAL_CAPACITY));
     if(!p) {
         fprintf(stderr, "__array_create failed: cannot allocate memory.\n");
         exit(EXIT_FAILURE);
@@ -191,7 +690,8 @@ void *__array_append(void *arr) {
 
     header->cap *= 2;
     
-    void *p = realloc(header, sizeof(ArrayHeader) + header->cap * header->item_size);
+    void *p = ARRAY_REALLOC(header, __array_block_size__(header->item_size, header->cap / 2),
+                                    __array_block_size__(header->item_size, header->cap));
     if(!p) {
         fprintf(stderr, "__array_append: cannot resize array.\n");
         exit(EXIT_FAILURE);
@@ -238,7 +738,1275 @@ size_t __array_length(void *arr) {
 
 void __array_destroy(void *arr) {
     ArrayHeader *header = arrheader(arr);
-    free(header);
+    ARRAY_FREE(header, __array_block_size__(header->item_size, header->cap));
+}
+
+static void *__array_grow__(void *arr, size_t extra, const char *fn) {
+    ArrayHeader *header = arrheader(arr);
+    size_t need = header->length + extra;
+    if(need <= header->cap) return arr;
+
+    size_t cap = header->cap > 0 ? header->cap : 1;
+    while(cap < need) cap *= 2;
+
+    void *p = ARRAY_REALLOC(header, __array_block_size__(header->item_size, header->cap),
+                                    __array_block_size__(header->item_size, cap));
+    if(!p) {
+        fprintf(stderr, "%s failed: cannot resize array.\n", fn);
+        exit(EXIT_FAILURE);
+    }
+
+    header = (ArrayHeader *)p;
+    header->cap = cap;
+    return (void *)(header + 1);
+}
+
+void *__array_insert_n(void *arr, size_t idx, const void *items, size_t count) {
+    if(idx > arrheader(arr)->length) {
+        fprintf(stderr, "__array_insert_n failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    arr = __array_grow__(arr, count, "__array_insert_n");
+    ArrayHeader *header = arrheader(arr);
+    size_t size = header->item_size;
+
+    char *at = (char *)arr + idx * size;
+    memmove(at + count * size, at, (header->length - idx) * size);
+    if(items) memcpy(at, items, count * size);
+
+    header->length += count;
+    return arr;
+}
+
+void __array_remove_range(void *arr, size_t lower, size_t upper) {
+    ArrayHeader *header = arrheader(arr);
+    if(lower > upper || upper > header->length) {
+        fprintf(stderr, "__array_remove_range failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t size = header->item_size;
+    char *at = (char *)arr + lower * size;
+    memmove(at, (char *)arr + upper * size, (header->length - upper) * size);
+    header->length -= upper - lower;
+}
+
+void __array_remove(void *arr, size_t idx) {
+    if(idx >= arrheader(arr)->length) {
+        fprintf(stderr, "__array_remove failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+    __array_remove_range(arr, idx, idx + 1);
+}
+
+void *__array_swap_remove(void *arr, size_t idx) {
+    ArrayHeader *header = arrheader(arr);
+    if(idx >= header->length) {
+        fprintf(stderr, "__array_swap_remove failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Swap rather than overwrite so the removed item stays readable past the
+    // new end, exactly like the slot returned by __array_pop.
+    header->length -= 1;
+    char *last = (char *)arr + header->item_size * header->length;
+    char *item = (char *)arr + header->item_size * idx;
+    if(item != last) __array_swap__(item, last, header->item_size);
+    return last;
+}
+
+void __array_truncate(void *arr, size_t length) {
+    ArrayHeader *header = arrheader(arr);
+    if(length > header->length) {
+        fprintf(stderr, "__array_truncate failed: length exceeds array length.\n");
+        exit(EXIT_FAILURE);
+    }
+    header->length = length;
+}
+
+void *__array_reserve(void *arr, size_t capacity) {
+    ArrayHeader *header = arrheader(arr);
+    if(capacity <= header->cap) return arr;
+
+    void *p = ARRAY_REALLOC(header, __array_block_size__(header->item_size, header->cap),
+                                    __array_block_size__(header->item_size, capacity));
+    if(!p) {
+        fprintf(stderr, "__array_reserve failed: cannot resize array.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    header = (ArrayHeader *)p;
+    header->cap = capacity;
+    return (void *)(header + 1);
+}
+
+size_t __array_capacity(void *arr) {
+    return arrheader(arr)->cap;
+}
+
+/**
+ * @brief State shared by the sorting routines of a single `array_sort` call.
+ *
+ * Holds the comparator, the element size and two scratch slots of `size` bytes
+ * (one for the pivot, one for insertion sort) so the recursion never allocates.
+ */
+typedef struct {
+    size_t  size;
+    int     (*cmp)(const void *, const void *);
+    char    *pivot;
+    char    *tmp;
+} ArraySortContext;
+
+static inline void __array_sort2__(ArraySortContext *ctx, char *a, char *b) {
+    if(ctx->cmp(b, a) < 0) __array_swap__(a, b, ctx->size);
+}
+
+static inline void __array_sort3__(ArraySortContext *ctx, char *a, char *b, char *c) {
+    __array_sort2__(ctx, a, b);
+    __array_sort2__(ctx, b, c);
+    __array_sort2__(ctx, a, b);
+}
+
+static void __array_insertion_sort__(ArraySortContext *ctx, char *begin, char *end) {
+    size_t size = ctx->size;
+    if(begin == end) return;
+
+    for(char *cur = begin + size; cur < end; cur += size) {
+        char *sift = cur;
+        if(ctx->cmp(sift, sift - size) >= 0) continue;
+
+        __array_copy__(ctx->tmp, sift, size);
+        do {
+            __array_copy__(sift, sift - size, size);
+            sift -= size;
+        } while(sift != begin && ctx->cmp(ctx->tmp, sift - size) < 0);
+        __array_copy__(sift, ctx->tmp, size);
+    }
+}
+
+// Insertion sort that gives up after __ARRAY_PARTIAL_INSERTION_LIMIT moves.
+// Returns true if the range ended up sorted.
+static bool __array_partial_insertion_sort__(ArraySortContext *ctx, char *begin, char *end) {
+    size_t size  = ctx->size;
+    size_t moves = 0;
+    if(begin == end) return true;
+
+    for(char *cur = begin + size; cur < end; cur += size) {
+        char *sift = cur;
+        if(ctx->cmp(sift, sift - size) >= 0) continue;
+
+        __array_copy__(ctx->tmp, sift, size);
+        do {
+            __array_copy__(sift, sift - size, size);
+            sift -= size;
+        } while(sift != begin && ctx->cmp(ctx->tmp, sift - size) < 0);
+        __array_copy__(sift, ctx->tmp, size);
+
+        moves += (size_t)(cur - sift) / size;
+        if(moves > __ARRAY_PARTIAL_INSERTION_LIMIT) return false;
+    }
+
+    return true;
+}
+
+static void __array_sift_down__(ArraySortContext *ctx, char *base, size_t root, size_t n) {
+    size_t size = ctx->size;
+    for(;;) {
+        size_t child = 2 * root + 1;
+        if(child >= n) return;
+        if(child + 1 < n && ctx->cmp(base + child * size, base + (child + 1) * size) < 0) child += 1;
+        if(ctx->cmp(base + root * size, base + child * size) >= 0) return;
+        __array_swap__(base + root * size, base + child * size, size);
+        root = child;
+    }
+}
+
+static void __array_heap_sort__(ArraySortContext *ctx, char *begin, char *end) {
+    size_t size = ctx->size;
+    size_t n    = (size_t)(end - begin) / size;
+
+    for(size_t i = n / 2; i-- > 0;) __array_sift_down__(ctx, begin, i, n);
+    for(size_t i = n; i-- > 1;) {
+        __array_swap__(begin, begin + i * size, size);
+        __array_sift_down__(ctx, begin, 0, i);
+    }
+}
+
+// Partitions [begin, end) around the pivot at *begin, putting elements equal
+// to the pivot on the right. Sets *already_partitioned when no swap was needed.
+static char *__array_partition_right__(ArraySortContext *ctx, char *begin, char *end, bool *already_partitioned) {
+    size_t size = ctx->size;
+    __array_copy__(ctx->pivot, begin, size);
+
+    char *first = begin;
+    char *last  = end;
+
+    // The median selection guarantees an element >= pivot exists, so this
+    // scan needs no bound check.
+    do { first += size; } while(ctx->cmp(first, ctx->pivot) < 0);
+
+    if(first - size == begin) {
+        do { last -= size; } while(first < last && ctx->cmp(last, ctx->pivot) >= 0);
+    } else {
+        do { last -= size; } while(ctx->cmp(last, ctx->pivot) >= 0);
+    }
+
+    *already_partitioned = first >= last;
+
+    while(first < last) {
+        __array_swap__(first, last, size);
+        do { first += size; } while(ctx->cmp(first, ctx->pivot) < 0);
+        do { last -= size; } while(ctx->cmp(last, ctx->pivot) >= 0);
+    }
+
+    char *pivot_pos = first - size;
+    __array_copy__(begin, pivot_pos, size);
+    __array_copy__(pivot_pos, ctx->pivot, size);
+    return pivot_pos;
+}
+
+// Partitions [begin, end) putting elements equal to the pivot on the left.
+// Used when the pivot equals its left neighbour, so runs of equal keys are
+// consumed in a single step.
+static char *__array_partition_left__(ArraySortContext *ctx, char *begin, char *end) {
+    size_t size = ctx->size;
+    __array_copy__(ctx->pivot, begin, size);
+
+    char *first = begin;
+    char *last  = end;
+
+    do { last -= size; } while(ctx->cmp(ctx->pivot, last) < 0);
+
+    if(last + size == end) {
+        do { first += size; } while(first < last && ctx->cmp(ctx->pivot, first) >= 0);
+    } else {
+        do { first += size; } while(ctx->cmp(ctx->pivot, first) >= 0);
+    }
+
+    while(first < last) {
+        __array_swap__(first, last, size);
+        do { last -= size; } while(ctx->cmp(ctx->pivot, last) < 0);
+        do { first += size; } while(ctx->cmp(ctx->pivot, first) >= 0);
+    }
+
+    __array_copy__(begin, last, size);
+    __array_copy__(last, ctx->pivot, size);
+    return last;
+}
+
+static void __array_pdqsort__(ArraySortContext *ctx, char *begin, char *end, int bad_allowed, bool leftmost) {
+    size_t size = ctx->size;
+
+    for(;;) {
+        size_t n = (size_t)(end - begin) / size;
+        if(n < __ARRAY_INSERTION_SORT_THRESHOLD) {
+            __array_insertion_sort__(ctx, begin, end);
+            return;
+        }
+
+        size_t s2 = n / 2;
+        if(n > __ARRAY_NINTHER_THRESHOLD) {
+            __array_sort3__(ctx, begin, begin + s2 * size, end - size);
+            __array_sort3__(ctx, begin + size, begin + (s2 - 1) * size, end - 2 * size);
+            __array_sort3__(ctx, begin + 2 * size, begin + (s2 + 1) * size, end - 3 * size);
+            __array_sort3__(ctx, begin + (s2 - 1) * size, begin + s2 * size, begin + (s2 + 1) * size);
+            __array_swap__(begin, begin + s2 * size, size);
+        } else {
+            __array_sort3__(ctx, begin + s2 * size, begin, end - size);
+        }
+
+        if(!leftmost && ctx->cmp(begin - size, begin) >= 0) {
+            begin = __array_partition_left__(ctx, begin, end) + size;
+            continue;
+        }
+
+        bool already_partitioned;
+        char *pivot_pos = __array_partition_right__(ctx, begin, end, &already_partitioned);
+
+        size_t l_size = (size_t)(pivot_pos - begin) / size;
+        size_t r_size = (size_t)(end - (pivot_pos + size)) / size;
+
+        if(l_size < n / 8 || r_size < n / 8) {
+            if(--bad_allowed == 0) {
+                __array_heap_sort__(ctx, begin, end);
+                return;
+            }
+
+            // Break up the pattern that produced the bad pivot.
+            if(l_size >= __ARRAY_INSERTION_SORT_THRESHOLD) {
+                __array_swap__(begin, begin + (l_size / 4) * size, size);
+                __array_swap__(pivot_pos - size, pivot_pos - (l_size / 4) * size, size);
+                if(l_size > __ARRAY_NINTHER_THRESHOLD) {
+                    __array_swap__(begin + size, begin + (l_size / 4 + 1) * size, size);
+                    __array_swap__(begin + 2 * size, begin + (l_size / 4 + 2) * size, size);
+                    __array_swap__(pivot_pos - 2 * size, pivot_pos - (l_size / 4 + 1) * size, size);
+                    __array_swap__(pivot_pos - 3 * size, pivot_pos - (l_size / 4 + 2) * size, size);
+                }
+            }
+
+            if(r_size >= __ARRAY_INSERTION_SORT_THRESHOLD) {
+                __array_swap__(pivot_pos + size, pivot_pos + (1 + r_size / 4) * size, size);
+                __array_swap__(end - size, end - (r_size / 4) * size, size);
+                if(r_size > __ARRAY_NINTHER_THRESHOLD) {
+                    __array_swap__(pivot_pos + 2 * size, pivot_pos + (2 + r_size / 4) * size, size);
+                    __array_swap__(pivot_pos + 3 * size, pivot_pos + (3 + r_size / 4) * size, size);
+                    __array_swap__(end - 2 * size, end - (1 + r_size / 4) * size, size);
+                    __array_swap__(end - 3 * size, end - (2 + r_size / 4) * size, size);
+                }
+            }
+        } else if(already_partitioned
+               && __array_partial_insertion_sort__(ctx, begin, pivot_pos)
+               && __array_partial_insertion_sort__(ctx, pivot_pos + size, end)) {
+            return;
+        }
+
+        __array_pdqsort__(ctx, begin, pivot_pos, bad_allowed, leftmost);
+        begin    = pivot_pos + size;
+        leftmost = false;
+    }
+}
+
+static void __array_sort_range__(char *base, size_t n, size_t size, int (*cmp)(const void *, const void *)) {
+    if(n < 2) return;
+
+    char *scratch = malloc(2 * size);
+    if(!scratch) {
+        fprintf(stderr, "__array_sort failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    ArraySortContext ctx = {
+        .size  = size,
+        .cmp   = cmp,
+        .pivot = scratch,
+        .tmp   = scratch + size,
+    };
+
+    int bad_allowed = 0;
+    for(size_t m = n; m > 1; m >>= 1) bad_allowed += 1;
+
+    __array_pdqsort__(&ctx, base, base + n * size, bad_allowed, true);
+    free(scratch);
+}
+
+/**
+ * @brief One unit of work of the parallel merge sort.
+ *
+ * Sorts `n` elements at `base` (using `tmp` as merge buffer) or merges the
+ * sorted runs `a` and `b` into `dst`, splitting itself across `depth` more
+ * levels of threads.
+ */
+typedef struct {
+    char    *base;
+    char    *tmp;
+    size_t  n;
+    char    *a;
+    size_t  na;
+    char    *b;
+    size_t  nb;
+    char    *dst;
+    size_t  size;
+    int     depth;
+    int     (*cmp)(const void *, const void *);
+} ArraySortTask;
+
+static void __array_merge__(ArraySortTask *t) {
+    char *a = t->a, *a_end = t->a + t->na * t->size;
+    char *b = t->b, *b_end = t->b + t->nb * t->size;
+    char *dst = t->dst;
+
+    while(a < a_end && b < b_end) {
+        if(t->cmp(b, a) < 0) {
+            __array_copy__(dst, b, t->size);
+            b += t->size;
+        } else {
+            __array_copy__(dst, a, t->size);
+            a += t->size;
+        }
+        dst += t->size;
+    }
+
+    memcpy(dst, a, (size_t)(a_end - a));
+    dst += a_end - a;
+    memcpy(dst, b, (size_t)(b_end - b));
+}
+
+#ifdef COLLECTIONS_SCHEDULER_H
+/**
+ * @brief Adapts a sort task to the `void (*)(void *)` tasks of scheduler.h.
+ */
+typedef struct {
+    void    *(*fn)(void *);
+    void    *arg;
+} ArrayForkTask;
+
+static void __array_fork_task__(void *arg) {
+    ArrayForkTask *task = arg;
+    task->fn(task->arg);
+}
+
+// Runs fn(left) and fn(right) on the shared work-stealing scheduler.
+static void __array_fork_join__(void *(*fn)(void *), void *left, void *right) {
+    ArrayForkTask a = { fn, left }, b = { fn, right };
+    scheduler_join(__array_fork_task__, &a, __array_fork_task__, &b);
+}
+#else
+// Runs fn(left) on a new thread and fn(right) on this one, then waits for both.
+static void __array_fork_join__(void *(*fn)(void *), void *left, void *right) {
+    pthread_t thread;
+    bool spawned = pthread_create(&thread, NULL, fn, left) == 0;
+    if(!spawned) fn(left);
+    fn(right);
+    if(spawned) pthread_join(thread, NULL);
+}
+#endif
+
+static void *__array_parallel_merge__(void *arg) {
+    ArraySortTask *t = arg;
+
+    if(t->depth <= 0 || t->na + t->nb < __ARRAY_PARALLEL_MERGE_THRESHOLD) {
+        __array_merge__(t);
+        return NULL;
+    }
+
+    // Split the longer run in half and binary search the split point in the
+    // other run, so both halves of the output can be produced independently.
+    bool swap = t->na < t->nb;
+    char   *x = swap ? t->b : t->a, *y = swap ? t->a : t->b;
+    size_t nx = swap ? t->nb : t->na, ny = swap ? t->na : t->nb;
+
+    size_t mx = nx / 2;
+    size_t lo = 0, hi = ny;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(t->cmp(y + mid * t->size, x + mx * t->size) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    size_t my = lo;
+
+    ArraySortTask left = *t, right = *t;
+    left.a  = x;                    left.na  = mx;
+    left.b  = y;                    left.nb  = my;
+    right.a = x + mx * t->size;     right.na = nx - mx;
+    right.b = y + my * t->size;     right.nb = ny - my;
+    right.dst = t->dst + (mx + my) * t->size;
+    left.depth = right.depth = t->depth - 1;
+
+    __array_fork_join__(__array_parallel_merge__, &left, &right);
+
+    return NULL;
+}
+
+static void *__array_parallel_sort__(void *arg) {
+    ArraySortTask *t = arg;
+
+    if(t->depth <= 0 || t->n < __ARRAY_PARALLEL_MERGE_THRESHOLD) {
+        __array_sort_range__(t->base, t->n, t->size, t->cmp);
+        return NULL;
+    }
+
+    size_t half = t->n / 2;
+    ArraySortTask left = *t, right = *t;
+    left.n       = half;
+    right.base   = t->base + half * t->size;
+    right.tmp    = t->tmp + half * t->size;
+    right.n      = t->n - half;
+    left.depth   = right.depth = t->depth - 1;
+
+    __array_fork_join__(__array_parallel_sort__, &left, &right);
+
+    ArraySortTask merge = *t;
+    merge.a   = t->base;            merge.na = half;
+    merge.b   = right.base;         merge.nb = right.n;
+    merge.dst = t->tmp;
+    __array_parallel_merge__(&merge);
+
+    memcpy(t->base, t->tmp, t->n * t->size);
+    return NULL;
+}
+
+void __array_sort(void *arr, int (*cmp)(const void *, const void *)) {
+    ArrayHeader *header = arrheader(arr);
+    size_t n    = header->length;
+    size_t size = header->item_size;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if(n < __ARRAY_PARALLEL_SORT_THRESHOLD || cpus < 2) {
+        __array_sort_range__(arr, n, size, cmp);
+        return;
+    }
+
+    int depth = 0;
+    while((1L << depth) < cpus && (1L << depth) < __ARRAY_SORT_MAX_THREADS) depth += 1;
+
+    char *tmp = malloc(n * size);
+    if(!tmp) {
+        // Not enough memory for the merge buffer: sort in place instead.
+        __array_sort_range__(arr, n, size, cmp);
+        return;
+    }
+
+    ArraySortTask task = {
+        .base  = arr,
+        .tmp   = tmp,
+        .n     = n,
+        .size  = size,
+        .depth = depth,
+        .cmp   = cmp,
+    };
+    __array_parallel_sort__(&task);
+
+    free(tmp);
+}
+
+// Radix sort on unsigned keys of a fixed width, one byte per pass. Passes on
+// which every key has the same byte are skipped.
+#define __ARRAY_RADIX_SORT_DEFINE__(BITS)                                                   \
+static void __array_radix_sort_u##BITS##__(uint##BITS##_t *keys, uint##BITS##_t *tmp, size_t n) { \
+    enum { BYTES = BITS / 8 };                                                              \
+    size_t counts[BYTES][256];                                                              \
+    memset(counts, 0, sizeof(counts));                                                      \
+                                                                                            \
+    for(size_t i = 0; i < n; ++i) {                                                         \
+        uint##BITS##_t key = keys[i];                                                       \
+        for(size_t b = 0; b < BYTES; ++b) counts[b][(key >> (8 * b)) & 0xff] += 1;          \
+    }                                                                                       \
+                                                                                            \
+    uint##BITS##_t *src = keys, *dst = tmp;                                                 \
+    for(size_t b = 0; b < BYTES; ++b) {                                                     \
+        size_t *count = counts[b];                                                          \
+        if(count[(src[0] >> (8 * b)) & 0xff] == n) continue;                                \
+                                                                                            \
+        size_t offset = 0;                                                                  \
+        for(size_t d = 0; d < 256; ++d) {                                                   \
+            size_t c = count[d];                                                            \
+            count[d] = offset;                                                              \
+            offset += c;                                                                    \
+        }                                                                                   \
+                                                                                            \
+        for(size_t i = 0; i < n; ++i) {                                                     \
+            uint##BITS##_t key = src[i];                                                    \
+            dst[count[(key >> (8 * b)) & 0xff]++] = key;                                    \
+        }                                                                                   \
+                                                                                            \
+        uint##BITS##_t *swap = src; src = dst; dst = swap;                                  \
+    }                                                                                       \
+                                                                                            \
+    if(src != keys) memcpy(keys, src, n * sizeof(*keys));                                   \
+}                                                                                           \
+                                                                                            \
+static void __array_radix_sort_kind_u##BITS##__(uint##BITS##_t *keys, size_t n, int kind) { \
+    const uint##BITS##_t sign = (uint##BITS##_t)1 << (BITS - 1);                            \
+                                                                                            \
+    /* Map the keys to unsigned integers with the same ordering. */                          \
+    if(kind == __ARRAY_KEY_SIGNED) {                                                        \
+        for(size_t i = 0; i < n; ++i) keys[i] ^= sign;                                      \
+    } else if(kind == __ARRAY_KEY_FLOAT) {                                                  \
+        for(size_t i = 0; i < n; ++i) {                                                     \
+            uint##BITS##_t mask = (keys[i] & sign) ? (uint##BITS##_t)~(uint##BITS##_t)0 : sign; \
+            keys[i] ^= mask;                                                                \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    if(n < __ARRAY_INSERTION_SORT_THRESHOLD) {                                              \
+        for(size_t i = 1; i < n; ++i) {                                                     \
+            uint##BITS##_t key = keys[i];                                                   \
+            size_t j = i;                                                                   \
+            for(; j > 0 && keys[j - 1] > key; --j) keys[j] = keys[j - 1];                   \
+            keys[j] = key;                                                                  \
+        }                                                                                   \
+    } else {                                                                                \
+        uint##BITS##_t *tmp = malloc(n * sizeof(*keys));                                    \
+        if(!tmp) {                                                                          \
+            fprintf(stderr, "__array_radix_sort failed: cannot allocate memory.\n");        \
+            exit(EXIT_FAILURE);                                                             \
+        }                                                                                   \
+        __array_radix_sort_u##BITS##__(keys, tmp, n);                                       \
+        free(tmp);                                                                          \
+    }                                                                                       \
+                                                                                            \
+    if(kind == __ARRAY_KEY_SIGNED) {                                                        \
+        for(size_t i = 0; i < n; ++i) keys[i] ^= sign;                                      \
+    } else if(kind == __ARRAY_KEY_FLOAT) {                                                  \
+        for(size_t i = 0; i < n; ++i) {                                                     \
+            uint##BITS##_t mask = (keys[i] & sign) ? sign : (uint##BITS##_t)~(uint##BITS##_t)0; \
+            keys[i] ^= mask;                                                                \
+        }                                                                                   \
+    }                                                                                       \
+}
+
+__ARRAY_RADIX_SORT_DEFINE__(8)
+__ARRAY_RADIX_SORT_DEFINE__(16)
+__ARRAY_RADIX_SORT_DEFINE__(32)
+__ARRAY_RADIX_SORT_DEFINE__(64)
+
+void __array_radix_sort(void *arr, int kind) {
+    ArrayHeader *header = arrheader(arr);
+    size_t n = header->length;
+    if(n < 2) return;
+
+    switch(header->item_size) {
+        case 1: __array_radix_sort_kind_u8__(arr, n, kind);  break;
+        case 2: __array_radix_sort_kind_u16__(arr, n, kind); break;
+        case 4: __array_radix_sort_kind_u32__(arr, n, kind); break;
+        case 8: __array_radix_sort_kind_u64__(arr, n, kind); break;
+        default:
+            fprintf(stderr, "__array_radix_sort failed: unsupported item size %zu.\n", header->item_size);
+            exit(EXIT_FAILURE);
+    }
+}
+
+// Scalar scan kernels, used on non-x86 targets, for 1 and 2 byte elements,
+// and for the tails the vector loops leave over.
+#define __ARRAY_SCAN_SCALAR_DEFINE__(NAME, T, ACC)                                          \
+static inline size_t __array_find_##NAME##_scalar__(const T *data, size_t n, T value) {    \
+    for(size_t i = 0; i < n; ++i) if(data[i] == value) return i;                            \
+    return ARRAY_NPOS;                                                                      \
+}                                                                                           \
+                                                                                            \
+static inline size_t __array_count_##NAME##_scalar__(const T *data, size_t n, T value) {   \
+    size_t count = 0;                                                                       \
+    for(size_t i = 0; i < n; ++i) count += data[i] == value;                                \
+    return count;                                                                           \
+}                                                                                           \
+                                                                                            \
+static inline size_t __array_min_##NAME##_scalar__(const T *data, size_t n) {              \
+    size_t best = 0;                                                                        \
+    for(size_t i = 1; i < n; ++i) if(data[i] < data[best]) best = i;                        \
+    return best;                                                                            \
+}                                                                                           \
+                                                                                            \
+static inline size_t __array_max_##NAME##_scalar__(const T *data, size_t n) {              \
+    size_t best = 0;                                                                        \
+    for(size_t i = 1; i < n; ++i) if(data[i] > data[best]) best = i;                        \
+    return best;                                                                            \
+}                                                                                           \
+                                                                                            \
+static inline ACC __array_sum_##NAME##_scalar__(const T *data, size_t n) {                 \
+    ACC sum = 0;                                                                            \
+    for(size_t i = 0; i < n; ++i) sum += (ACC)data[i];                                      \
+    return sum;                                                                             \
+}
+
+__ARRAY_SCAN_SCALAR_DEFINE__(i8,  int8_t,   int64_t)
+__ARRAY_SCAN_SCALAR_DEFINE__(u8,  uint8_t,  uint64_t)
+__ARRAY_SCAN_SCALAR_DEFINE__(i16, int16_t,  int64_t)
+__ARRAY_SCAN_SCALAR_DEFINE__(u16, uint16_t, uint64_t)
+__ARRAY_SCAN_SCALAR_DEFINE__(i32, int32_t,  int64_t)
+__ARRAY_SCAN_SCALAR_DEFINE__(u32, uint32_t, uint64_t)
+__ARRAY_SCAN_SCALAR_DEFINE__(i64, int64_t,  int64_t)
+__ARRAY_SCAN_SCALAR_DEFINE__(u64, uint64_t, uint64_t)
+__ARRAY_SCAN_SCALAR_DEFINE__(f32, float,    double)
+__ARRAY_SCAN_SCALAR_DEFINE__(f64, double,   double)
+
+#if __ARRAY_SIMD_X86
+
+static inline bool __array_has_avx2__(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+// Equality masks: compare one vector of elements against the broadcast
+// needle and return one bit per lane.
+
+static inline int __array_eq_u32_sse2__(const uint32_t *p, __m128i needle) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, needle)));
+}
+
+static inline int __array_eq_u64_sse2__(const uint64_t *p, __m128i needle) {
+    __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)p), needle);
+    eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_movemask_pd(_mm_castsi128_pd(eq));
+}
+
+static inline int __array_eq_f32_sse2__(const float *p, __m128 needle) {
+    return _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(p), needle));
+}
+
+static inline int __array_eq_f64_sse2__(const double *p, __m128d needle) {
+    return _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(p), needle));
+}
+
+__attribute__((target("avx2")))
+static inline int __array_eq_u32_avx2__(const uint32_t *p, __m256i needle) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, needle)));
+}
+
+__attribute__((target("avx2")))
+static inline int __array_eq_u64_avx2__(const uint64_t *p, __m256i needle) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, needle)));
+}
+
+__attribute__((target("avx2")))
+static inline int __array_eq_f32_avx2__(const float *p, __m256 needle) {
+    return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(p), needle, _CMP_EQ_OQ));
+}
+
+__attribute__((target("avx2")))
+static inline int __array_eq_f64_avx2__(const double *p, __m256d needle) {
+    return _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(p), needle, _CMP_EQ_OQ));
+}
+
+// Find and count loops over an equality mask. Find checks four vectors per
+// iteration and only resolves the lane once one of them matched.
+#define __ARRAY_SIMD_EQ_DEFINE__(NAME, T, ISA, TARGET, LANES, NEEDLE_T, SET1)                \
+__attribute__((target(TARGET)))                                                             \
+static size_t __array_find_##NAME##_##ISA##__(const T *data, size_t n, T value) {          \
+    const NEEDLE_T needle = SET1(value);                                                    \
+    size_t i = 0;                                                                           \
+    for(; i + 4 * LANES <= n; i += 4 * LANES) {                                             \
+        int any = __array_eq_##NAME##_##ISA##__(data + i, needle)                           \
+                | __array_eq_##NAME##_##ISA##__(data + i + LANES, needle)                   \
+                | __array_eq_##NAME##_##ISA##__(data + i + 2 * LANES, needle)               \
+                | __array_eq_##NAME##_##ISA##__(data + i + 3 * LANES, needle);              \
+        if(any) break;                                                                      \
+    }                                                                                       \
+    for(; i + LANES <= n; i += LANES) {                                                     \
+        int mask = __array_eq_##NAME##_##ISA##__(data + i, needle);                         \
+        if(mask) return i + (size_t)__builtin_ctz((unsigned)mask);                          \
+    }                                                                                       \
+    size_t tail = __array_find_##NAME##_scalar__(data + i, n - i, value);                   \
+    return tail == ARRAY_NPOS ? ARRAY_NPOS : i + tail;                                      \
+}                                                                                           \
+                                                                                            \
+__attribute__((target(TARGET)))                                                             \
+static size_t __array_count_##NAME##_##ISA##__(const T *data, size_t n, T value) {         \
+    const NEEDLE_T needle = SET1(value);                                                    \
+    size_t count = 0, i = 0;                                                                \
+    for(; i + LANES <= n; i += LANES) {                                                     \
+        count += (size_t)__builtin_popcount((unsigned)__array_eq_##NAME##_##ISA##__(data + i, needle)); \
+    }                                                                                       \
+    return count + __array_count_##NAME##_scalar__(data + i, n - i, value);                 \
+}
+
+#define __array_set1_u32_sse2__(v)  _mm_set1_epi32((int)(v))
+#define __array_set1_u64_sse2__(v)  _mm_set1_epi64x((long long)(v))
+#define __array_set1_u32_avx2__(v)  _mm256_set1_epi32((int)(v))
+#define __array_set1_u64_avx2__(v)  _mm256_set1_epi64x((long long)(v))
+
+__ARRAY_SIMD_EQ_DEFINE__(u32, uint32_t, sse2, "sse2", 4, __m128i, __array_set1_u32_sse2__)
+__ARRAY_SIMD_EQ_DEFINE__(u64, uint64_t, sse2, "sse2", 2, __m128i, __array_set1_u64_sse2__)
+__ARRAY_SIMD_EQ_DEFINE__(f32, float,    sse2, "sse2", 4, __m128,  _mm_set1_ps)
+__ARRAY_SIMD_EQ_DEFINE__(f64, double,   sse2, "sse2", 2, __m128d, _mm_set1_pd)
+__ARRAY_SIMD_EQ_DEFINE__(u32, uint32_t, avx2, "avx2,popcnt", 8, __m256i, __array_set1_u32_avx2__)
+__ARRAY_SIMD_EQ_DEFINE__(u64, uint64_t, avx2, "avx2,popcnt", 4, __m256i, __array_set1_u64_avx2__)
+__ARRAY_SIMD_EQ_DEFINE__(f32, float,    avx2, "avx2,popcnt", 8, __m256,  _mm256_set1_ps)
+__ARRAY_SIMD_EQ_DEFINE__(f64, double,   avx2, "avx2,popcnt", 4, __m256d, _mm256_set1_pd)
+
+// Lane-wise min/max. SSE2 lacks 32-bit integer min/max and AVX2 lacks the
+// 64-bit ones, so those are built from a compare and a blend. Unsigned
+// lanes are biased by the sign bit and compared as signed.
+
+static inline __m128i __array_blend_sse2__(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i __array_vmin_i32_sse2__(__m128i a, __m128i b) { return __array_blend_sse2__(_mm_cmplt_epi32(a, b), a, b); }
+static inline __m128i __array_vmax_i32_sse2__(__m128i a, __m128i b) { return __array_blend_sse2__(_mm_cmpgt_epi32(a, b), a, b); }
+
+static inline __m128i __array_vmin_u32_sse2__(__m128i a, __m128i b) {
+    const __m128i bias = _mm_set1_epi32(INT32_MIN);
+    return __array_blend_sse2__(_mm_cmplt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias)), a, b);
+}
+
+static inline __m128i __array_vmax_u32_sse2__(__m128i a, __m128i b) {
+    const __m128i bias = _mm_set1_epi32(INT32_MIN);
+    return __array_blend_sse2__(_mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias)), a, b);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i __array_vmin_i64_avx2__(__m256i a, __m256i b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+
+__attribute__((target("avx2")))
+static inline __m256i __array_vmax_i64_avx2__(__m256i a, __m256i b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+
+__attribute__((target("avx2")))
+static inline __m256i __array_vmin_u64_avx2__(__m256i a, __m256i b) {
+    const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i __array_vmax_u64_avx2__(__m256i a, __m256i b) {
+    const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+    return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias)));
+}
+
+#define __array_loadu_si128__(p)        _mm_loadu_si128((const __m128i *)(p))
+#define __array_storeu_si128__(p, v)    _mm_storeu_si128((__m128i *)(p), v)
+#define __array_loadu_si256__(p)        _mm256_loadu_si256((const __m256i *)(p))
+#define __array_storeu_si256__(p, v)    _mm256_storeu_si256((__m256i *)(p), v)
+
+// Reduces the array to its extreme value with two vector accumulators, then
+// locates the first element holding it. Returns the index of that element.
+#define __ARRAY_SIMD_MINMAX_DEFINE__(OP, NAME, T, ISA, TARGET, VEC, LANES, LOAD, STORE, VOP)  \
+__attribute__((target(TARGET)))                                                             \
+static size_t __array_##OP##_##NAME##_##ISA##__(const T *data, size_t n) {                 \
+    if(n < 2 * LANES) return __array_##OP##_##NAME##_scalar__(data, n);                     \
+                                                                                            \
+    VEC acc0 = LOAD(data), acc1 = LOAD(data + LANES);                                       \
+    size_t i = 2 * LANES;                                                                   \
+    for(; i + 2 * LANES <= n; i += 2 * LANES) {                                             \
+        acc0 = VOP(acc0, LOAD(data + i));                                                   \
+        acc1 = VOP(acc1, LOAD(data + i + LANES));                                           \
+    }                                                                                       \
+    acc0 = VOP(acc0, acc1);                                                                 \
+                                                                                            \
+    T lanes[LANES + 2 * LANES];                                                             \
+    STORE(lanes, acc0);                                                                     \
+    size_t rest = n - i;                                                                    \
+    for(size_t j = 0; j < rest; ++j) lanes[LANES + j] = data[i + j];                        \
+    T best = lanes[__array_##OP##_##NAME##_scalar__(lanes, LANES + rest)];                  \
+                                                                                            \
+    size_t idx = __array_find_##NAME##_scalar__(data, n, best);                             \
+    return idx == ARRAY_NPOS ? __array_##OP##_##NAME##_scalar__(data, n) : idx;             \
+}
+
+__ARRAY_SIMD_MINMAX_DEFINE__(min, i32, int32_t,  sse2, "sse2", __m128i, 4, __array_loadu_si128__, __array_storeu_si128__, __array_vmin_i32_sse2__)
+__ARRAY_SIMD_MINMAX_DEFINE__(max, i32, int32_t,  sse2, "sse2", __m128i, 4, __array_loadu_si128__, __array_storeu_si128__, __array_vmax_i32_sse2__)
+__ARRAY_SIMD_MINMAX_DEFINE__(min, u32, uint32_t, sse2, "sse2", __m128i, 4, __array_loadu_si128__, __array_storeu_si128__, __array_vmin_u32_sse2__)
+__ARRAY_SIMD_MINMAX_DEFINE__(max, u32, uint32_t, sse2, "sse2", __m128i, 4, __array_loadu_si128__, __array_storeu_si128__, __array_vmax_u32_sse2__)
+__ARRAY_SIMD_MINMAX_DEFINE__(min, f32, float,    sse2, "sse2", __m128,  4, _mm_loadu_ps, _mm_storeu_ps, _mm_min_ps)
+__ARRAY_SIMD_MINMAX_DEFINE__(max, f32, float,    sse2, "sse2", __m128,  4, _mm_loadu_ps, _mm_storeu_ps, _mm_max_ps)
+__ARRAY_SIMD_MINMAX_DEFINE__(min, f64, double,   sse2, "sse2", __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_min_pd)
+__ARRAY_SIMD_MINMAX_DEFINE__(max, f64, double,   sse2, "sse2", __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_max_pd)
+
+__ARRAY_SIMD_MINMAX_DEFINE__(min, i32, int32_t,  avx2, "avx2", __m256i, 8, __array_loadu_si256__, __array_storeu_si256__, _mm256_min_epi32)
+__ARRAY_SIMD_MINMAX_DEFINE__(max, i32, int32_t,  avx2, "avx2", __m256i, 8, __array_loadu_si256__, __array_storeu_si256__, _mm256_max_epi32)
+__ARRAY_SIMD_MINMAX_DEFINE__(min, u32, uint32_t, avx2, "avx2", __m256i, 8, __array_loadu_si256__, __array_storeu_si256__, _mm256_min_epu32)
+__ARRAY_SIMD_MINMAX_DEFINE__(max, u32, uint32_t, avx2, "avx2", __m256i, 8, __array_loadu_si256__, __array_storeu_si256__, _mm256_max_epu32)
+__ARRAY_SIMD_MINMAX_DEFINE__(min, i64, int64_t,  avx2, "avx2", __m256i, 4, __array_loadu_si256__, __array_storeu_si256__, __array_vmin_i64_avx2__)
+__ARRAY_SIMD_MINMAX_DEFINE__(max, i64, int64_t,  avx2, "avx2", __m256i, 4, __array_loadu_si256__, __array_storeu_si256__, __array_vmax_i64_avx2__)
+__ARRAY_SIMD_MINMAX_DEFINE__(min, u64, uint64_t, avx2, "avx2", __m256i, 4, __array_loadu_si256__, __array_storeu_si256__, __array_vmin_u64_avx2__)
+__ARRAY_SIMD_MINMAX_DEFINE__(max, u64, uint64_t, avx2, "avx2", __m256i, 4, __array_loadu_si256__, __array_storeu_si256__, __array_vmax_u64_avx2__)
+__ARRAY_SIMD_MINMAX_DEFINE__(min, f32, float,    avx2, "avx2", __m256,  8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_min_ps)
+__ARRAY_SIMD_MINMAX_DEFINE__(max, f32, float,    avx2, "avx2", __m256,  8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_max_ps)
+__ARRAY_SIMD_MINMAX_DEFINE__(min, f64, double,   avx2, "avx2", __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_min_pd)
+__ARRAY_SIMD_MINMAX_DEFINE__(max, f64, double,   avx2, "avx2", __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_max_pd)
+
+// Sums. 32-bit lanes are widened to 64 bits before accumulating so large
+// arrays do not overflow, and floats are accumulated in double precision.
+
+static uint64_t __array_sum_u32_sse2__(const uint32_t *data, size_t n, bool sign) {
+    __m128i acc = _mm_setzero_si128();
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        __m128i v   = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i ext = sign ? _mm_cmpgt_epi32(zero, v) : zero;
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, ext));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, ext));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    uint64_t sum = lanes[0] + lanes[1];
+    for(; i < n; ++i) sum += sign ? (uint64_t)(int64_t)(int32_t)data[i] : (uint64_t)data[i];
+    return sum;
+}
+
+static uint64_t __array_sum_u64_sse2__(const uint64_t *data, size_t n) {
+    __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_epi64(acc0, _mm_loadu_si128((const __m128i *)(data + i)));
+        acc1 = _mm_add_epi64(acc1, _mm_loadu_si128((const __m128i *)(data + i + 2)));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(acc0, acc1));
+    uint64_t sum = lanes[0] + lanes[1];
+    for(; i < n; ++i) sum += data[i];
+    return sum;
+}
+
+static double __array_sum_f32_sse2__(const float *data, size_t n) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(data + i);
+        acc0 = _mm_add_pd(acc0, _mm_cvtps_pd(v));
+        acc1 = _mm_add_pd(acc1, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    double sum = lanes[0] + lanes[1];
+    for(; i < n; ++i) sum += data[i];
+    return sum;
+}
+
+static double __array_sum_f64_sse2__(const double *data, size_t n) {
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(data + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(data + i + 2));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    double sum = lanes[0] + lanes[1];
+    for(; i < n; ++i) sum += data[i];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static uint64_t __array_sum_u32_avx2__(const uint32_t *data, size_t n, bool sign) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(data + i + 4));
+        if(sign) {
+            acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(lo));
+            acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(hi));
+        } else {
+            acc0 = _mm256_add_epi64(acc0, _mm256_cvtepu32_epi64(lo));
+            acc1 = _mm256_add_epi64(acc1, _mm256_cvtepu32_epi64(hi));
+        }
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(acc0, acc1));
+    uint64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for(; i < n; ++i) sum += sign ? (uint64_t)(int64_t)(int32_t)data[i] : (uint64_t)data[i];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static uint64_t __array_sum_u64_avx2__(const uint64_t *data, size_t n) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256((const __m256i *)(data + i)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256((const __m256i *)(data + i + 4)));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(acc0, acc1));
+    uint64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for(; i < n; ++i) sum += data[i];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static double __array_sum_f32_avx2__(const float *data, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm_loadu_ps(data + i)));
+        acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm_loadu_ps(data + i + 4)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    double sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for(; i < n; ++i) sum += data[i];
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static double __array_sum_f64_avx2__(const double *data, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + i + 4));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    double sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for(; i < n; ++i) sum += data[i];
+    return sum;
+}
+
+#define __ARRAY_SCAN_DISPATCH__(FN, NAME, ...) \
+    (__array_has_avx2__() ? __array_##FN##_##NAME##_avx2__(__VA_ARGS__) : __array_##FN##_##NAME##_sse2__(__VA_ARGS__))
+
+#else
+
+#define __ARRAY_SCAN_DISPATCH__(FN, NAME, ...) (__array_##FN##_##NAME##_scalar__(__VA_ARGS__))
+
+#endif // __ARRAY_SIMD_X86
+
+// 64-bit integer min/max only have an AVX2 kernel.
+#if __ARRAY_SIMD_X86
+#define __ARRAY_SCAN_DISPATCH_AVX2__(FN, NAME, ...) \
+    (__array_has_avx2__() ? __array_##FN##_##NAME##_avx2__(__VA_ARGS__) : __array_##FN##_##NAME##_scalar__(__VA_ARGS__))
+#else
+#define __ARRAY_SCAN_DISPATCH_AVX2__(FN, NAME, ...) (__array_##FN##_##NAME##_scalar__(__VA_ARGS__))
+#endif
+
+#define __ARRAY_SCAN_UNSUPPORTED__(fn, item_size) \
+    do { \
+        fprintf(stderr, fn " failed: unsupported item size %zu.\n", (size_t)(item_size)); \
+        exit(EXIT_FAILURE); \
+    } while(0)
+
+size_t __array_find_n(const void *data, size_t n, size_t item_size, const void *value, int kind) {
+    if(kind == __ARRAY_KEY_FLOAT) {
+        if(item_size == 4) return __ARRAY_SCAN_DISPATCH__(find, f32, data, n, *(const float *)value);
+        if(item_size == 8) return __ARRAY_SCAN_DISPATCH__(find, f64, data, n, *(const double *)value);
+        __ARRAY_SCAN_UNSUPPORTED__("__array_find", item_size);
+    }
+
+    // Integer equality does not depend on signedness, so compare the bits.
+    switch(item_size) {
+        case 1: return __array_find_u8_scalar__(data, n, *(const uint8_t *)value);
+        case 2: return __array_find_u16_scalar__(data, n, *(const uint16_t *)value);
+        case 4: return __ARRAY_SCAN_DISPATCH__(find, u32, data, n, *(const uint32_t *)value);
+        case 8: return __ARRAY_SCAN_DISPATCH__(find, u64, data, n, *(const uint64_t *)value);
+        default: __ARRAY_SCAN_UNSUPPORTED__("__array_find", item_size);
+    }
+}
+
+size_t __array_find(void *arr, const void *value, int kind) {
+    return __array_find_n(arr, arrheader(arr)->length, arrheader(arr)->item_size, value, kind);
+}
+
+size_t __array_count_n(const void *data, size_t n, size_t item_size, const void *value, int kind) {
+    if(kind == __ARRAY_KEY_FLOAT) {
+        if(item_size == 4) return __ARRAY_SCAN_DISPATCH__(count, f32, data, n, *(const float *)value);
+        if(item_size == 8) return __ARRAY_SCAN_DISPATCH__(count, f64, data, n, *(const double *)value);
+        __ARRAY_SCAN_UNSUPPORTED__("__array_count", item_size);
+    }
+
+    switch(item_size) {
+        case 1: return __array_count_u8_scalar__(data, n, *(const uint8_t *)value);
+        case 2: return __array_count_u16_scalar__(data, n, *(const uint16_t *)value);
+        case 4: return __ARRAY_SCAN_DISPATCH__(count, u32, data, n, *(const uint32_t *)value);
+        case 8: return __ARRAY_SCAN_DISPATCH__(count, u64, data, n, *(const uint64_t *)value);
+        default: __ARRAY_SCAN_UNSUPPORTED__("__array_count", item_size);
+    }
+}
+
+size_t __array_count(void *arr, const void *value, int kind) {
+    return __array_count_n(arr, arrheader(arr)->length, arrheader(arr)->item_size, value, kind);
+}
+
+static size_t __array_extreme_index__(const void *data, size_t n, size_t item_size, int kind, bool max) {
+    if(n == 0) {
+        fprintf(stderr, "%s failed: array is empty.\n", max ? "__array_max" : "__array_min");
+        exit(EXIT_FAILURE);
+    }
+
+    bool sign = kind == __ARRAY_KEY_SIGNED;
+    switch(kind == __ARRAY_KEY_FLOAT ? item_size * 10 : item_size) {
+        case 1:  return sign ? (max ? __array_max_i8_scalar__(data, n)  : __array_min_i8_scalar__(data, n))
+                             : (max ? __array_max_u8_scalar__(data, n)  : __array_min_u8_scalar__(data, n));
+        case 2:  return sign ? (max ? __array_max_i16_scalar__(data, n) : __array_min_i16_scalar__(data, n))
+                             : (max ? __array_max_u16_scalar__(data, n) : __array_min_u16_scalar__(data, n));
+        case 4:  return sign ? (max ? __ARRAY_SCAN_DISPATCH__(max, i32, data, n) : __ARRAY_SCAN_DISPATCH__(min, i32, data, n))
+                             : (max ? __ARRAY_SCAN_DISPATCH__(max, u32, data, n) : __ARRAY_SCAN_DISPATCH__(min, u32, data, n));
+        case 8:  return sign ? (max ? __ARRAY_SCAN_DISPATCH_AVX2__(max, i64, data, n) : __ARRAY_SCAN_DISPATCH_AVX2__(min, i64, data, n))
+                             : (max ? __ARRAY_SCAN_DISPATCH_AVX2__(max, u64, data, n) : __ARRAY_SCAN_DISPATCH_AVX2__(min, u64, data, n));
+        case 40: return max ? __ARRAY_SCAN_DISPATCH__(max, f32, data, n) : __ARRAY_SCAN_DISPATCH__(min, f32, data, n);
+        case 80: return max ? __ARRAY_SCAN_DISPATCH__(max, f64, data, n) : __ARRAY_SCAN_DISPATCH__(min, f64, data, n);
+        default: __ARRAY_SCAN_UNSUPPORTED__(max ? "__array_max" : "__array_min", item_size);
+    }
+}
+
+size_t __array_min_n(const void *data, size_t n, size_t item_size, int kind) {
+    return __array_extreme_index__(data, n, item_size, kind, false);
+}
+
+size_t __array_max_n(const void *data, size_t n, size_t item_size, int kind) {
+    return __array_extreme_index__(data, n, item_size, kind, true);
+}
+
+void *__array_min(void *arr, int kind) {
+    ArrayHeader *header = arrheader(arr);
+    size_t idx = __array_min_n(arr, header->length, header->item_size, kind);
+    return (char *)arr + header->item_size * idx;
+}
+
+void *__array_max(void *arr, int kind) {
+    ArrayHeader *header = arrheader(arr);
+    size_t idx = __array_max_n(arr, header->length, header->item_size, kind);
+    return (char *)arr + header->item_size * idx;
+}
+
+int64_t __array_sum_int_n(const void *data, size_t n, size_t item_size, int kind) {
+    bool sign = kind == __ARRAY_KEY_SIGNED;
+
+    switch(item_size) {
+        case 1:  return sign ? __array_sum_i8_scalar__(data, n)  : (int64_t)__array_sum_u8_scalar__(data, n);
+        case 2:  return sign ? __array_sum_i16_scalar__(data, n) : (int64_t)__array_sum_u16_scalar__(data, n);
+#if __ARRAY_SIMD_X86
+        case 4:  return (int64_t)__ARRAY_SCAN_DISPATCH__(sum, u32, data, n, sign);
+        case 8:  return (int64_t)__ARRAY_SCAN_DISPATCH__(sum, u64, data, n);
+#else
+        case 4:  return sign ? __array_sum_i32_scalar__(data, n) : (int64_t)__array_sum_u32_scalar__(data, n);
+        case 8:  return (int64_t)__array_sum_u64_scalar__(data, n);
+#endif
+        default: __ARRAY_SCAN_UNSUPPORTED__("__array_sum", item_size);
+    }
+}
+
+double __array_sum_float_n(const void *data, size_t n, size_t item_size) {
+    switch(item_size) {
+        case 4:  return __ARRAY_SCAN_DISPATCH__(sum, f32, data, n);
+        case 8:  return __ARRAY_SCAN_DISPATCH__(sum, f64, data, n);
+        default: __ARRAY_SCAN_UNSUPPORTED__("__array_sum", item_size);
+    }
+}
+
+int64_t __array_sum_int(void *arr, int kind) {
+    return __array_sum_int_n(arr, arrheader(arr)->length, arrheader(arr)->item_size, kind);
+}
+
+double __array_sum_float(void *arr) {
+    return __array_sum_float_n(arr, arrheader(arr)->length, arrheader(arr)->item_size);
+}
+
+static void *__array_alloc__(size_t item_size, size_t cap) {
+    ArrayHeader *header = ARRAY_MALLOC(__array_block_size__(item_size, cap));
+    if(!header) {
+        fprintf(stderr, "__array_alloc__ failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    header->item_size = item_size;
+    header->cap       = cap;
+    header->length    = 0;
+    return (void *)(header + 1);
+}
+
+typedef size_t (*ArraySearchFn)(const void *data, size_t n, const void *value);
+
+/**
+ * @brief Search kernels specialized for one arithmetic element type.
+ */
+typedef struct {
+    ArraySearchFn   lower_bound;
+    ArraySearchFn   upper_bound;
+    ArraySearchFn   eytzinger_lower_bound;
+} ArraySearchKernels;
+
+// Number of levels below node k whose descendants share one 64-byte line,
+// used to prefetch the Eytzinger nodes visited four steps ahead.
+#define __array_eytzinger_prefetch_shift__(size) \
+    ((size) <= 4 ? 4 : (size) <= 8 ? 3 : (size) <= 16 ? 2 : 1)
+
+// The search loops keep a base pointer and a remaining length instead of a
+// [lo, hi) pair, so the only data-dependent step is a conditional move.
+#define __ARRAY_SEARCH_DEFINE__(NAME, T)                                                    \
+static size_t __array_lower_bound_##NAME##__(const void *data, size_t n, const void *value) { \
+    const T *arr = data, *base = data;                                                      \
+    const T x = *(const T *)value;                                                          \
+    if(n == 0) return 0;                                                                    \
+    while(n > 1) {                                                                          \
+        size_t half = n / 2;                                                                \
+        __builtin_prefetch(base + half / 2);                                                \
+        __builtin_prefetch(base + half + half / 2);                                         \
+        base = (base[half] < x) ? base + half : base;                                       \
+        n -= half;                                                                          \
+    }                                                                                       \
+    return (size_t)(base - arr) + (*base < x);                                              \
+}                                                                                           \
+                                                                                            \
+static size_t __array_upper_bound_##NAME##__(const void *data, size_t n, const void *value) { \
+    const T *arr = data, *base = data;                                                      \
+    const T x = *(const T *)value;                                                          \
+    if(n == 0) return 0;                                                                    \
+    while(n > 1) {                                                                          \
+        size_t half = n / 2;                                                                \
+        __builtin_prefetch(base + half / 2);                                                \
+        __builtin_prefetch(base + half + half / 2);                                         \
+        base = (x < base[half]) ? base : base + half;                                       \
+        n -= half;                                                                          \
+    }                                                                                       \
+    return (size_t)(base - arr) + !(x < *base);                                             \
+}                                                                                           \
+                                                                                            \
+static size_t __array_eytzinger_lower_bound_##NAME##__(const void *data, size_t n, const void *value) { \
+    const T *arr = data;                                                                    \
+    const T x = *(const T *)value;                                                          \
+    const unsigned shift = __array_eytzinger_prefetch_shift__(sizeof(T));                   \
+    size_t k = 1;                                                                           \
+    while(k <= n) {                                                                         \
+        __builtin_prefetch((const char *)arr + ((k << shift) - 1) * sizeof(T));             \
+        k = 2 * k + (arr[k - 1] < x);                                                       \
+    }                                                                                       \
+    /* Drop the trailing right turns plus the last left turn. */                            \
+    k >>= __builtin_ffsll((long long)~k);                                                   \
+    return k == 0 ? ARRAY_NPOS : k - 1;                                                     \
+}                                                                                           \
+                                                                                            \
+static const ArraySearchKernels __array_search_kernels_##NAME##__ = {                      \
+    __array_lower_bound_##NAME##__,                                                         \
+    __array_upper_bound_##NAME##__,                                                         \
+    __array_eytzinger_lower_bound_##NAME##__,                                               \
+};
+
+__ARRAY_SEARCH_DEFINE__(i8,  int8_t)
+__ARRAY_SEARCH_DEFINE__(u8,  uint8_t)
+__ARRAY_SEARCH_DEFINE__(i16, int16_t)
+__ARRAY_SEARCH_DEFINE__(u16, uint16_t)
+__ARRAY_SEARCH_DEFINE__(i32, int32_t)
+__ARRAY_SEARCH_DEFINE__(u32, uint32_t)
+__ARRAY_SEARCH_DEFINE__(i64, int64_t)
+__ARRAY_SEARCH_DEFINE__(u64, uint64_t)
+__ARRAY_SEARCH_DEFINE__(f32, float)
+__ARRAY_SEARCH_DEFINE__(f64, double)
+
+static const ArraySearchKernels *__array_search_kernels__(size_t item_size, int kind, const char *fn) {
+    bool sign = kind == __ARRAY_KEY_SIGNED;
+
+    if(kind == __ARRAY_KEY_FLOAT) {
+        if(item_size == 4) return &__array_search_kernels_f32__;
+        if(item_size == 8) return &__array_search_kernels_f64__;
+    } else {
+        switch(item_size) {
+            case 1: return sign ? &__array_search_kernels_i8__  : &__array_search_kernels_u8__;
+            case 2: return sign ? &__array_search_kernels_i16__ : &__array_search_kernels_u16__;
+            case 4: return sign ? &__array_search_kernels_i32__ : &__array_search_kernels_u32__;
+            case 8: return sign ? &__array_search_kernels_i64__ : &__array_search_kernels_u64__;
+        }
+    }
+
+    fprintf(stderr, "%s failed: unsupported item size %zu.\n", fn, item_size);
+    exit(EXIT_FAILURE);
+}
+
+size_t __array_lower_bound_n(const void *data, size_t n, size_t item_size, const void *value, int kind) {
+    return __array_search_kernels__(item_size, kind, "__array_lower_bound")->lower_bound(data, n, value);
+}
+
+size_t __array_upper_bound_n(const void *data, size_t n, size_t item_size, const void *value, int kind) {
+    return __array_search_kernels__(item_size, kind, "__array_upper_bound")->upper_bound(data, n, value);
+}
+
+size_t __array_lower_bound(void *arr, const void *value, int kind) {
+    return __array_lower_bound_n(arr, arrheader(arr)->length, arrheader(arr)->item_size, value, kind);
+}
+
+size_t __array_upper_bound(void *arr, const void *value, int kind) {
+    return __array_upper_bound_n(arr, arrheader(arr)->length, arrheader(arr)->item_size, value, kind);
+}
+
+size_t __array_eytzinger_lower_bound(void *arr, const void *value, int kind) {
+    const ArraySearchKernels *k = __array_search_kernels__(arrheader(arr)->item_size, kind, "__array_eytzinger_lower_bound");
+    return k->eytzinger_lower_bound(arr, arrheader(arr)->length, value);
+}
+
+// In-order walk of the implicit tree rooted at node k (1-based), handing out
+// the sorted elements in order. Returns the next unconsumed sorted index.
+static size_t __array_eytzinger_fill__(const char *src, char *dst, size_t size, size_t n, size_t i, size_t k) {
+    while(k <= n) {
+        i = __array_eytzinger_fill__(src, dst, size, n, i, 2 * k);
+        memcpy(dst + (k - 1) * size, src + i * size, size);
+        i += 1;
+        k = 2 * k + 1;
+    }
+    return i;
+}
+
+void *__array_eytzinger_build(void *arr) {
+    ArrayHeader *header = arrheader(arr);
+    size_t n = header->length;
+
+    void *out = __array_alloc__(header->item_size, n > 0 ? n : 1);
+    __array_eytzinger_fill__(arr, out, header->item_size, n, 0, 1);
+    arrheader(out)->length = n;
+    return out;
 }
 
 #endif // COLLECTIONS_ARRAY_IMPLEMENTATION
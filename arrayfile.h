@@ -0,0 +1,335 @@
+#ifndef COLLECTIONS_ARRAYFILE_H
+#define COLLECTIONS_ARRAYFILE_H
+
+// The implementation uses fdopen, fchmod and fsync, which strict ISO modes
+// hide; include arrayfile.h first in the file that compiles it.
+#if defined(COLLECTIONS_ARRAYFILE_IMPLEMENTATION) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 700
+#endif
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+#include "av.h"
+
+/**
+ * @brief Flags for `array_map`.
+ *
+ * - `ARRAY_MAP_READONLY`: shared read-only mapping (the default).
+ * - `ARRAY_MAP_PRIVATE`: writable copy-on-write mapping; changes never reach the file.
+ * - `ARRAY_MAP_VERIFY`: recompute the checksum before returning. This reads
+ *   the whole file, so it costs time proportional to its size.
+ */
+#define ARRAY_MAP_READONLY  0
+#define ARRAY_MAP_PRIVATE   1
+#define ARRAY_MAP_VERIFY    2
+
+/**
+ * @brief A mapped array file: a view of its elements plus what is needed to unmap it.
+ */
+typedef struct {
+    ArrayView   view; /**< The elements, pointing straight into the mapping. */
+    void       *base; /**< Start of the mapping. */
+    size_t      size; /**< Length of the mapping in bytes. */
+} ArrayMapping;
+
+/**
+ * @brief Writes `length` elements of `item_size` bytes to an array file.
+ *
+ * The file starts with a 64-byte header (magic, item size, length, data
+ * offset, alignment, byte-order tag and a 64-bit checksum of the data),
+ * followed by the raw elements at a 64-byte aligned offset. The file is
+ * written under a unique temporary name next to `path`, flushed to disk and
+ * renamed over it, and the directory is flushed after the rename, so readers
+ * never see a partial file, even after a crash, and concurrent saves to one
+ * path do not mix. A replaced file keeps its permissions; a new one gets 0666
+ * less the umask. Elements are stored in native byte order.
+ *
+ * @param v Elements to save.
+ * @param path Destination file.
+ * @return true on success; false with `errno` set otherwise.
+ */
+bool av_save(ArrayView v, const char *path);
+
+/**
+ * @brief Maps an array file written by `array_save` or `av_save`.
+ *
+ * Nothing is read or copied up front: the header is validated and the
+ * elements are paged in by the kernel on first access, so opening a
+ * multi-gigabyte file takes about as long as opening a small one (unless
+ * `ARRAY_MAP_VERIFY` is passed).
+ *
+ * Example:
+ * ```c
+ * ArrayMapping m;
+ * if (!array_map("prices.arr", ARRAY_MAP_READONLY, &m)) perror("array_map");
+ * double total = av_sum(double, m.view);
+ * array_unmap(&m);
+ * ```
+ *
+ * @param path File to map.
+ * @param flags Combination of `ARRAY_MAP_*` flags.
+ * @param out Receives the mapping on success.
+ * @return true on success; false with `errno` set otherwise (`EINVAL` for
+ *         a malformed file or one whose data is not 64-byte aligned,
+ *         `EILSEQ` for a checksum mismatch).
+ */
+bool array_map(const char *path, int flags, ArrayMapping *out);
+
+/**
+ * @brief Unmaps a file mapped with `array_map`. Views into it become invalid.
+ *
+ * @param m Mapping to release.
+ */
+void array_unmap(ArrayMapping *m);
+
+/**
+ * @brief Saves an array.h array to an array file.
+ *
+ * Example:
+ * ```c
+ * if (!array_save(double, prices, "prices.arr")) perror("array_save");
+ * ```
+ *
+ * @tparam T The element type.
+ * @param p Pointer to the array.
+ * @param path Destination file.
+ * @return true on success.
+ */
+#define array_save(T, p, path)      (av_save(av_from_array(T, p), path))
+
+
+#ifdef COLLECTIONS_ARRAYFILE_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define __ARRAYFILE_MAGIC       "ARRFILE1"
+#define __ARRAYFILE_ALIGNMENT   64
+#define __ARRAYFILE_BYTE_ORDER  UINT32_C(0x01020304)
+
+/**
+ * @brief On-disk header, exactly `__ARRAYFILE_ALIGNMENT` bytes.
+ */
+typedef struct {
+    char        magic[8];
+    uint32_t    byte_order;
+    uint32_t    alignment;
+    uint64_t    item_size;
+    uint64_t    length;
+    uint64_t    data_offset;
+    uint64_t    checksum;
+    char        reserved[16];
+} ArrayFileHeader;
+
+_Static_assert(sizeof(ArrayFileHeader) == __ARRAYFILE_ALIGNMENT, "ArrayFileHeader must fill one alignment unit");
+
+static inline uint64_t __arrayfile_round__(uint64_t acc, uint64_t word) {
+    acc += word * UINT64_C(0xC2B2AE3D27D4EB4F);
+    acc  = (acc << 31) | (acc >> 33);
+    return acc * UINT64_C(0x9E3779B185EBCA87);
+}
+
+// Four independent lanes of xxHash64-style rounds over 8-byte words, so the
+// checksum runs near memory bandwidth. Not compatible with xxHash itself.
+static uint64_t __arrayfile_checksum__(const void *data, size_t size) {
+    const unsigned char *p = data;
+    uint64_t lanes[4] = { 1, 2, 3, 4 };
+
+    size_t i = 0;
+    for(; i + 32 <= size; i += 32) {
+        for(int k = 0; k < 4; ++k) {
+            uint64_t word;
+            memcpy(&word, p + i + 8 * k, 8);
+            lanes[k] = __arrayfile_round__(lanes[k], word);
+        }
+    }
+
+    uint64_t hash = (uint64_t)size;
+    for(int k = 0; k < 4; ++k) hash = __arrayfile_round__(hash, lanes[k]);
+    for(; i < size; ++i) hash = __arrayfile_round__(hash, p[i]);
+
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xFF51AFD7ED558CCD);
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * @brief Creates `<path>.XXXXXX` under a fresh unique name, ready to be renamed
+ *        over `path`. It takes the mode of the file it will replace, or 0666
+ *        less the umask when `path` does not exist yet.
+ *
+ * @param path Final name.
+ * @param tmp Buffer of `strlen(path) + 8` bytes; receives the temporary name.
+ * @return A write-only descriptor, or -1 with `errno` set.
+ */
+static int __arrayfile_create_tmp__(const char *path, char *tmp) {
+    static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    struct stat st;
+    bool replace = stat(path, &st) == 0;
+    size_t len   = strlen(path);
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".XXXXXX", sizeof(".XXXXXX"));
+
+    // O_EXCL makes the name unique; the seed only keeps collisions rare.
+    uint64_t seed = (uint64_t)(uintptr_t)tmp ^ ((uint64_t)getpid() << 32) ^ (uint64_t)time(NULL);
+    for(int attempt = 0; attempt < 100; attempt++) {
+        seed = seed * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+        uint64_t x = seed >> 16;
+        for(size_t i = 0; i < 6; i++, x /= 36) tmp[len + 1 + i] = digits[x % 36];
+
+        int fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, replace ? 0600 : 0666);
+        if(fd < 0 && errno == EEXIST) continue;
+        if(fd >= 0 && replace && fchmod(fd, st.st_mode & 07777) != 0) {
+            int err = errno;
+            close(fd);
+            remove(tmp);
+            errno = err;
+            return -1;
+        }
+        return fd;
+    }
+    errno = EEXIST;
+    return -1;
+}
+
+/**
+ * @brief Flushes the directory entry of `path` to disk, so a rename onto it
+ *        survives a crash.
+ *
+ * @return true on success, or when the file system cannot sync directories.
+ */
+static bool __arrayfile_sync_dir__(const char *path) {
+    const char *slash = strrchr(path, '/');
+    size_t len = slash ? (size_t)(slash - path) + (slash == path) : 1;
+    char *dir  = malloc(len + 1);
+    if(!dir) return false;
+    memcpy(dir, slash ? path : ".", len);
+    dir[len] = '\0';
+
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    int err = fd < 0 ? errno : 0;
+    if(fd >= 0 && fsync(fd) != 0 && errno != EINVAL) err = errno;
+    if(fd >= 0) close(fd);
+    free(dir);
+    errno = err;
+    return err == 0;
+}
+
+bool av_save(ArrayView v, const char *path) {
+    ArrayFileHeader header = { 0 };
+    memcpy(header.magic, __ARRAYFILE_MAGIC, sizeof(header.magic));
+    header.byte_order  = __ARRAYFILE_BYTE_ORDER;
+    header.alignment   = __ARRAYFILE_ALIGNMENT;
+    header.item_size   = v.item_size;
+    header.length      = v.length;
+    header.data_offset = sizeof(ArrayFileHeader);
+    header.checksum    = __arrayfile_checksum__(v.data, v.length * v.item_size);
+
+    // A unique name in the same directory, so the rename stays on one file system.
+    char *tmp = malloc(strlen(path) + sizeof(".XXXXXX"));
+    if(!tmp) return false;
+    int fd  = __arrayfile_create_tmp__(path, tmp);
+    FILE *f = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if(!f) {
+        int err = errno;
+        if(fd >= 0) {
+            close(fd);
+            remove(tmp);
+        }
+        free(tmp);
+        errno = err;
+        return false;
+    }
+
+    size_t bytes = v.length * v.item_size;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    if(ok && bytes > 0) ok = fwrite(v.data, 1, bytes, f) == bytes;
+    // The data must be on disk before the new name can point at it.
+    ok = ok && fflush(f) == 0 && fsync(fd) == 0;
+    ok = fclose(f) == 0 && ok;
+    if(ok) ok = rename(tmp, path) == 0;
+
+    if(!ok) {
+        int err = errno;
+        remove(tmp);
+        errno = err;
+    }
+    free(tmp);
+    // And the rename itself must be on disk before the save counts as done.
+    return ok && __arrayfile_sync_dir__(path);
+}
+
+bool array_map(const char *path, int flags, ArrayMapping *out) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return false;
+    }
+    if((uint64_t)st.st_size < sizeof(ArrayFileHeader)) {
+        close(fd);
+        errno = EINVAL;
+        return false;
+    }
+
+    size_t size = (size_t)st.st_size;
+    int prot    = (flags & ARRAY_MAP_PRIVATE) ? PROT_READ | PROT_WRITE : PROT_READ;
+    int share   = (flags & ARRAY_MAP_PRIVATE) ? MAP_PRIVATE : MAP_SHARED;
+    void *base  = mmap(NULL, size, prot, share, fd, 0);
+    int err     = errno;
+    close(fd);
+    if(base == MAP_FAILED) {
+        errno = err;
+        return false;
+    }
+
+    const ArrayFileHeader *header = base;
+    bool valid = memcmp(header->magic, __ARRAYFILE_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->byte_order == __ARRAYFILE_BYTE_ORDER &&
+                 header->alignment == __ARRAYFILE_ALIGNMENT &&
+                 header->data_offset % __ARRAYFILE_ALIGNMENT == 0 &&
+                 header->data_offset >= sizeof(ArrayFileHeader) &&
+                 header->data_offset <= size &&
+                 (header->item_size == 0 || header->length <= (size - header->data_offset) / header->item_size);
+    if(!valid) {
+        munmap(base, size);
+        errno = EINVAL;
+        return false;
+    }
+
+    char *data = (char *)base + header->data_offset;
+    if((flags & ARRAY_MAP_VERIFY) && __arrayfile_checksum__(data, header->length * header->item_size) != header->checksum) {
+        munmap(base, size);
+        errno = EILSEQ;
+        return false;
+    }
+
+    out->view = av(data, (size_t)header->length, (size_t)header->item_size);
+    out->base = base;
+    out->size = size;
+    return true;
+}
+
+void array_unmap(ArrayMapping *m) {
+    if(m->base) munmap(m->base, m->size);
+    m->base = NULL;
+    m->size = 0;
+    m->view = AV_NULL;
+}
+
+#endif // COLLECTIONS_ARRAYFILE_IMPLEMENTATION
+#endif // COLLECTIONS_ARRAYFILE_H
@@ -0,0 +1,278 @@
+#ifndef COLLECTIONS_AV_H
+#define COLLECTIONS_AV_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/**
+ * @brief Represents a non-owning view of a contiguous run of elements.
+ *
+ * An ArrayView is a pointer, an element count and an element size. It can
+ * point into an array.h array, a C array, a `malloc` block or an `mmap`ed
+ * file without copying, and slicing it never allocates. Like StringView, it
+ * does not manage memory.
+ */
+typedef struct {
+    void   *data;      /**< Pointer to the first element. */
+    size_t  length;    /**< Number of elements in the view. */
+    size_t  item_size; /**< Size of one element in bytes. */
+} ArrayView;
+
+/**
+ * @brief Documents the element type of an ArrayView, like `Array(T)`.
+ *
+ * Example:
+ * ```c
+ * ArrayView(float) prices = av_from_array(float, arr);
+ * ```
+ */
+#define ArrayView(T) ArrayView
+
+/**
+ * @brief Creates an ArrayView from a pointer, an element count and an element size.
+ *
+ * @param data Pointer to the first element.
+ * @param length Number of elements.
+ * @param item_size Size of one element in bytes.
+ * @return A new ArrayView.
+ */
+ArrayView av(void *data, size_t length, size_t item_size);
+
+/**
+ * @brief Returns the elements in `[lower, upper)` of a view.
+ *
+ * `upper` is clamped to the length; an empty range gives an empty view.
+ *
+ * @param v Source ArrayView.
+ * @param lower Start index (inclusive).
+ * @param upper End index (exclusive).
+ * @return Sliced ArrayView.
+ */
+ArrayView av_slice(ArrayView v, size_t lower, size_t upper);
+
+/**
+ * @brief Returns the first `n` elements (or the whole view if shorter).
+ *
+ * @param v Source ArrayView.
+ * @param n Number of elements to keep.
+ * @return Prefix ArrayView.
+ */
+ArrayView av_take(ArrayView v, size_t n);
+
+/**
+ * @brief Returns the view without its first `n` elements.
+ *
+ * @param v Source ArrayView.
+ * @param n Number of elements to skip.
+ * @return Suffix ArrayView.
+ */
+ArrayView av_drop(ArrayView v, size_t n);
+
+/**
+ * @brief Compares two views element by element, byte for byte.
+ *
+ * @param a First ArrayView.
+ * @param b Second ArrayView.
+ * @return true if both have the same length, element size and bytes.
+ */
+bool av_eq(ArrayView a, ArrayView b);
+
+/**
+ * @brief Finds the first occurrence of `needle` as a contiguous subsequence.
+ *
+ * Candidates are located with the vectorized `array_find` kernels on the
+ * first element (for 1, 2, 4 and 8 byte elements), then checked with
+ * `memcmp`. Elements are compared byte for byte.
+ *
+ * @param haystack View to search in.
+ * @param needle Subsequence to look for; must have the same element size.
+ * @return Index of the first match, or `ARRAY_NPOS`. An empty needle matches at 0.
+ */
+size_t av_search(ArrayView haystack, ArrayView needle);
+
+/**
+ * @brief Creates a view of a whole array.h array.
+ *
+ * @tparam T The element type.
+ * @param p Pointer to the array.
+ */
+#define av_from_array(T, p)         (av(p, array_length(p), sizeof(T)))
+
+/**
+ * @brief Creates a view of `n` elements of type `T` starting at `ptr`.
+ *
+ * Example:
+ * ```c
+ * ArrayView(double) col = av_of(double, mapped + offset, rows);
+ * ```
+ */
+#define av_of(T, ptr, n)            (av((void *)(ptr), n, sizeof(T)))
+
+/**
+ * @brief Creates a view of a fixed-size C array.
+ *
+ * Example:
+ * ```c
+ * int primes[] = { 2, 3, 5, 7 };
+ * ArrayView(int) v = AV(primes);
+ * ```
+ */
+#define AV(c)                       (av((void *)(c), sizeof(c) / sizeof((c)[0]), sizeof((c)[0])))
+#define AV_NULL                     (av(NULL, 0, 0))
+
+/**
+ * @brief Returns the number of elements in a view.
+ */
+#define av_length(v)                ((v).length)
+
+/**
+ * @brief Returns the data pointer of a view as `T *`.
+ */
+#define av_data(T, v)               ((T *)(v).data)
+
+/**
+ * @brief Accesses element `idx` of a view, with bounds checking.
+ *
+ * @tparam T The element type.
+ * @param v The ArrayView.
+ * @param idx Index of the element.
+ * @return The element, as an lvalue.
+ */
+#define av_at(T, v, idx)            (*(T *)__av_at(v, idx))
+
+/**
+ * @brief Iterates over the elements of a view with a `T *` cursor.
+ *
+ * Example:
+ * ```c
+ * av_foreach(float, v, x) *x *= 2.0f;
+ * ```
+ */
+#define av_foreach(T, v, it) \
+    for(T *it = av_data(T, v), *it##_end = av_data(T, v) + (v).length; it < it##_end; ++it)
+
+/**
+ * @brief Same as `array_find`, on a view.
+ *
+ * @return Index of the first match, or `ARRAY_NPOS`.
+ */
+#define av_find(T, v, x) \
+    (__array_find_n((v).data, (v).length, sizeof(T), (T[]){ (x) }, __array_key_kind(T)))
+
+/**
+ * @brief Same as `array_count`, on a view.
+ */
+#define av_count(T, v, x) \
+    (__array_count_n((v).data, (v).length, sizeof(T), (T[]){ (x) }, __array_key_kind(T)))
+
+/**
+ * @brief Checks whether a view contains `x`.
+ */
+#define av_contains(T, v, x)        (av_find(T, v, x) != ARRAY_NPOS)
+
+/**
+ * @brief Same as `array_min`, on a view. The view must not be empty.
+ */
+#define av_min(T, v) \
+    (av_data(T, v)[__array_min_n((v).data, (v).length, sizeof(T), __array_key_kind(T))])
+
+/**
+ * @brief Same as `array_max`, on a view. The view must not be empty.
+ */
+#define av_max(T, v) \
+    (av_data(T, v)[__array_max_n((v).data, (v).length, sizeof(T), __array_key_kind(T))])
+
+/**
+ * @brief Same as `array_sum`, on a view.
+ */
+#define av_sum(T, v) \
+    _Generic((T)0, float: __array_sum_float_n((v).data, (v).length, sizeof(T)), \
+                   double: __array_sum_float_n((v).data, (v).length, sizeof(T)), \
+                   default: __array_sum_int_n((v).data, (v).length, sizeof(T), __array_key_kind(T)))
+
+/**
+ * @brief Same as `array_lower_bound`, on a sorted view.
+ */
+#define av_lower_bound(T, v, x) \
+    (__array_lower_bound_n((v).data, (v).length, sizeof(T), (T[]){ (x) }, __array_key_kind(T)))
+
+/**
+ * @brief Same as `array_upper_bound`, on a sorted view.
+ */
+#define av_upper_bound(T, v, x) \
+    (__array_upper_bound_n((v).data, (v).length, sizeof(T), (T[]){ (x) }, __array_key_kind(T)))
+
+void *__av_at(ArrayView v, size_t idx);
+
+
+#ifdef COLLECTIONS_AV_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+ArrayView av(void *data, size_t length, size_t item_size) {
+    return (ArrayView) {
+        .data      = data,
+        .length    = length,
+        .item_size = item_size,
+    };
+}
+
+ArrayView av_slice(ArrayView v, size_t lower, size_t upper) {
+    if(upper > v.length) upper = v.length;
+    if(lower >= upper) return av(v.data, 0, v.item_size);
+    return av((char *)v.data + lower * v.item_size, upper - lower, v.item_size);
+}
+
+ArrayView av_take(ArrayView v, size_t n) {
+    return av_slice(v, 0, n);
+}
+
+ArrayView av_drop(ArrayView v, size_t n) {
+    return av_slice(v, n, v.length);
+}
+
+bool av_eq(ArrayView a, ArrayView b) {
+    if(a.length != b.length || a.item_size != b.item_size) return false;
+    return a.length == 0 || memcmp(a.data, b.data, a.length * a.item_size) == 0;
+}
+
+size_t av_search(ArrayView haystack, ArrayView needle) {
+    if(needle.item_size != haystack.item_size && needle.length > 0) {
+        fprintf(stderr, "av_search failed: element sizes differ.\n");
+        exit(EXIT_FAILURE);
+    }
+    if(needle.length == 0) return 0;
+    if(needle.length > haystack.length) return ARRAY_NPOS;
+
+    size_t size  = haystack.item_size;
+    size_t last  = haystack.length - needle.length;
+    const char *h = haystack.data;
+    bool scan = size == 1 || size == 2 || size == 4 || size == 8;
+
+    for(size_t i = 0; i <= last;) {
+        if(scan) {
+            // Integer equality compares the bit pattern, whatever the element type.
+            size_t hit = __array_find_n(h + i * size, last - i + 1, size, needle.data, __ARRAY_KEY_UNSIGNED);
+            if(hit == ARRAY_NPOS) return ARRAY_NPOS;
+            i += hit;
+        }
+        if(memcmp(h + i * size, needle.data, needle.length * size) == 0) return i;
+        i += 1;
+    }
+    return ARRAY_NPOS;
+}
+
+void *__av_at(ArrayView v, size_t idx) {
+    if(idx >= v.length) {
+        fprintf(stderr, "av_at failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+    return (char *)v.data + idx * v.item_size;
+}
+
+#endif // COLLECTIONS_AV_IMPLEMENTATION
+#endif // COLLECTIONS_AV_H
@@ -0,0 +1,43 @@
+#ifndef COLLECTIONS_BENCH_H
+#define COLLECTIONS_BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @brief Helpers shared by the benchmark programs: a monotonic clock, a
+ * fast deterministic random generator and size arguments.
+ */
+
+static inline double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t __bench_state__ = 0x9E3779B97F4A7C15ull;
+
+// xorshift64: cheap enough not to show up in the timings.
+static inline uint64_t bench_rand(void) {
+    __bench_state__ ^= __bench_state__ << 13;
+    __bench_state__ ^= __bench_state__ >> 7;
+    __bench_state__ ^= __bench_state__ << 17;
+    return __bench_state__;
+}
+
+// Parses argv[i] as a size such as 1000000 or 1e9, or returns `fallback`.
+static inline size_t bench_arg(int argc, char **argv, int i, size_t fallback) {
+    if(i >= argc) return fallback;
+    double v = strtod(argv[i], NULL);
+    return v >= 1 ? (size_t)v : fallback;
+}
+
+// Prevents the compiler from dropping a computed result.
+static inline void bench_keep(uint64_t v) {
+    static volatile uint64_t sink;
+    sink += v;
+}
+
+#endif // COLLECTIONS_BENCH_H
@@ -0,0 +1,99 @@
+// Measures MPMC queue throughput with P producers and P consumers, for P
+// doubling from 1 up to a maximum, with the non-blocking calls (spinning on
+// full/empty) and with the blocking wrappers.
+//
+// Usage: bench/mpmc [max_threads_per_side] [items]   (defaults 8, 4e6)
+
+#define COLLECTIONS_MPMC_IMPLEMENTATION
+#include "mpmc.h"
+#include "bench.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+typedef struct {
+    uint64_t    *queue;
+    size_t      count;      // items this thread pushes or pops
+    uint64_t    first;      // producers push first .. first + count - 1
+    bool        blocking;
+    uint64_t    sum;        // consumers: sum of the popped items
+    atomic_int  *start;
+} BenchWorker;
+
+static void wait_start(atomic_int *start) {
+    while(!atomic_load_explicit(start, memory_order_acquire)) sched_yield();
+}
+
+static void *producer(void *arg) {
+    BenchWorker *w = arg;
+    wait_start(w->start);
+    for(uint64_t i = w->first; i < w->first + w->count; ++i) {
+        if(w->blocking) mpmc_push_wait(uint64_t, w->queue, i);
+        else while(!mpmc_push(uint64_t, w->queue, i)) sched_yield();
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    BenchWorker *w = arg;
+    wait_start(w->start);
+    uint64_t v, sum = 0;
+    for(size_t i = 0; i < w->count; ++i) {
+        if(w->blocking) mpmc_pop_wait(w->queue, &v);
+        else while(!mpmc_pop(w->queue, &v)) sched_yield();
+        sum += v;
+    }
+    w->sum = sum;
+    return NULL;
+}
+
+// Runs one configuration and returns millions of items per second.
+static double run(size_t threads, size_t items, bool blocking) {
+    uint64_t *queue = mpmc_create(uint64_t, 1024);
+    BenchWorker *workers = calloc(2 * threads, sizeof(BenchWorker));
+    pthread_t *ids = calloc(2 * threads, sizeof(pthread_t));
+    atomic_int start = 0;
+    size_t per = items / threads;
+
+    for(size_t i = 0; i < 2 * threads; ++i) {
+        workers[i] = (BenchWorker){
+            .queue = queue, .count = per, .first = (uint64_t)(i % threads) * per,
+            .blocking = blocking, .start = &start,
+        };
+        pthread_create(&ids[i], NULL, i < threads ? producer : consumer, &workers[i]);
+    }
+
+    double t0 = bench_now();
+    atomic_store_explicit(&start, 1, memory_order_release);
+    uint64_t sum = 0;
+    for(size_t i = 0; i < 2 * threads; ++i) {
+        pthread_join(ids[i], NULL);
+        sum += workers[i].sum;
+    }
+    double elapsed = bench_now() - t0;
+
+    uint64_t total = (uint64_t)per * threads;
+    // Producers push 0 .. total - 1 between them.
+    if(sum != total * (total - 1) / 2) {
+        fprintf(stderr, "mpmc: items lost or duplicated.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    mpmc_destroy(queue);
+    free(workers);
+    free(ids);
+    return (double)total / elapsed * 1e-6;
+}
+
+int main(int argc, char **argv) {
+    size_t max_threads = bench_arg(argc, argv, 1, 8);
+    size_t items       = bench_arg(argc, argv, 2, 4000000);
+
+    printf("%10s %14s %14s\n", "threads", "spin", "blocking");
+    printf("%10s %14s %14s\n", "per side", "Mitems/s", "Mitems/s");
+    for(size_t t = 1; t <= max_threads; t *= 2) {
+        printf("%10zu %14.2f %14.2f\n", t, run(t, items, false), run(t, items, true));
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Measures the overhead of the shared scheduler: empty fork/join tasks,
+// from outside and inside the pool, and empty parallel_for loops. Spawning
+// and joining a thread is shown for comparison.
+//
+// Usage: bench/scheduler [depth]   (default 20: 2^20 leaf tasks)
+
+#define COLLECTIONS_SCHEDULER_IMPLEMENTATION
+#include "scheduler.h"
+#include "bench.h"
+
+#include <pthread.h>
+
+static void nothing(void *arg) {
+    (void)arg;
+}
+
+static void *nothing_thread(void *arg) {
+    return arg;
+}
+
+static void empty_body(void *ctx, size_t lo, size_t hi) {
+    (void)ctx;
+    bench_keep(hi - lo);
+}
+
+// Forks two subtrees until depth 0: 2^depth leaves and 2^depth - 1 joins.
+static void tree(void *arg) {
+    size_t depth = (size_t)(uintptr_t)arg;
+    if(depth == 0) return;
+    void *child = (void *)(uintptr_t)(depth - 1);
+    scheduler_join(tree, child, tree, child);
+}
+
+static void report(const char *what, double seconds, size_t count) {
+    printf("%-48s %10.1f ns\n", what, seconds * 1e9 / (double)count);
+}
+
+// The in-pool measurements, run as a task on a worker so that joins go
+// through the worker's deque.
+static void inside(void *arg) {
+    size_t depth = *(size_t *)arg;
+    double t0;
+
+    size_t joins = ((size_t)1 << depth) - 1;
+    t0 = bench_now();
+    tree((void *)(uintptr_t)depth);
+    report("scheduler_join inside the pool, per join", bench_now() - t0, joins);
+
+    size_t n = (size_t)1 << depth;
+    t0 = bench_now();
+    scheduler_parallel_for(0, n, 1, empty_body, NULL);
+    report("parallel_for, grain 1, per iteration", bench_now() - t0, n);
+
+    t0 = bench_now();
+    scheduler_parallel_for(0, n, 0, empty_body, NULL);
+    report("parallel_for, automatic grain, per iteration", bench_now() - t0, n);
+}
+
+int main(int argc, char **argv) {
+    size_t depth = bench_arg(argc, argv, 1, 20);
+    size_t workers = scheduler_workers();
+    double t0;
+
+    printf("workers: %zu%s\n", workers, workers < 2 ? " (calls run inline on the caller)" : "");
+
+    size_t spawns = 2000;
+    t0 = bench_now();
+    for(size_t i = 0; i < spawns; ++i) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, nothing_thread, NULL);
+        pthread_join(thread, NULL);
+    }
+    report("pthread_create + join", bench_now() - t0, spawns);
+
+    size_t calls = 20000;
+    t0 = bench_now();
+    for(size_t i = 0; i < calls; ++i) scheduler_join(nothing, NULL, nothing, NULL);
+    report("scheduler_join from outside the pool", bench_now() - t0, calls);
+
+    size_t width = workers * 4;
+    t0 = bench_now();
+    for(size_t i = 0; i < calls; ++i) scheduler_parallel_for(0, width, 1, empty_body, NULL);
+    report("parallel_for of 4 items per worker, per call", bench_now() - t0, calls);
+
+    scheduler_join(inside, &depth, nothing, NULL);
+    return 0;
+}
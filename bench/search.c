@@ -0,0 +1,89 @@
+// Times lower/upper bound and Eytzinger searches on sorted uint32 arrays
+// from L1-sized to DRAM-sized, against a plain branchy binary search.
+//
+// Usage: bench/search [max_bytes] [queries]   (defaults 256 MiB, 1e6)
+
+#define COLLECTIONS_ARRAY_IMPLEMENTATION
+#include "array.h"
+#include "bench.h"
+
+// The textbook search the branchless versions replace.
+static size_t branchy_lower_bound(const uint32_t *a, size_t n, uint32_t v) {
+    size_t lo = 0, hi = n;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(a[mid] < v) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int main(int argc, char **argv) {
+    size_t max_bytes = bench_arg(argc, argv, 1, (size_t)256 << 20);
+    size_t queries   = bench_arg(argc, argv, 2, 1000000);
+
+    printf("%12s %10s %10s %10s %10s %10s\n", "bytes", "n", "branchy", "lower", "upper", "eytzinger");
+    printf("%12s %10s %10s %10s %10s %10s\n", "", "", "ns/query", "ns/query", "ns/query", "ns/query");
+
+    uint32_t *keys = array_create(uint32_t);
+    keys = array_insert_n(uint32_t, keys, 0, NULL, queries);
+
+    for(size_t bytes = 4096; bytes <= max_bytes; bytes *= 4) {
+        size_t n = bytes / sizeof(uint32_t);
+
+        // Odd values only, so half of the queries (the even ones) miss.
+        uint32_t *sorted = array_create(uint32_t);
+        sorted = array_insert_n(uint32_t, sorted, 0, NULL, n);
+        for(size_t i = 0; i < n; ++i) sorted[i] = (uint32_t)(2 * i + 1);
+        uint32_t *tree = array_eytzinger_build(uint32_t, sorted);
+        for(size_t q = 0; q < queries; ++q) keys[q] = (uint32_t)(bench_rand() % (2 * n + 2));
+
+        uint64_t check[4] = { 0 };
+        double t[4], t0;
+
+        t0 = bench_now();
+        for(size_t q = 0; q < queries; ++q) check[0] += branchy_lower_bound(sorted, n, keys[q]);
+        t[0] = bench_now() - t0;
+
+        t0 = bench_now();
+        for(size_t q = 0; q < queries; ++q) check[1] += array_lower_bound(uint32_t, sorted, keys[q]);
+        t[1] = bench_now() - t0;
+
+        t0 = bench_now();
+        for(size_t q = 0; q < queries; ++q) check[2] += array_upper_bound(uint32_t, sorted, keys[q]);
+        t[2] = bench_now() - t0;
+
+        // Eytzinger indices differ from sorted ones, so compare found values instead.
+        uint64_t found = 0;
+        t0 = bench_now();
+        for(size_t q = 0; q < queries; ++q) {
+            size_t i = array_eytzinger_lower_bound(uint32_t, tree, keys[q]);
+            check[3] += i;
+            found += i != ARRAY_NPOS ? tree[i] : 0;
+        }
+        t[3] = bench_now() - t0;
+
+        uint64_t expect = 0;
+        for(size_t q = 0; q < queries; ++q) {
+            size_t i = branchy_lower_bound(sorted, n, keys[q]);
+            expect += i < n ? sorted[i] : 0;
+        }
+        if(found != expect) {
+            fprintf(stderr, "search: eytzinger results differ from the sorted search.\n");
+            return 1;
+        }
+        if(check[0] != check[1]) {
+            fprintf(stderr, "search: array_lower_bound differs from the reference.\n");
+            return 1;
+        }
+        bench_keep(check[2] + check[3]);
+
+        printf("%12zu %10zu %10.2f %10.2f %10.2f %10.2f\n", bytes, n,
+               t[0] * 1e9 / queries, t[1] * 1e9 / queries, t[2] * 1e9 / queries, t[3] * 1e9 / queries);
+
+        array_destroy(sorted);
+        array_destroy(tree);
+    }
+    array_destroy(keys);
+    return 0;
+}
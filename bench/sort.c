@@ -0,0 +1,69 @@
+// Compares array_sort and array_radix_sort with qsort on random data.
+//
+// Usage: bench/sort [max_n]   (default 1e7; 1e9 needs about 16 GB)
+
+#define COLLECTIONS_ARRAY_IMPLEMENTATION
+#include "array.h"
+#include "bench.h"
+
+#include <string.h>
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts copies of `src` with every method, enough times to run for a while,
+// and prints nanoseconds per element.
+#define __bench_sort__(T, name, src, n, cmp)                                                \
+    do {                                                                                    \
+        size_t reps = (n) < 2000000 ? 2000000 / (n) : 1;                                    \
+        T *work = array_create(T);                                                          \
+        work = array_insert_n(T, work, 0, src, n);                                          \
+        double t_qsort = 0, t_sort = 0, t_radix = 0, t0;                                    \
+        for(size_t r = 0; r < reps; ++r) {                                                  \
+            memcpy(work, src, (n) * sizeof(T));                                             \
+            t0 = bench_now(); qsort(work, n, sizeof(T), cmp); t_qsort += bench_now() - t0;  \
+            memcpy(work, src, (n) * sizeof(T));                                             \
+            t0 = bench_now(); array_sort(work, cmp); t_sort += bench_now() - t0;            \
+            memcpy(work, src, (n) * sizeof(T));                                             \
+            t0 = bench_now(); array_radix_sort(T, work); t_radix += bench_now() - t0;       \
+            bench_keep((uint64_t)work[(n) / 2]);                                            \
+        }                                                                                   \
+        double scale = 1e9 / ((double)reps * (double)(n));                                  \
+        printf("%-8s %12zu %10.2f %10.2f %10.2f %8.1fx %8.1fx\n", name, (size_t)(n),        \
+               t_qsort * scale, t_sort * scale, t_radix * scale,                            \
+               t_qsort / t_sort, t_qsort / t_radix);                                        \
+        array_destroy(work);                                                                \
+    } while(0)
+
+int main(int argc, char **argv) {
+    size_t max_n = bench_arg(argc, argv, 1, 10000000);
+
+    printf("%-8s %12s %10s %10s %10s %9s %9s\n", "type", "n", "qsort", "array_sort", "radix",
+           "sort/q", "radix/q");
+    printf("%-8s %12s %10s %10s %10s\n", "", "", "ns/elem", "ns/elem", "ns/elem");
+
+    for(size_t n = 1000; n <= max_n; n *= 10) {
+        uint32_t *ints = array_create(uint32_t);
+        double *reals  = array_create(double);
+        ints  = array_insert_n(uint32_t, ints, 0, NULL, n);
+        reals = array_insert_n(double, reals, 0, NULL, n);
+        for(size_t i = 0; i < n; ++i) {
+            ints[i]  = (uint32_t)bench_rand();
+            reals[i] = (double)(bench_rand() >> 11) * 0x1p-53 - 0.5;
+        }
+
+        __bench_sort__(uint32_t, "uint32", ints, n, cmp_u32);
+        __bench_sort__(double, "double", reals, n, cmp_double);
+
+        array_destroy(ints);
+        array_destroy(reals);
+    }
+    return 0;
+}
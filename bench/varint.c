@@ -0,0 +1,118 @@
+// Measures varint encode and decode speed in GB/s of 8-byte input values,
+// for LEB128 (against a byte-at-a-time reference), group varint and
+// zigzag-mapped signed values, on several value distributions.
+//
+// Usage: bench/varint [values]   (default 4e6)
+
+#define COLLECTIONS_ARRAY_IMPLEMENTATION
+#define COLLECTIONS_VARINT_IMPLEMENTATION
+#include "array.h"
+#include "varint.h"
+#include "bench.h"
+
+#include <string.h>
+
+// The hand-written loop varint.h replaces.
+static size_t reference_encode(const uint64_t *values, size_t n, uint8_t *out) {
+    uint8_t *p = out;
+    for(size_t i = 0; i < n; ++i) {
+        uint64_t v = values[i];
+        while(v >= 0x80) {
+            *p++ = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        *p++ = (uint8_t)v;
+    }
+    return (size_t)(p - out);
+}
+
+static size_t reference_decode(const uint8_t *in, uint64_t *out, size_t n) {
+    const uint8_t *p = in;
+    for(size_t i = 0; i < n; ++i) {
+        uint64_t v = 0;
+        unsigned shift = 0;
+        uint8_t b;
+        do {
+            b = *p++;
+            v |= (uint64_t)(b & 0x7F) << shift;
+            shift += 7;
+        } while(b & 0x80);
+        out[i] = v;
+    }
+    return (size_t)(p - in);
+}
+
+// Values whose bit length is uniform in [1, bits]: mostly short encodings
+// when `bits` is small, mixed lengths otherwise.
+static void fill(uint64_t *values, size_t n, unsigned bits) {
+    for(size_t i = 0; i < n; ++i) {
+        unsigned len = 1 + (unsigned)(bench_rand() % bits);
+        values[i] = bench_rand() >> (64 - len);
+    }
+}
+
+static double gbps(size_t n, double seconds) {
+    return (double)n * sizeof(uint64_t) / seconds * 1e-9;
+}
+
+static void check(const uint64_t *want, const uint64_t *got, size_t n, const char *what) {
+    if(memcmp(want, got, n * sizeof(uint64_t)) != 0) {
+        fprintf(stderr, "varint: %s did not round-trip.\n", what);
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t n = bench_arg(argc, argv, 1, 4000000);
+    uint64_t *values  = malloc(n * sizeof(uint64_t));
+    uint64_t *decoded = malloc(n * sizeof(uint64_t));
+    uint8_t *buf      = malloc(VARINT_GROUP_MAX_BYTES(n) > VARINT_MAX_BYTES(n) ? VARINT_GROUP_MAX_BYTES(n) : VARINT_MAX_BYTES(n));
+    if(!values || !decoded || !buf) {
+        fprintf(stderr, "varint: cannot allocate memory.\n");
+        return 1;
+    }
+
+    struct { const char *name; unsigned bits; } cases[] = {
+        { "7-bit", 7 }, { "14-bit", 14 }, { "32-bit", 32 }, { "64-bit", 64 },
+    };
+
+    printf("%-8s %-10s %10s %10s %10s\n", "values", "codec", "bytes/val", "enc GB/s", "dec GB/s");
+    for(size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        fill(values, n, cases[c].bits);
+        double t0, te, td;
+        size_t size, used;
+
+        t0 = bench_now(); size = reference_encode(values, n, buf); te = bench_now() - t0;
+        t0 = bench_now(); reference_decode(buf, decoded, n); td = bench_now() - t0;
+        check(values, decoded, n, "reference");
+        printf("%-8s %-10s %10.2f %10.2f %10.2f\n", cases[c].name, "bytewise", (double)size / n, gbps(n, te), gbps(n, td));
+
+        t0 = bench_now(); size = varint_encode(values, n, buf); te = bench_now() - t0;
+        t0 = bench_now(); varint_decode(buf, size, decoded, n, &used); td = bench_now() - t0;
+        check(values, decoded, n, "varint_encode");
+        printf("%-8s %-10s %10.2f %10.2f %10.2f\n", "", "leb128", (double)size / n, gbps(n, te), gbps(n, td));
+
+        t0 = bench_now(); size = varint_group_encode(values, n, buf); te = bench_now() - t0;
+        t0 = bench_now(); varint_group_decode(buf, size, decoded, n, &used); td = bench_now() - t0;
+        check(values, decoded, n, "varint_group_encode");
+        printf("%-8s %-10s %10.2f %10.2f %10.2f\n", "", "group", (double)size / n, gbps(n, te), gbps(n, td));
+    }
+
+    // Small signed deltas, as in sorted timestamps or coordinates.
+    int64_t *deltas = (int64_t *)values, *signed_out = (int64_t *)decoded;
+    for(size_t i = 0; i < n; ++i) deltas[i] = (int64_t)(bench_rand() % 2001) - 1000;
+    double t0 = bench_now();
+    size_t size = varint_encode_signed(deltas, n, buf);
+    double te = bench_now() - t0;
+    size_t used;
+    t0 = bench_now();
+    varint_decode_signed(buf, size, signed_out, n, &used);
+    double td = bench_now() - t0;
+    check(values, decoded, n, "varint_encode_signed");
+    printf("%-8s %-10s %10.2f %10.2f %10.2f\n", "+-1000", "zigzag", (double)size / n, gbps(n, te), gbps(n, td));
+
+    free(values);
+    free(decoded);
+    free(buf);
+    return 0;
+}
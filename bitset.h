@@ -0,0 +1,367 @@
+#ifndef COLLECTIONS_BITSET_H
+#define COLLECTIONS_BITSET_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/**
+ * @brief A growable array of bits.
+ *
+ * Bits are packed 64 per word in an array.h `Array(uint64_t)`, so growth uses
+ * the same doubling as any other array. Bits past `length` are always zero.
+ */
+typedef struct {
+    uint64_t *words;  /**< Bit storage, `ceil(length / 64)` words long. */
+    size_t    length; /**< Number of addressable bits. */
+} Bitset;
+
+/**
+ * @brief Creates an empty bitset.
+ *
+ * @return A new Bitset; release it with `bitset_destroy`.
+ */
+Bitset bitset_create(void);
+
+/**
+ * @brief Frees the storage of a bitset.
+ *
+ * @param b Bitset to destroy.
+ */
+void bitset_destroy(Bitset *b);
+
+/**
+ * @brief Sets the number of bits. New bits are cleared.
+ *
+ * @param b Bitset to resize.
+ * @param length New length in bits.
+ */
+void bitset_resize(Bitset *b, size_t length);
+
+/**
+ * @brief Returns the number of bits in the bitset.
+ *
+ * @param b Input Bitset.
+ * @return Length in bits.
+ */
+size_t bitset_size(const Bitset *b);
+
+/**
+ * @brief Sets bit `i`, growing the bitset if needed.
+ *
+ * @param b Bitset to modify.
+ * @param i Bit index.
+ */
+void bitset_set(Bitset *b, size_t i);
+
+/**
+ * @brief Clears bit `i`. Indices past the end are already clear.
+ *
+ * @param b Bitset to modify.
+ * @param i Bit index.
+ */
+void bitset_clear(Bitset *b, size_t i);
+
+/**
+ * @brief Returns bit `i`, or false if `i` is past the end.
+ *
+ * @param b Input Bitset.
+ * @param i Bit index.
+ * @return The value of the bit.
+ */
+bool bitset_get(const Bitset *b, size_t i);
+
+/**
+ * @brief Counts the set bits (AVX2 when available).
+ *
+ * @param b Input Bitset.
+ * @return Number of set bits.
+ */
+size_t bitset_count(const Bitset *b);
+
+/**
+ * @brief Counts the set bits strictly before position `i`.
+ *
+ * @param b Input Bitset.
+ * @param i Bit index (may exceed the length).
+ * @return Number of set bits in `[0, i)`.
+ */
+size_t bitset_rank(const Bitset *b, size_t i);
+
+/**
+ * @brief Finds the position of the `k`-th set bit (0-based).
+ *
+ * @param b Input Bitset.
+ * @param k Rank of the wanted bit.
+ * @return Its index, or `ARRAY_NPOS` if fewer than `k + 1` bits are set.
+ */
+size_t bitset_select(const Bitset *b, size_t k);
+
+/**
+ * @brief Finds the first set bit at or after `from`.
+ *
+ * Skips whole zero words and locates the bit with a trailing-zero count.
+ *
+ * @param b Input Bitset.
+ * @param from First index to consider.
+ * @return Index of the next set bit, or `ARRAY_NPOS`.
+ */
+size_t bitset_next_set(const Bitset *b, size_t from);
+
+/**
+ * @brief In-place intersection: `dst &= src`. `dst` keeps its length.
+ *
+ * @param dst Bitset to modify.
+ * @param src Other operand.
+ */
+void bitset_and(Bitset *dst, const Bitset *src);
+
+/**
+ * @brief In-place union: `dst |= src`. `dst` grows to the longer length.
+ *
+ * @param dst Bitset to modify.
+ * @param src Other operand.
+ */
+void bitset_or(Bitset *dst, const Bitset *src);
+
+/**
+ * @brief In-place symmetric difference: `dst ^= src`. `dst` grows to the longer length.
+ *
+ * @param dst Bitset to modify.
+ * @param src Other operand.
+ */
+void bitset_xor(Bitset *dst, const Bitset *src);
+
+/**
+ * @brief In-place difference: `dst &= ~src`. `dst` keeps its length.
+ *
+ * @param dst Bitset to modify.
+ * @param src Other operand.
+ */
+void bitset_andnot(Bitset *dst, const Bitset *src);
+
+/**
+ * @brief Iterates over the indices of all set bits in increasing order.
+ *
+ * Example:
+ * ```c
+ * size_t i;
+ * bitset_foreach(&flags, i) {
+ *     printf("%zu\n", i);
+ * }
+ * ```
+ */
+#define bitset_foreach(b, i) \
+    for((i) = bitset_next_set((b), 0); (i) != ARRAY_NPOS; (i) = bitset_next_set((b), (i) + 1))
+
+
+#ifdef COLLECTIONS_BITSET_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define __BITSET_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define __BITSET_SIMD_X86 0
+#endif
+
+#define __BITSET_WORDS(bits)    (((bits) + 63) / 64)
+
+static inline size_t __bitset_popcount_scalar__(const uint64_t *words, size_t n) {
+    size_t count = 0;
+    for(size_t i = 0; i < n; ++i) count += (size_t)__builtin_popcountll(words[i]);
+    return count;
+}
+
+enum { __BITSET_AND, __BITSET_OR, __BITSET_XOR, __BITSET_ANDNOT };
+
+static inline void __bitset_op_scalar__(uint64_t *dst, const uint64_t *src, size_t n, int op) {
+    switch(op) {
+        case __BITSET_AND:    for(size_t i = 0; i < n; ++i) dst[i] &= src[i];  break;
+        case __BITSET_OR:     for(size_t i = 0; i < n; ++i) dst[i] |= src[i];  break;
+        case __BITSET_XOR:    for(size_t i = 0; i < n; ++i) dst[i] ^= src[i];  break;
+        case __BITSET_ANDNOT: for(size_t i = 0; i < n; ++i) dst[i] &= ~src[i]; break;
+    }
+}
+
+#if __BITSET_SIMD_X86
+
+// Nibble lookup popcount (Mula et al.): vpshufb counts the bits of each
+// nibble, vpsadbw sums the byte counts into four 64-bit lanes.
+__attribute__((target("avx2")))
+static size_t __bitset_popcount_avx2__(const uint64_t *words, size_t n) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    while(i + 4 <= n) {
+        // Byte counters hold at most 8 per word, so flush every 31 vectors.
+        __m256i local = _mm256_setzero_si256();
+        for(int k = 0; k < 31 && i + 4 <= n; ++k, i += 4) {
+            __m256i v  = _mm256_loadu_si256((const __m256i *)(words + i));
+            __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low));
+            __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+            local = _mm256_add_epi8(local, _mm256_add_epi8(lo, hi));
+        }
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(local, _mm256_setzero_si256()));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    size_t count = (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    return count + __bitset_popcount_scalar__(words + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void __bitset_op_avx2__(uint64_t *dst, const uint64_t *src, size_t n, int op) {
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+        switch(op) {
+            case __BITSET_AND:    a = _mm256_and_si256(a, b);    break;
+            case __BITSET_OR:     a = _mm256_or_si256(a, b);     break;
+            case __BITSET_XOR:    a = _mm256_xor_si256(a, b);    break;
+            case __BITSET_ANDNOT: a = _mm256_andnot_si256(b, a); break;
+        }
+        _mm256_storeu_si256((__m256i *)(dst + i), a);
+    }
+    __bitset_op_scalar__(dst + i, src + i, n - i, op);
+}
+
+static inline size_t __bitset_popcount__(const uint64_t *words, size_t n) {
+    return __builtin_cpu_supports("avx2") ? __bitset_popcount_avx2__(words, n) : __bitset_popcount_scalar__(words, n);
+}
+
+static inline void __bitset_op__(uint64_t *dst, const uint64_t *src, size_t n, int op) {
+    if(__builtin_cpu_supports("avx2")) __bitset_op_avx2__(dst, src, n, op);
+    else __bitset_op_scalar__(dst, src, n, op);
+}
+
+#else
+
+#define __bitset_popcount__(words, n)       (__bitset_popcount_scalar__(words, n))
+#define __bitset_op__(dst, src, n, op)      (__bitset_op_scalar__(dst, src, n, op))
+
+#endif // __BITSET_SIMD_X86
+
+Bitset bitset_create(void) {
+    return (Bitset) {
+        .words  = array_create(uint64_t),
+        .length = 0,
+    };
+}
+
+void bitset_destroy(Bitset *b) {
+    array_destroy(b->words);
+    b->words  = NULL;
+    b->length = 0;
+}
+
+void bitset_resize(Bitset *b, size_t length) {
+    size_t have = array_length(b->words);
+    size_t need = __BITSET_WORDS(length);
+
+    if(need > have) {
+        b->words = array_insert_n(uint64_t, b->words, have, NULL, need - have);
+        memset(b->words + have, 0, (need - have) * sizeof(uint64_t));
+    } else {
+        array_truncate(b->words, need);
+    }
+
+    // Keep the bits past the end of the last word cleared.
+    if(length % 64 != 0) b->words[need - 1] &= (UINT64_C(1) << (length % 64)) - 1;
+    b->length = length;
+}
+
+size_t bitset_size(const Bitset *b) {
+    return b->length;
+}
+
+void bitset_set(Bitset *b, size_t i) {
+    if(i >= b->length) bitset_resize(b, i + 1);
+    b->words[i / 64] |= UINT64_C(1) << (i % 64);
+}
+
+void bitset_clear(Bitset *b, size_t i) {
+    if(i >= b->length) return;
+    b->words[i / 64] &= ~(UINT64_C(1) << (i % 64));
+}
+
+bool bitset_get(const Bitset *b, size_t i) {
+    if(i >= b->length) return false;
+    return (b->words[i / 64] >> (i % 64)) & 1;
+}
+
+size_t bitset_count(const Bitset *b) {
+    return __bitset_popcount__(b->words, array_length(b->words));
+}
+
+size_t bitset_rank(const Bitset *b, size_t i) {
+    if(i >= b->length) return bitset_count(b);
+
+    size_t count = __bitset_popcount__(b->words, i / 64);
+    if(i % 64 != 0) count += (size_t)__builtin_popcountll(b->words[i / 64] & ((UINT64_C(1) << (i % 64)) - 1));
+    return count;
+}
+
+size_t bitset_select(const Bitset *b, size_t k) {
+    size_t n = array_length(b->words);
+    for(size_t w = 0; w < n; ++w) {
+        size_t c = (size_t)__builtin_popcountll(b->words[w]);
+        if(k >= c) {
+            k -= c;
+            continue;
+        }
+
+        uint64_t word = b->words[w];
+        while(k-- > 0) word &= word - 1;
+        return w * 64 + (size_t)__builtin_ctzll(word);
+    }
+    return ARRAY_NPOS;
+}
+
+size_t bitset_next_set(const Bitset *b, size_t from) {
+    if(from >= b->length) return ARRAY_NPOS;
+
+    size_t n = array_length(b->words);
+    size_t w = from / 64;
+    uint64_t word = b->words[w] & (~UINT64_C(0) << (from % 64));
+
+    while(word == 0) {
+        if(++w >= n) return ARRAY_NPOS;
+        word = b->words[w];
+    }
+    return w * 64 + (size_t)__builtin_ctzll(word);
+}
+
+void bitset_and(Bitset *dst, const Bitset *src) {
+    size_t nd = array_length(dst->words), ns = array_length(src->words);
+    size_t n  = nd < ns ? nd : ns;
+    __bitset_op__(dst->words, src->words, n, __BITSET_AND);
+    memset(dst->words + n, 0, (nd - n) * sizeof(uint64_t));
+}
+
+void bitset_or(Bitset *dst, const Bitset *src) {
+    if(src->length > dst->length) bitset_resize(dst, src->length);
+    __bitset_op__(dst->words, src->words, array_length(src->words), __BITSET_OR);
+}
+
+void bitset_xor(Bitset *dst, const Bitset *src) {
+    if(src->length > dst->length) bitset_resize(dst, src->length);
+    __bitset_op__(dst->words, src->words, array_length(src->words), __BITSET_XOR);
+}
+
+void bitset_andnot(Bitset *dst, const Bitset *src) {
+    size_t nd = array_length(dst->words), ns = array_length(src->words);
+    __bitset_op__(dst->words, src->words, nd < ns ? nd : ns, __BITSET_ANDNOT);
+}
+
+#endif // COLLECTIONS_BITSET_IMPLEMENTATION
+#endif // COLLECTIONS_BITSET_H
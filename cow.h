@@ -0,0 +1,315 @@
+#ifndef COLLECTIONS_COW_H
+#define COLLECTIONS_COW_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+void        *__cow_create(size_t item_size);
+void        *__cow_from(const void *data, size_t length, size_t item_size);
+void        *__cow_clone(void *arr);
+void        __cow_release(void *arr);
+size_t      __cow_length(const void *arr);
+size_t      __cow_refs(const void *arr);
+const void  *__cow_at(const void *arr, size_t idx);
+void        *__cow_mut(void *arr);
+void        *__cow_set(void *arr, size_t idx, const void *item);
+void        *__cow_append_n(void *arr, const void *items, size_t count);
+void        *__cow_truncate(void *arr, size_t length);
+
+/**
+ * @brief Declares a reference-counted, copy-on-write array of `T`.
+ *
+ * Like `Array(T)`, a CowArray is a pointer to its first element with a
+ * header stored just before it; the header also holds an atomic reference
+ * count. `cow_clone` hands out another reference in O(1) without copying.
+ * Functions that modify the array check the count first: if the array is
+ * shared, they copy it and drop the caller's reference to the original, so
+ * other holders keep seeing the elements as they were. The first write after
+ * a share therefore costs one copy; later writes by the same owner are in
+ * place. Like array.h functions, they return the (possibly new) pointer, which
+ * must replace the old one.
+ *
+ * This gives readers on other threads consistent snapshots: the writer clones
+ * its array and passes the clone on, and the reader releases it when done.
+ * Reading elements is plain pointer access, and the reference count is the
+ * only shared state that is ever written.
+ *
+ * A reference belongs to one thread at a time. `cow_clone` must be called by
+ * the thread that owns the reference being cloned; the clone can then be sent
+ * to another thread.
+ *
+ * Example:
+ * ```c
+ * CowArray(int) log = cow_create(int);
+ * log = cow_append(int, log, 1);
+ * CowArray(int) snapshot = cow_clone(int, log);    // O(1), shared
+ * log = cow_append(int, log, 2);                   // copies once; snapshot still has 1 element
+ * cow_release(snapshot);
+ * cow_release(log);
+ * ```
+ */
+#define CowArray(T) T *
+
+/**
+ * @brief Creates an empty copy-on-write array for elements of type `T`.
+ *
+ * @tparam T The element type.
+ * @return A new array holding one reference.
+ */
+#define cow_create(T)               ((T *)__cow_create(sizeof(T)))
+
+/**
+ * @brief Creates a copy-on-write array holding a copy of an array.h array.
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the array.h array.
+ * @return A new array holding one reference.
+ */
+#define cow_from_array(T, p)        ((T *)__cow_from(p, array_length(p), sizeof(T)))
+
+/**
+ * @brief Returns another reference to the same elements, in O(1).
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the array.
+ * @return `p`, with its reference count increased.
+ */
+#define cow_clone(T, p)             ((T *)__cow_clone(p))
+
+/**
+ * @brief Drops one reference; the array is freed when the last one is released.
+ *
+ * @param p Pointer to the array.
+ */
+#define cow_release(p)              (__cow_release(p))
+
+/**
+ * @brief Returns the number of elements.
+ *
+ * @param p Pointer to the array.
+ * @return The length.
+ */
+#define cow_length(p)               (__cow_length(p))
+
+/**
+ * @brief Returns the number of references to the array.
+ *
+ * Only meaningful as a hint while other threads hold references.
+ *
+ * @param p Pointer to the array.
+ * @return The reference count.
+ */
+#define cow_refs(p)                 (__cow_refs(p))
+
+/**
+ * @brief Returns the element at `idx`, checking the index.
+ *
+ * Elements can also be read directly as `p[idx]`.
+ *
+ * @tparam T  The element type.
+ * @param p   Pointer to the array.
+ * @param idx Index of the element.
+ * @return The element.
+ */
+#define cow_at(T, p, idx)           (*(const T *)__cow_at(p, idx))
+
+/**
+ * @brief Makes the array writable in place, copying it first if it is shared.
+ *
+ * After this call `p[i] = v` is allowed until the array is cloned again.
+ *
+ * Example:
+ * ```c
+ * prices = cow_mut(double, prices);
+ * for(size_t i = 0; i < cow_length(prices); ++i) prices[i] *= 1.2;
+ * ```
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the array.
+ * @return The array, now uniquely owned; possibly moved.
+ */
+#define cow_mut(T, p)               ((T *)__cow_mut(p))
+
+/**
+ * @brief Replaces the element at `idx`, copying the array first if it is shared.
+ *
+ * @tparam T  The element type.
+ * @param p   Pointer to the array.
+ * @param idx Index of the element.
+ * @param v   New value.
+ * @return The array, possibly moved.
+ */
+#define cow_set(T, p, idx, v)       ((T *)__cow_set(p, idx, (T[]){ (v) }))
+
+/**
+ * @brief Appends one element, copying the array first if it is shared.
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the array.
+ * @param v  Value to append.
+ * @return The array, possibly moved.
+ */
+#define cow_append(T, p, v)         ((T *)__cow_append_n(p, (T[]){ (v) }, 1))
+
+/**
+ * @brief Appends `n` elements, copying the array first if it is shared.
+ *
+ * @tparam T    The element type.
+ * @param p     Pointer to the array.
+ * @param items Pointer to `n` elements.
+ * @param n     Number of elements.
+ * @return The array, possibly moved.
+ */
+#define cow_append_n(T, p, items, n) ((T *)__cow_append_n(p, items, n))
+
+/**
+ * @brief Shrinks the array to `length` elements, copying the kept ones first if it is shared.
+ *
+ * @tparam T     The element type.
+ * @param p      Pointer to the array.
+ * @param length New length, at most the current one.
+ * @return The array, possibly moved.
+ */
+#define cow_truncate(T, p, length)  ((T *)__cow_truncate(p, length))
+
+
+#ifdef COLLECTIONS_COW_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define __COW_INITIAL_CAPACITY 10
+
+typedef struct {
+    _Atomic size_t  refs;
+    size_t          length;
+    size_t          cap;
+    size_t          item_size;
+} CowHeader;
+
+#define cowheader(p) ((CowHeader *)(p) - 1)
+
+static CowHeader *__cow_alloc__(size_t item_size, size_t cap, const char *fn) {
+    CowHeader *header = malloc(sizeof(CowHeader) + cap * item_size);
+    if(!header) {
+        fprintf(stderr, "%s failed: cannot allocate memory.\n", fn);
+        exit(EXIT_FAILURE);
+    }
+    atomic_init(&header->refs, 1);
+    header->length    = 0;
+    header->cap       = cap;
+    header->item_size = item_size;
+    return header;
+}
+
+// Returns an array owned only by the caller with room for `extra` more
+// elements. A shared array is copied (only its first `keep` elements) and the
+// caller's reference to it is released; a unique one is grown in place.
+static void *__cow_own__(void *arr, size_t keep, size_t extra, const char *fn) {
+    CowHeader *header = cowheader(arr);
+    size_t need = keep + extra;
+    size_t cap  = header->cap > 0 ? header->cap : 1;
+    while(cap < need) cap *= 2;
+
+    // Acquire pairs with the release in __cow_release: reads made through
+    // references that are gone now happen before the writes that follow.
+    if(atomic_load_explicit(&header->refs, memory_order_acquire) == 1) {
+        if(cap == header->cap) return arr;
+        CowHeader *p = realloc(header, sizeof(CowHeader) + cap * header->item_size);
+        if(!p) {
+            fprintf(stderr, "%s failed: cannot resize array.\n", fn);
+            exit(EXIT_FAILURE);
+        }
+        p->cap = cap;
+        return p + 1;
+    }
+
+    CowHeader *copy = __cow_alloc__(header->item_size, cap, fn);
+    memcpy(copy + 1, arr, keep * header->item_size);
+    copy->length = keep;
+    __cow_release(arr);
+    return copy + 1;
+}
+
+void *__cow_create(size_t item_size) {
+    return __cow_alloc__(item_size, __COW_INITIAL_CAPACITY, "__cow_create") + 1;
+}
+
+void *__cow_from(const void *data, size_t length, size_t item_size) {
+    CowHeader *header = __cow_alloc__(item_size, length > 0 ? length : __COW_INITIAL_CAPACITY, "__cow_from");
+    if(length > 0) memcpy(header + 1, data, length * item_size);
+    header->length = length;
+    return header + 1;
+}
+
+void *__cow_clone(void *arr) {
+    // The caller already holds a reference, so nobody can free the array
+    // concurrently and no ordering is needed.
+    atomic_fetch_add_explicit(&cowheader(arr)->refs, 1, memory_order_relaxed);
+    return arr;
+}
+
+void __cow_release(void *arr) {
+    CowHeader *header = cowheader(arr);
+    // Release publishes this holder's reads; acquire on the last decrement
+    // orders every other holder's reads before the free.
+    if(atomic_fetch_sub_explicit(&header->refs, 1, memory_order_acq_rel) == 1) free(header);
+}
+
+size_t __cow_length(const void *arr) {
+    return cowheader(arr)->length;
+}
+
+size_t __cow_refs(const void *arr) {
+    return atomic_load_explicit(&cowheader(arr)->refs, memory_order_relaxed);
+}
+
+const void *__cow_at(const void *arr, size_t idx) {
+    const CowHeader *header = cowheader(arr);
+    if(idx >= header->length) {
+        fprintf(stderr, "__cow_at failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+    return (const char *)arr + idx * header->item_size;
+}
+
+void *__cow_mut(void *arr) {
+    return __cow_own__(arr, cowheader(arr)->length, 0, "__cow_mut");
+}
+
+void *__cow_set(void *arr, size_t idx, const void *item) {
+    CowHeader *header = cowheader(arr);
+    if(idx >= header->length) {
+        fprintf(stderr, "__cow_set failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+    arr = __cow_own__(arr, header->length, 0, "__cow_set");
+    size_t size = cowheader(arr)->item_size;
+    memcpy((char *)arr + idx * size, item, size);
+    return arr;
+}
+
+void *__cow_append_n(void *arr, const void *items, size_t count) {
+    arr = __cow_own__(arr, cowheader(arr)->length, count, "__cow_append_n");
+    CowHeader *header = cowheader(arr);
+    if(count > 0) memcpy((char *)arr + header->length * header->item_size, items, count * header->item_size);
+    header->length += count;
+    return arr;
+}
+
+void *__cow_truncate(void *arr, size_t length) {
+    if(length > cowheader(arr)->length) {
+        fprintf(stderr, "__cow_truncate failed: length exceeds array length.\n");
+        exit(EXIT_FAILURE);
+    }
+    arr = __cow_own__(arr, length, 0, "__cow_truncate");
+    cowheader(arr)->length = length;
+    return arr;
+}
+
+#endif // COLLECTIONS_COW_IMPLEMENTATION
+#endif // COLLECTIONS_COW_H
@@ -0,0 +1,377 @@
+#ifndef COLLECTIONS_CSR_H
+#define COLLECTIONS_CSR_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+#include "av.h"
+#include "scheduler.h"
+
+/**
+ * @brief A jagged array in compressed sparse row form: rows of varying length packed into one array.
+ *
+ * All elements live in one array.h array, `values`, row after row. Row `r`
+ * is `values[offsets[r] .. offsets[r + 1])`, so `offsets` has one entry per
+ * row plus one and starts at 0. Compared with an `Array` of `Array(T)`
+ * pointers, this takes two allocations in total instead of one per row, and
+ * walking the rows in order is a single sequential scan over `values`.
+ *
+ * Typical use is a graph's adjacency lists, with one row per vertex holding
+ * its neighbours, built from an edge list with `csr_from_pairs`.
+ *
+ * Example:
+ * ```c
+ * Csr(uint32_t) g = csr_from_pairs(uint32_t, vertices, edge_src, edge_dst);
+ * for(uint32_t v = 0; v < csr_rows(g); ++v) {
+ *     const uint32_t *adj = csr_row_data(uint32_t, g, v);
+ *     for(size_t k = 0; k < csr_row_length(g, v); ++k) visit(v, adj[k]);
+ * }
+ * csr_destroy(&g);
+ * ```
+ */
+typedef struct {
+    size_t  *offsets;   /**< Array(size_t) of row starts, plus the total length at the end. */
+    void    *values;    /**< array.h array of all elements, row after row. */
+    size_t  item_size;  /**< Size of one element in bytes. */
+} Csr;
+
+/**
+ * @brief Documents the element type of a Csr, like `Array(T)`.
+ */
+#define Csr(T) Csr
+
+Csr         __csr_create(size_t item_size);
+Csr         __csr_from_pairs(size_t rows, uint32_t *row_ids, void *values, size_t item_size);
+Csr         __csr_from_arrays(void **rows, size_t item_size);
+void        __csr_append_row(Csr *c, const void *items, size_t count);
+ArrayView   __csr_row(Csr c, size_t row);
+
+/**
+ * @brief Frees the offsets and values of a Csr.
+ *
+ * @param c Pointer to the Csr; it is left empty and must not be used again.
+ */
+void csr_destroy(Csr *c);
+
+/**
+ * @brief Creates a Csr with no rows for elements of type `T`.
+ *
+ * Rows are then added in order with `csr_append_row`.
+ *
+ * @tparam T The element type.
+ * @return The new Csr.
+ */
+#define csr_create(T)                   (__csr_create(sizeof(T)))
+
+/**
+ * @brief Builds a Csr from parallel arrays of row indices and values, with a counting sort.
+ *
+ * Element `i` goes to row `row_ids[i]`; within a row, elements keep their
+ * order in the input. For an edge list, `row_ids` holds the source vertices
+ * and `values` the targets. Runs in O(rows + n). Large inputs are split into
+ * chunks that are counted and scattered on the shared scheduler
+ * (scheduler.h), whose implementation must be compiled into the program.
+ *
+ * Example:
+ * ```c
+ * Csr(uint32_t) g = csr_from_pairs(uint32_t, vertices, edge_src, edge_dst);
+ * ```
+ *
+ * @tparam T       The element type.
+ * @param rows     Number of rows; every row index must be smaller.
+ * @param row_ids  Array(uint32_t) of row indices.
+ * @param values   Array(T) of the same length.
+ * @return The new Csr.
+ */
+#define csr_from_pairs(T, rows, row_ids, values) \
+    (__csr_from_pairs(rows, row_ids, values, sizeof(T)))
+
+/**
+ * @brief Packs an `Array` of `Array(T)` rows into a Csr.
+ *
+ * Large inputs are copied in parallel on the shared scheduler. The rows are
+ * not freed.
+ *
+ * @tparam T    The element type.
+ * @param rows  Array(Array(T)) of rows.
+ * @return The new Csr.
+ */
+#define csr_from_arrays(T, rows)        (__csr_from_arrays((void **)(rows), sizeof(T)))
+
+/**
+ * @brief Appends a row holding a copy of `n` elements.
+ *
+ * @tparam T      The element type.
+ * @param c       Pointer to the Csr.
+ * @param items   Pointer to `n` elements.
+ * @param n       Number of elements; 0 adds an empty row.
+ */
+#define csr_append_row(T, c, items, n)  (__csr_append_row(c, items, n))
+
+/**
+ * @brief Returns the number of rows.
+ */
+#define csr_rows(c)                     (array_length((c).offsets) - 1)
+
+/**
+ * @brief Returns the total number of elements over all rows.
+ */
+#define csr_length(c)                   (array_length((c).values))
+
+/**
+ * @brief Returns the number of elements in row `r`, without bounds checking.
+ */
+#define csr_row_length(c, r)            ((c).offsets[(r) + 1] - (c).offsets[r])
+
+/**
+ * @brief Returns a pointer to the first element of row `r`, without bounds checking.
+ *
+ * @tparam T The element type.
+ * @param c  The Csr.
+ * @param r  Index of the row.
+ * @return Pointer to `csr_row_length(c, r)` contiguous elements.
+ */
+#define csr_row_data(T, c, r)           ((T *)(c).values + (c).offsets[r])
+
+/**
+ * @brief Returns a view of row `r`, checking the index.
+ *
+ * Example:
+ * ```c
+ * ArrayView(uint32_t) adj = csr_row(uint32_t, g, v);
+ * if(av_contains(uint32_t, adj, w)) ...
+ * ```
+ *
+ * @tparam T The element type.
+ * @param c  The Csr.
+ * @param r  Index of the row.
+ * @return An ArrayView into the values; valid until the Csr is modified.
+ */
+#define csr_row(T, c, r)                (__csr_row(c, r))
+
+/**
+ * @brief Iterates over the elements of row `r` with a `T *` cursor, without bounds checking.
+ *
+ * Example:
+ * ```c
+ * csr_foreach(uint32_t, g, v, w) degree_in[*w] += 1;
+ * ```
+ */
+#define csr_foreach(T, c, r, it) \
+    for(T *it = csr_row_data(T, c, r), *it##_end = it + csr_row_length(c, r); it < it##_end; ++it)
+
+
+#ifdef COLLECTIONS_CSR_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+// Inputs below this many elements are built on the calling thread.
+#define __CSR_PARALLEL_THRESHOLD    (1 << 16)
+// Fewest elements worth a chunk of their own in the parallel counting sort.
+#define __CSR_MIN_CHUNK_ITEMS       (1 << 15)
+
+/**
+ * @brief State of one parallel build.
+ *
+ * In `__csr_from_pairs`, `counts` holds one histogram of `rows` entries per
+ * chunk; the histograms are turned in place into each chunk's write cursor
+ * for every row, so chunks scatter into disjoint slots without locking.
+ */
+typedef struct {
+    const uint32_t  *row_ids;
+    const char      *in;
+    char            *out;
+    void            **lists;
+    size_t          *offsets;
+    size_t          *counts;
+    uint8_t         *bad;       // per chunk: a row index was out of range
+    size_t          n;
+    size_t          rows;
+    size_t          chunks;
+    size_t          item_size;
+} CsrBuild;
+
+static Csr __csr_alloc__(size_t rows, size_t count, size_t item_size) {
+    Csr c;
+    c.item_size = item_size;
+    c.offsets   = __array_insert_n(__array_create(sizeof(size_t)), 0, NULL, rows + 1);
+    c.values    = __array_insert_n(__array_create(item_size), 0, NULL, count);
+    c.offsets[0] = 0;
+    return c;
+}
+
+Csr __csr_create(size_t item_size) {
+    return __csr_alloc__(0, 0, item_size);
+}
+
+void csr_destroy(Csr *c) {
+    array_destroy(c->offsets);
+    array_destroy(c->values);
+    c->offsets = NULL;
+    c->values  = NULL;
+}
+
+void __csr_append_row(Csr *c, const void *items, size_t count) {
+    size_t end = c->offsets[array_length(c->offsets) - 1];
+    if(count > 0) c->values = __array_insert_n(c->values, end, items, count);
+    c->offsets = array_append(size_t, c->offsets);
+    c->offsets[array_length(c->offsets) - 1] = end + count;
+}
+
+ArrayView __csr_row(Csr c, size_t row) {
+    if(row >= csr_rows(c)) {
+        fprintf(stderr, "__csr_row failed: row out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+    return av((char *)c.values + c.offsets[row] * c.item_size, csr_row_length(c, row), c.item_size);
+}
+
+#define __csr_chunk_range__(b, c, lo, hi)                                                   \
+    size_t lo = (b)->n * (c) / (b)->chunks;                                                 \
+    size_t hi = (b)->n * ((c) + 1) / (b)->chunks
+
+static void __csr_count_chunks__(void *arg, size_t first, size_t last) {
+    CsrBuild *b = arg;
+    const uint32_t *row_ids = b->row_ids;
+    size_t rows = b->rows;
+    for(size_t c = first; c < last; ++c) {
+        __csr_chunk_range__(b, c, lo, hi);
+        size_t *counts = b->counts + c * rows;
+        // Locals keep the stores to `counts` from forcing reloads of `b`.
+        for(size_t i = lo; i < hi; ++i) {
+            uint32_t r = row_ids[i];
+            if(r >= rows) {
+                b->bad[c] = 1;
+                return;
+            }
+            counts[r] += 1;
+        }
+    }
+}
+
+// Row lengths: the sum of every chunk's count for the row.
+static void __csr_sum_rows__(void *arg, size_t lo, size_t hi) {
+    CsrBuild *b = arg;
+    for(size_t r = lo; r < hi; ++r) {
+        size_t total = 0;
+        for(size_t c = 0; c < b->chunks; ++c) total += b->counts[c * b->rows + r];
+        b->offsets[r + 1] = total;
+    }
+}
+
+// Chunk c writes its elements of row r from where chunks 0 .. c-1 stop.
+static void __csr_cursors__(void *arg, size_t lo, size_t hi) {
+    CsrBuild *b = arg;
+    for(size_t r = lo; r < hi; ++r) {
+        size_t pos = b->offsets[r];
+        for(size_t c = 0; c < b->chunks; ++c) {
+            size_t count = b->counts[c * b->rows + r];
+            b->counts[c * b->rows + r] = pos;
+            pos += count;
+        }
+    }
+}
+
+#define __csr_scatter__(T)                                                                  \
+    for(size_t i = lo; i < hi; ++i) ((T *)out)[cursor[row_ids[i]]++] = ((const T *)in)[i]
+
+static void __csr_scatter_chunks__(void *arg, size_t first, size_t last) {
+    CsrBuild *b = arg;
+    const uint32_t *row_ids = b->row_ids;
+    const char *in = b->in;
+    char *out = b->out;
+    size_t size = b->item_size;
+    for(size_t c = first; c < last; ++c) {
+        __csr_chunk_range__(b, c, lo, hi);
+        size_t *cursor = b->counts + c * b->rows;
+        if(size == 4) __csr_scatter__(uint32_t);
+        else if(size == 8) __csr_scatter__(uint64_t);
+        else {
+            for(size_t i = lo; i < hi; ++i) memcpy(out + cursor[row_ids[i]]++ * size, in + i * size, size);
+        }
+    }
+}
+
+// Runs body over [0, n) on the shared scheduler, or inline when `parallel` is false.
+static void __csr_for__(bool parallel, size_t n, void (*body)(void *, size_t, size_t), void *ctx) {
+    if(parallel) scheduler_parallel_for(0, n, 0, body, ctx);
+    else body(ctx, 0, n);
+}
+
+Csr __csr_from_pairs(size_t rows, uint32_t *row_ids, void *values, size_t item_size) {
+    size_t count = array_length(row_ids);
+    if(count != array_length(values)) {
+        fprintf(stderr, "__csr_from_pairs failed: row_ids and values differ in length.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    CsrBuild b = {
+        .row_ids = row_ids, .in = values, .n = count, .rows = rows, .chunks = 1, .item_size = item_size,
+    };
+
+    // One histogram per chunk, and never more histogram entries than elements,
+    // so a graph with few edges per vertex is not dominated by the counting.
+    bool parallel = count >= __CSR_PARALLEL_THRESHOLD && rows > 0;
+    if(parallel) {
+        size_t chunks  = count / __CSR_MIN_CHUNK_ITEMS;
+        size_t workers = scheduler_workers();
+        if(chunks > workers) chunks = workers;
+        if(chunks > count / rows) chunks = count / rows;
+        b.chunks = chunks > 1 ? chunks : 1;
+        parallel = b.chunks > 1;
+    }
+
+    Csr c = __csr_alloc__(rows, count, item_size);
+    b.offsets = c.offsets;
+    b.out     = c.values;
+    b.counts  = calloc(b.chunks * rows > 0 ? b.chunks * rows : 1, sizeof(size_t));
+    b.bad     = calloc(b.chunks, 1);
+    if(!b.counts || !b.bad) {
+        fprintf(stderr, "__csr_from_pairs failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    __csr_for__(parallel, b.chunks, __csr_count_chunks__, &b);
+    for(size_t k = 0; k < b.chunks; ++k) {
+        if(b.bad[k]) {
+            fprintf(stderr, "__csr_from_pairs failed: row index out of range.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    __csr_for__(parallel, rows, __csr_sum_rows__, &b);
+    for(size_t r = 0; r < rows; ++r) c.offsets[r + 1] += c.offsets[r];
+    __csr_for__(parallel, rows, __csr_cursors__, &b);
+    __csr_for__(parallel, b.chunks, __csr_scatter_chunks__, &b);
+
+    free(b.counts);
+    free(b.bad);
+    return c;
+}
+
+static void __csr_copy_rows__(void *arg, size_t lo, size_t hi) {
+    CsrBuild *b = arg;
+    for(size_t r = lo; r < hi; ++r) {
+        size_t n = b->offsets[r + 1] - b->offsets[r];
+        if(n > 0) memcpy(b->out + b->offsets[r] * b->item_size, b->lists[r], n * b->item_size);
+    }
+}
+
+Csr __csr_from_arrays(void **rows, size_t item_size) {
+    size_t n = array_length(rows);
+    size_t total = 0;
+    for(size_t r = 0; r < n; ++r) total += array_length(rows[r]);
+
+    Csr c = __csr_alloc__(n, total, item_size);
+    for(size_t r = 0; r < n; ++r) c.offsets[r + 1] = c.offsets[r] + array_length(rows[r]);
+
+    CsrBuild b = { .lists = rows, .offsets = c.offsets, .out = c.values, .item_size = item_size };
+    __csr_for__(total >= __CSR_PARALLEL_THRESHOLD, n, __csr_copy_rows__, &b);
+    return c;
+}
+
+#endif // COLLECTIONS_CSR_IMPLEMENTATION
+#endif // COLLECTIONS_CSR_H
@@ -0,0 +1,686 @@
+#ifndef COLLECTIONS_EXTSORT_H
+#define COLLECTIONS_EXTSORT_H
+
+// The implementation uses pread, pwrite, mkstemp, fchmod and fsync, which
+// strict ISO modes (-std=c11) hide. Feature macros only count before the first
+// system header, so the file compiling the implementation should include
+// extsort.h first.
+#if defined(COLLECTIONS_EXTSORT_IMPLEMENTATION) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 700
+#endif
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/**
+ * @brief Memory budget used when 0 is passed to `extsort_create`: 256 MiB.
+ */
+#define EXTSORT_DEFAULT_MEMORY      ((size_t)256 << 20)
+
+/**
+ * @brief An external sorter of fixed-size records. Opaque.
+ */
+typedef struct ExtSort ExtSort;
+
+/**
+ * @brief Creates an external sorter for records of `item_size` bytes.
+ *
+ * Records are collected into in-memory runs of about a third of the budget.
+ * A full run is handed to a background thread, which sorts it with
+ * `array_sort` and appends it to a temporary spill file while the caller
+ * keeps filling the next run. `extsort_finish` then merges the runs with a
+ * loser tree, reading each through a large sequential buffer. When there are
+ * too many runs for the budget to give each buffer at least 512 KiB, the
+ * smallest runs are merged first in extra passes. Input that fits in a single
+ * run is sorted in memory and never touches the disk.
+ *
+ * The spill file is created in `tmp_dir` (or `$TMPDIR`, or `/tmp`) and
+ * unlinked right away, so it disappears even if the process dies. It may grow
+ * to about twice the input when extra merge passes are needed.
+ *
+ * Example:
+ * ```c
+ * ExtSort *s = extsort_create(sizeof(Record), cmp_record, (size_t)1 << 30, NULL);
+ * while(read_batch(batch)) extsort_add_array(s, batch);
+ * if(!extsort_finish(s, write_records, out)) perror("extsort_finish");
+ * extsort_destroy(s);
+ * ```
+ *
+ * @param item_size Size of one record in bytes.
+ * @param cmp       Comparison function with the `qsort` contract.
+ * @param memory    Memory budget in bytes, or 0 for `EXTSORT_DEFAULT_MEMORY`.
+ * @param tmp_dir   Directory for the spill file, or NULL.
+ * @return A new sorter; exits the program if it cannot be allocated.
+ */
+ExtSort *extsort_create(size_t item_size, int (*cmp)(const void *, const void *),
+                        size_t memory, const char *tmp_dir);
+
+/**
+ * @brief Adds `n` records to the sorter.
+ *
+ * Blocks only while the previous run is still being sorted and written.
+ *
+ * @param s     The sorter.
+ * @param items `n` consecutive records.
+ * @param n     Number of records.
+ * @return true on success; false with `errno` set if spilling failed.
+ */
+bool extsort_add(ExtSort *s, const void *items, size_t n);
+
+/**
+ * @brief Adds every element of an array.h array to the sorter.
+ *
+ * @param s The sorter.
+ * @param p Pointer to the array; its elements must be `item_size` bytes.
+ * @return true on success.
+ */
+#define extsort_add_array(s, p)     (extsort_add(s, p, array_length(p)))
+
+/**
+ * @brief Merges everything added so far and passes the records to `sink` in sorted order.
+ *
+ * `sink` receives consecutive batches of records, one call at a time and in
+ * order, possibly from the sorter's background thread; it returns false
+ * (with `errno` set) to abort. Records that compare equal keep no particular
+ * order. After this call the sorter can only be destroyed.
+ *
+ * @param s    The sorter.
+ * @param sink Consumer of sorted batches.
+ * @param ctx  Opaque pointer passed to `sink`.
+ * @return true on success; false with `errno` set otherwise.
+ */
+bool extsort_finish(ExtSort *s, bool (*sink)(const void *items, size_t n, void *ctx), void *ctx);
+
+/**
+ * @brief Destroys a sorter and releases its memory and spill file.
+ *
+ * @param s The sorter.
+ */
+void extsort_destroy(ExtSort *s);
+
+/**
+ * @brief Sorts a file of raw fixed-size records into another file.
+ *
+ * The output is written under a unique temporary name next to `output`,
+ * flushed to disk and renamed over it, and the directory is flushed after the
+ * rename, so readers never see a partial file, even after a crash. A replaced
+ * file keeps its permissions; a new one gets 0666 less the umask. `input` and
+ * `output` may be the same path.
+ *
+ * Example:
+ * ```c
+ * if(!extsort_file("events.bin", "events.sorted", sizeof(Event), cmp_event, 0, NULL)) perror("extsort_file");
+ * ```
+ *
+ * @param input     File holding a whole number of records.
+ * @param output    Destination file.
+ * @param item_size Size of one record in bytes.
+ * @param cmp       Comparison function with the `qsort` contract.
+ * @param memory    Memory budget in bytes, or 0 for `EXTSORT_DEFAULT_MEMORY`.
+ * @param tmp_dir   Directory for the spill file, or NULL.
+ * @return true on success; false with `errno` set otherwise (`EINVAL` if the
+ *         input size is not a multiple of `item_size`).
+ */
+bool extsort_file(const char *input, const char *output, size_t item_size,
+                  int (*cmp)(const void *, const void *), size_t memory, const char *tmp_dir);
+
+
+#ifdef COLLECTIONS_EXTSORT_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define __EXTSORT_MIN_BUFFER        ((size_t)512 << 10)
+#define __EXTSORT_FILE_CHUNK        ((size_t)1 << 20)
+
+/**
+ * @brief A sorted run in the spill file.
+ */
+typedef struct {
+    uint64_t    offset; // byte offset of the first record
+    uint64_t    length; // number of records
+} ExtSortRun;
+
+struct ExtSort {
+    size_t          item_size;
+    int             (*cmp)(const void *, const void *);
+    size_t          memory;
+    char            *tmp_dir;
+    size_t          run_items;  // capacity of one run buffer
+
+    void            *fill;      // Array the caller is filling
+    void            *spare;     // Array owned by the background thread while it spills
+    ExtSortRun      *runs;      // Array of runs in the spill file
+    int             fd;         // unlinked spill file, -1 until the first spill
+    uint64_t        end;        // bytes written to the spill file
+
+    // Background thread and its single job slot. Everything below `cond` is
+    // written by the caller only while the thread is idle.
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    void            (*job)(ExtSort *s); // pending or running job, NULL when idle
+    bool            stop;
+    int             error;      // first errno seen by either thread
+
+    void            *job_items;
+    size_t          job_count;
+    bool            (*sink)(const void *items, size_t n, void *ctx);
+    void            *sink_ctx;
+};
+
+static void *__extsort_thread__(void *arg) {
+    ExtSort *s = arg;
+    pthread_mutex_lock(&s->lock);
+    for(;;) {
+        while(!s->job && !s->stop) pthread_cond_wait(&s->cond, &s->lock);
+        if(!s->job) break;
+
+        void (*job)(ExtSort *) = s->job;
+        pthread_mutex_unlock(&s->lock);
+        job(s);
+        pthread_mutex_lock(&s->lock);
+
+        s->job = NULL;
+        pthread_cond_broadcast(&s->cond);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+// Waits until the background thread is idle; returns the first error so far.
+static int __extsort_wait__(ExtSort *s) {
+    pthread_mutex_lock(&s->lock);
+    while(s->job) pthread_cond_wait(&s->cond, &s->lock);
+    int error = s->error;
+    pthread_mutex_unlock(&s->lock);
+    return error;
+}
+
+// Hands one job to the background thread, after the previous one is done.
+static int __extsort_submit__(ExtSort *s, void (*job)(ExtSort *), void *items, size_t count) {
+    int error = __extsort_wait__(s);
+    if(error) return error;
+
+    s->job_items = items;
+    s->job_count = count;
+
+    pthread_mutex_lock(&s->lock);
+    s->job = job;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    return 0;
+}
+
+static void __extsort_fail__(ExtSort *s, int error) {
+    pthread_mutex_lock(&s->lock);
+    if(!s->error) s->error = error ? error : EIO;
+    pthread_mutex_unlock(&s->lock);
+}
+
+static bool __extsort_pwrite__(int fd, const void *data, size_t size, uint64_t offset) {
+    const char *p = data;
+    while(size > 0) {
+        ssize_t w = pwrite(fd, p, size, (off_t)offset);
+        if(w < 0) {
+            if(errno == EINTR) continue;
+            return false;
+        }
+        p      += w;
+        size   -= (size_t)w;
+        offset += (uint64_t)w;
+    }
+    return true;
+}
+
+static bool __extsort_pread__(int fd, void *data, size_t size, uint64_t offset) {
+    char *p = data;
+    while(size > 0) {
+        ssize_t r = pread(fd, p, size, (off_t)offset);
+        if(r < 0 && errno == EINTR) continue;
+        if(r <= 0) {
+            if(r == 0) errno = EIO;
+            return false;
+        }
+        p      += r;
+        size   -= (size_t)r;
+        offset += (uint64_t)r;
+    }
+    return true;
+}
+
+// Appends a batch of records to the spill file; the sink of intermediate merges.
+static bool __extsort_append__(const void *items, size_t n, void *ctx) {
+    ExtSort *s = ctx;
+    size_t bytes = n * s->item_size;
+    if(!__extsort_pwrite__(s->fd, items, bytes, s->end)) return false;
+    s->end += bytes;
+    return true;
+}
+
+// Background job: sorts a full run buffer and appends it to the spill file.
+static void __extsort_spill_job__(ExtSort *s) {
+    void *run = s->job_items;
+    size_t n  = __array_length(run);
+    __array_sort(run, s->cmp);
+
+    uint64_t offset = s->end;
+    if(!__extsort_append__(run, n, s)) {
+        __extsort_fail__(s, errno);
+        return;
+    }
+    s->runs = array_append(ExtSortRun, s->runs);
+    s->runs[__array_length(s->runs) - 1] = (ExtSortRun){ .offset = offset, .length = n };
+}
+
+// Background job: passes a batch of merged records to the current sink.
+static void __extsort_emit_job__(ExtSort *s) {
+    if(!s->sink(s->job_items, s->job_count, s->sink_ctx)) __extsort_fail__(s, errno);
+}
+
+static bool __extsort_open__(ExtSort *s) {
+    const char *dir = s->tmp_dir;
+    if(!dir) dir = getenv("TMPDIR");
+    if(!dir || !*dir) dir = "/tmp";
+
+    size_t len = strlen(dir);
+    char *path = malloc(len + sizeof("/extsort-XXXXXX"));
+    if(!path) return false;
+    memcpy(path, dir, len);
+    memcpy(path + len, "/extsort-XXXXXX", sizeof("/extsort-XXXXXX"));
+
+    s->fd = mkstemp(path);
+    if(s->fd >= 0) unlink(path);
+    free(path);
+    return s->fd >= 0;
+}
+
+// Hands the filled run to the background thread and continues in the spare buffer.
+static bool __extsort_flush__(ExtSort *s) {
+    if(s->fd < 0 && !__extsort_open__(s)) return false;
+
+    int error = __extsort_wait__(s);
+    if(error) {
+        errno = error;
+        return false;
+    }
+    if(!s->spare) s->spare = __array_reserve(__array_create(s->item_size), s->run_items);
+
+    void *full = s->fill;
+    s->fill    = s->spare;
+    s->spare   = full;
+    __array_clear(s->fill);
+    __extsort_submit__(s, __extsort_spill_job__, full, 0);
+    return true;
+}
+
+ExtSort *extsort_create(size_t item_size, int (*cmp)(const void *, const void *),
+                        size_t memory, const char *tmp_dir) {
+    ExtSort *s = calloc(1, sizeof(ExtSort));
+    size_t len = tmp_dir ? strlen(tmp_dir) + 1 : 0;
+    char *dir  = tmp_dir ? malloc(len) : NULL;
+    if(!s || item_size == 0 || (tmp_dir && !dir)) {
+        fprintf(stderr, "extsort_create failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    if(dir) memcpy(dir, tmp_dir, len);
+
+    // One run being filled, one being sorted and the sort's merge buffer.
+    s->item_size = item_size;
+    s->cmp       = cmp;
+    s->memory    = memory ? memory : EXTSORT_DEFAULT_MEMORY;
+    s->tmp_dir   = dir;
+    s->run_items = s->memory / 3 / item_size;
+    if(s->run_items == 0) s->run_items = 1;
+
+    s->fill = __array_reserve(__array_create(item_size), s->run_items);
+    s->runs = array_create(ExtSortRun);
+    s->fd   = -1;
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    if(pthread_create(&s->thread, NULL, __extsort_thread__, s) != 0) {
+        fprintf(stderr, "extsort_create failed: cannot start background thread.\n");
+        exit(EXIT_FAILURE);
+    }
+    return s;
+}
+
+bool extsort_add(ExtSort *s, const void *items, size_t n) {
+    const char *p = items;
+    while(n > 0) {
+        size_t have = __array_length(s->fill);
+        size_t take = s->run_items - have;
+        if(take > n) take = n;
+
+        s->fill = __array_insert_n(s->fill, have, p, take);
+        p += take * s->item_size;
+        n -= take;
+
+        if(have + take == s->run_items && !__extsort_flush__(s)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read side of one run during a merge.
+ */
+typedef struct {
+    const char  *cur;       // next record, NULL once the run is exhausted
+    const char  *end;       // end of the buffered records
+    char        *buffer;
+    uint64_t    offset;     // spill file offset of the first unbuffered record
+    uint64_t    left;       // records not yet buffered
+} ExtSortReader;
+
+static bool __extsort_refill__(ExtSort *s, ExtSortReader *r, size_t capacity) {
+    if(r->left == 0) {
+        r->cur = NULL;
+        return true;
+    }
+
+    size_t n     = r->left < capacity ? (size_t)r->left : capacity;
+    size_t bytes = n * s->item_size;
+    if(!__extsort_pread__(s->fd, r->buffer, bytes, r->offset)) return false;
+
+    r->cur     = r->buffer;
+    r->end     = r->buffer + bytes;
+    r->offset += bytes;
+    r->left   -= n;
+    return true;
+}
+
+// True if the head of run `a` goes before the head of run `b`; exhausted runs
+// lose to everything and ties go to the earlier run.
+static inline bool __extsort_before__(ExtSort *s, const ExtSortReader *readers, size_t a, size_t b) {
+    if(!readers[a].cur) return false;
+    if(!readers[b].cur) return true;
+    int c = s->cmp(readers[a].cur, readers[b].cur);
+    return c < 0 || (c == 0 && a < b);
+}
+
+// Replays the matches from leaf `leaf` to the root of the loser tree. Internal
+// node t holds the loser of its match and tree[0] the overall winner. During
+// construction `k` marks a node nobody has reached yet; it beats every run,
+// so it moves up unchanged until the last leaf is played.
+static inline void __extsort_replay__(ExtSort *s, const ExtSortReader *readers, size_t *tree, size_t k, size_t leaf) {
+    size_t winner = leaf;
+    for(size_t t = (leaf + k) / 2; t > 0; t /= 2) {
+        if(winner == k) continue;
+        if(tree[t] == k || __extsort_before__(s, readers, tree[t], winner)) {
+            size_t loser = winner;
+            winner  = tree[t];
+            tree[t] = loser;
+        }
+    }
+    tree[0] = winner;
+}
+
+// Merges `k` runs and feeds the result through `sink` on the background thread.
+static bool __extsort_merge__(ExtSort *s, const ExtSortRun *runs, size_t k,
+                              bool (*sink)(const void *, size_t, void *), void *ctx) {
+    size_t size     = s->item_size;
+    size_t capacity = s->memory / (k + 2) / size;
+    if(capacity == 0) capacity = 1;
+
+    ExtSortReader *readers = calloc(k, sizeof(ExtSortReader));
+    size_t *tree           = malloc(k * sizeof(size_t));
+    char *memory           = malloc((k + 2) * capacity * size);
+    if(!readers || !tree || !memory) {
+        free(readers);
+        free(tree);
+        free(memory);
+        return false;
+    }
+
+    int error = __extsort_wait__(s);
+    s->sink     = sink;
+    s->sink_ctx = ctx;
+
+    for(size_t i = 0; i < k && !error; ++i) {
+        readers[i].buffer = memory + i * capacity * size;
+        readers[i].offset = runs[i].offset;
+        readers[i].left   = runs[i].length;
+        if(!__extsort_refill__(s, &readers[i], capacity)) error = errno;
+    }
+
+    for(size_t i = 0; i < k; ++i) tree[i] = k;
+    for(size_t i = k; i-- > 0;) __extsort_replay__(s, readers, tree, k, i);
+
+    char *out[2]  = { memory + k * capacity * size, memory + (k + 1) * capacity * size };
+    int current   = 0;
+    size_t filled = 0;
+
+    while(!error) {
+        size_t w = tree[0];
+        ExtSortReader *r = &readers[w];
+        if(!r->cur) break;
+
+        if(k == 1) {
+            // A single run: move whole buffers instead of single records.
+            size_t n = (size_t)(r->end - r->cur) / size;
+            error = __extsort_submit__(s, __extsort_emit_job__, (void *)r->cur, n);
+            if(!error) error = __extsort_wait__(s);
+            if(!error && !__extsort_refill__(s, r, capacity)) error = errno;
+            continue;
+        }
+
+        memcpy(out[current] + filled * size, r->cur, size);
+        if(++filled == capacity) {
+            error   = __extsort_submit__(s, __extsort_emit_job__, out[current], filled);
+            current ^= 1;
+            filled  = 0;
+        }
+
+        r->cur += size;
+        if(r->cur == r->end && !__extsort_refill__(s, r, capacity)) error = errno;
+        __extsort_replay__(s, readers, tree, k, w);
+    }
+
+    if(!error && filled > 0) error = __extsort_submit__(s, __extsort_emit_job__, out[current], filled);
+    int pending = __extsort_wait__(s);
+    if(!error) error = pending;
+
+    free(readers);
+    free(tree);
+    free(memory);
+    errno = error;
+    return error == 0;
+}
+
+bool extsort_finish(ExtSort *s, bool (*sink)(const void *items, size_t n, void *ctx), void *ctx) {
+    if(s->fd < 0) {
+        // Everything fit in one run: sort it in memory.
+        size_t n = __array_length(s->fill);
+        __array_sort(s->fill, s->cmp);
+        return n == 0 || sink(s->fill, n, ctx);
+    }
+
+    if(__array_length(s->fill) > 0 && !__extsort_flush__(s)) return false;
+    int error = __extsort_wait__(s);
+    if(error) {
+        errno = error;
+        return false;
+    }
+
+    // The run buffers are no longer needed; give their memory to the merge.
+    __array_clear(s->fill);
+    __array_destroy(s->fill);
+    s->fill = NULL;
+    if(s->spare) __array_destroy(s->spare);
+    s->spare = NULL;
+
+    size_t fan_in = s->memory / __EXTSORT_MIN_BUFFER;
+    fan_in = fan_in > 4 ? fan_in - 2 : 2;
+
+    // Merge just enough of the oldest (smallest) runs that one final pass of
+    // at most `fan_in` runs remains.
+    while(__array_length(s->runs) > fan_in) {
+        size_t count = __array_length(s->runs);
+        size_t k     = count - fan_in + 1 < fan_in ? count - fan_in + 1 : fan_in;
+
+        uint64_t offset = s->end;
+        uint64_t length = 0;
+        for(size_t i = 0; i < k; ++i) length += s->runs[i].length;
+
+        if(!__extsort_merge__(s, s->runs, k, __extsort_append__, s)) return false;
+        __array_remove_range(s->runs, 0, k);
+        s->runs = array_append(ExtSortRun, s->runs);
+        s->runs[__array_length(s->runs) - 1] = (ExtSortRun){ .offset = offset, .length = length };
+    }
+
+    return __extsort_merge__(s, s->runs, __array_length(s->runs), sink, ctx);
+}
+
+void extsort_destroy(ExtSort *s) {
+    pthread_mutex_lock(&s->lock);
+    s->stop = true;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->thread, NULL);
+
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->cond);
+    if(s->fd >= 0) close(s->fd);
+    if(s->fill) __array_destroy(s->fill);
+    if(s->spare) __array_destroy(s->spare);
+    __array_destroy(s->runs);
+    free(s->tmp_dir);
+    free(s);
+}
+
+typedef struct {
+    FILE    *file;
+    size_t  item_size;
+} ExtSortFileSink;
+
+static bool __extsort_fwrite__(const void *items, size_t n, void *ctx) {
+    ExtSortFileSink *sink = ctx;
+    return fwrite(items, sink->item_size, n, sink->file) == n;
+}
+
+// Feeds every record of `path` to the sorter; returns 0 or an errno value.
+static int __extsort_read_file__(ExtSort *s, const char *path) {
+    FILE *in = fopen(path, "rb");
+    if(!in) return errno;
+
+    size_t size  = s->item_size;
+    size_t chunk = __EXTSORT_FILE_CHUNK / size ? __EXTSORT_FILE_CHUNK / size : 1;
+    char *buffer = malloc(chunk * size);
+    int error    = buffer ? 0 : ENOMEM;
+
+    while(!error) {
+        size_t got = fread(buffer, 1, chunk * size, in);
+        if(got % size != 0) {
+            error = EINVAL;
+        } else if(got > 0 && !extsort_add(s, buffer, got / size)) {
+            error = errno;
+        }
+        if(got < chunk * size) break;
+    }
+    if(!error && ferror(in)) error = EIO;
+
+    free(buffer);
+    fclose(in);
+    return error;
+}
+
+// Creates `<path>.XXXXXX` under a fresh unique name with the mode of the file
+// it will replace, or 0666 less the umask; returns a descriptor or -1 and errno.
+static int __extsort_create_tmp__(const char *path, char *tmp) {
+    static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    struct stat st;
+    bool replace = stat(path, &st) == 0;
+    size_t len   = strlen(path);
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".XXXXXX", sizeof(".XXXXXX"));
+
+    // O_EXCL makes the name unique; the seed only keeps collisions rare.
+    uint64_t seed = (uint64_t)(uintptr_t)tmp ^ ((uint64_t)getpid() << 32) ^ (uint64_t)time(NULL);
+    for(int attempt = 0; attempt < 100; attempt++) {
+        seed = seed * UINT64_C(6364136223846793005) + UINT64_C(1442695040888963407);
+        uint64_t x = seed >> 16;
+        for(size_t i = 0; i < 6; i++, x /= 36) tmp[len + 1 + i] = digits[x % 36];
+
+        int fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, replace ? 0600 : 0666);
+        if(fd < 0 && errno == EEXIST) continue;
+        if(fd >= 0 && replace && fchmod(fd, st.st_mode & 07777) != 0) {
+            int err = errno;
+            close(fd);
+            remove(tmp);
+            errno = err;
+            return -1;
+        }
+        return fd;
+    }
+    errno = EEXIST;
+    return -1;
+}
+
+// Flushes the directory entry of `path` so a rename onto it survives a crash;
+// returns 0 or an errno value. File systems that cannot sync directories pass.
+static int __extsort_sync_dir__(const char *path) {
+    const char *slash = strrchr(path, '/');
+    size_t len = slash ? (size_t)(slash - path) + (slash == path) : 1;
+    char *dir  = malloc(len + 1);
+    if(!dir) return ENOMEM;
+    memcpy(dir, slash ? path : ".", len);
+    dir[len] = '\0';
+
+    int fd    = open(dir, O_RDONLY | O_DIRECTORY);
+    int error = fd < 0 ? errno : 0;
+    if(fd >= 0 && fsync(fd) != 0 && errno != EINVAL) error = errno;
+    if(fd >= 0) close(fd);
+    free(dir);
+    return error;
+}
+
+bool extsort_file(const char *input, const char *output, size_t item_size,
+                  int (*cmp)(const void *, const void *), size_t memory, const char *tmp_dir) {
+    ExtSort *s = extsort_create(item_size, cmp, memory, tmp_dir);
+    int error  = __extsort_read_file__(s, input);
+
+    // Written under a unique name next to `output`, synced, then renamed over it.
+    char *tmp = malloc(strlen(output) + sizeof(".XXXXXX"));
+    FILE *out = NULL;
+    int fd    = -1;
+    if(!error && !tmp) error = ENOMEM;
+    if(!error) {
+        fd = __extsort_create_tmp__(output, tmp);
+        out = fd >= 0 ? fdopen(fd, "wb") : NULL;
+        if(!out) error = errno;
+        if(!out && fd >= 0) {
+            close(fd);
+            remove(tmp);
+        }
+    }
+
+    if(!error) {
+        ExtSortFileSink sink = { .file = out, .item_size = item_size };
+        if(!extsort_finish(s, __extsort_fwrite__, &sink)) error = errno;
+    }
+    extsort_destroy(s);
+
+    if(out && !error && (fflush(out) != 0 || fsync(fd) != 0)) error = errno;
+    if(out && fclose(out) != 0 && !error) error = errno;
+    if(out && !error && rename(tmp, output) != 0) error = errno;
+    if(out && error) remove(tmp);
+    // The rename is only durable once the directory is on disk as well.
+    if(out && !error) error = __extsort_sync_dir__(output);
+
+    free(tmp);
+    errno = error;
+    return error == 0;
+}
+
+#endif // COLLECTIONS_EXTSORT_IMPLEMENTATION
+#endif // COLLECTIONS_EXTSORT_H
@@ -0,0 +1,119 @@
+#ifndef COLLECTIONS_HEAP_H
+#define COLLECTIONS_HEAP_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "array.h"
+
+/**
+ * @brief Generates a typed d-ary min-heap (priority queue) over array.h storage.
+ *
+ * The heap is a plain `Array(T)` kept in heap order, so it is created with
+ * `array_create(T)`, sized with `array_length` and released with
+ * `array_destroy`. The macro defines `static inline` functions whose names
+ * start with `name`:
+ *
+ * - `Array(T) name_push(Array(T) heap, T value)` — O(log n), may reallocate.
+ * - `T name_pop(Array(T) heap)` — removes and returns the top, O(d log n).
+ * - `T name_peek(Array(T) heap)` — returns the top without removing it.
+ * - `void name_heapify(Array(T) heap)` — restores heap order in O(n) after
+ *   the array was filled or modified directly.
+ *
+ * `less(a, b)` receives two values of type `T` and must return non-zero when
+ * `a` has higher priority than `b`; the element for which it is true against
+ * every other one is at the top. It can be a function or a function-like
+ * macro, and is inlined at every call site, unlike a `qsort` comparator.
+ *
+ * `arity` is the number of children per node, 2 or 4. A 4-ary heap is half
+ * as deep and its four children share one cache line for small `T`, which
+ * usually makes pops faster despite the extra comparisons.
+ *
+ * Sifting moves a hole instead of swapping, so each level costs one copy.
+ * The array.h implementation must be compiled into the program.
+ *
+ * Example:
+ * ```c
+ * typedef struct { uint64_t deadline; int task; } Event;
+ * #define event_less(a, b) ((a).deadline < (b).deadline)
+ * HEAP_DEFINE(events, Event, event_less, 4)
+ *
+ * Array(Event) q = array_create(Event);
+ * q = events_push(q, (Event){ .deadline = 30, .task = 1 });
+ * q = events_push(q, (Event){ .deadline = 10, .task = 2 });
+ * Event next = events_pop(q); // deadline 10
+ * ```
+ *
+ * @param name  Prefix of the generated functions.
+ * @param T     The element type.
+ * @param less  Comparator `less(a, b)` on values of type `T`.
+ * @param arity Children per node: 2 or 4.
+ */
+#define HEAP_DEFINE(name, T, less, arity)                                                   \
+_Static_assert((arity) == 2 || (arity) == 4, "HEAP_DEFINE: arity must be 2 or 4");          \
+                                                                                            \
+static inline void __##name##_sift_up__(T *heap, size_t hole, T value) {                    \
+    while(hole > 0) {                                                                       \
+        size_t parent = (hole - 1) / (arity);                                               \
+        if(!less(value, heap[parent])) break;                                               \
+        heap[hole] = heap[parent];                                                          \
+        hole = parent;                                                                      \
+    }                                                                                       \
+    heap[hole] = value;                                                                     \
+}                                                                                           \
+                                                                                            \
+static inline void __##name##_sift_down__(T *heap, size_t n, size_t hole, T value) {        \
+    for(;;) {                                                                               \
+        size_t first = (arity) * hole + 1;                                                  \
+        if(first >= n) break;                                                               \
+                                                                                            \
+        size_t best = first;                                                                \
+        size_t last = first + (arity) < n ? first + (arity) : n;                            \
+        for(size_t c = first + 1; c < last; ++c) {                                          \
+            if(less(heap[c], heap[best])) best = c;                                         \
+        }                                                                                   \
+                                                                                            \
+        if(!less(heap[best], value)) break;                                                 \
+        heap[hole] = heap[best];                                                            \
+        hole = best;                                                                        \
+    }                                                                                       \
+    heap[hole] = value;                                                                     \
+}                                                                                           \
+                                                                                            \
+static inline T *name##_push(T *heap, T value) {                                            \
+    heap = array_append(T, heap);                                                           \
+    __##name##_sift_up__(heap, array_length(heap) - 1, value);                              \
+    return heap;                                                                            \
+}                                                                                           \
+                                                                                            \
+static inline T name##_peek(T *heap) {                                                      \
+    if(array_length(heap) == 0) {                                                           \
+        fprintf(stderr, #name "_peek failed: heap is empty.\n");                            \
+        exit(EXIT_FAILURE);                                                                 \
+    }                                                                                       \
+    return heap[0];                                                                         \
+}                                                                                           \
+                                                                                            \
+static inline T name##_pop(T *heap) {                                                       \
+    if(array_length(heap) == 0) {                                                           \
+        fprintf(stderr, #name "_pop failed: heap is empty.\n");                             \
+        exit(EXIT_FAILURE);                                                                 \
+    }                                                                                       \
+    T top  = heap[0];                                                                       \
+    T last = array_pop(T, heap);                                                            \
+    size_t n = array_length(heap);                                                          \
+    if(n > 0) __##name##_sift_down__(heap, n, 0, last);                                     \
+    return top;                                                                             \
+}                                                                                           \
+                                                                                            \
+static inline void name##_heapify(T *heap) {                                                \
+    size_t n = array_length(heap);                                                          \
+    if(n < 2) return;                                                                       \
+    for(size_t i = (n - 2) / (arity) + 1; i-- > 0;) {                                       \
+        __##name##_sift_down__(heap, n, i, heap[i]);                                        \
+    }                                                                                       \
+}
+
+
+#endif // COLLECTIONS_HEAP_H
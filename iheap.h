@@ -0,0 +1,190 @@
+#ifndef COLLECTIONS_IHEAP_H
+#define COLLECTIONS_IHEAP_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "array.h"
+
+/**
+ * @brief Generates a typed indexed d-ary min-heap with decrease-key.
+ *
+ * Every element is identified by a caller-chosen integer id (a vertex number,
+ * a slot index, ...). Next to the heap, an `Array(size_t)` maps each id to its
+ * current heap position, so an element can be found, re-keyed or removed in
+ * O(log n) instead of being pushed again as a duplicate. Ids should be dense,
+ * since the position array is as long as the largest id ever pushed.
+ *
+ * The macro declares two types and a set of `static inline` functions:
+ *
+ * - `name_entry`: `{ K key; size_t id; }`, the heap element. Keys are stored in
+ *   the heap itself so sifting only touches contiguous memory.
+ * - `name`: `{ Array(name_entry) heap; Array(size_t) pos; }`.
+ * - `name name_create(void)` / `void name_destroy(name *q)`.
+ * - `size_t name_length(name *q)`, `bool name_contains(name *q, size_t id)`.
+ * - `void name_push(name *q, size_t id, K key)` — id must not be queued.
+ * - `name_entry name_peek(name *q)` / `name_entry name_pop(name *q)`.
+ * - `K name_key(name *q, size_t id)` — current key of a queued id.
+ * - `void name_update(name *q, size_t id, K key)` — decrease or increase the
+ *   key of a queued id; sifts in whichever direction is needed.
+ * - `void name_set(name *q, size_t id, K key)` — push if absent, else update.
+ * - `void name_remove(name *q, size_t id)` — removes a queued id.
+ *
+ * `less(a, b)` compares two keys and `arity` (2 or 4) has the same meaning
+ * as for `HEAP_DEFINE`. The array.h implementation must be compiled into the
+ * program.
+ *
+ * Example:
+ * ```c
+ * #define dist_less(a, b) ((a) < (b))
+ * IHEAP_DEFINE(frontier, uint32_t, dist_less, 4)
+ *
+ * frontier q = frontier_create();
+ * frontier_push(&q, source, 0);
+ * while (frontier_length(&q) > 0) {
+ *     frontier_entry u = frontier_pop(&q);
+ *     // relax edges: frontier_set(&q, v, u.key + w) when it improves
+ * }
+ * frontier_destroy(&q);
+ * ```
+ *
+ * @param name  Prefix of the generated types and functions.
+ * @param K     The key (priority) type.
+ * @param less  Comparator `less(a, b)` on keys.
+ * @param arity Children per node: 2 or 4.
+ */
+#define IHEAP_DEFINE(name, K, less, arity)                                                  \
+_Static_assert((arity) == 2 || (arity) == 4, "IHEAP_DEFINE: arity must be 2 or 4");         \
+                                                                                            \
+typedef struct {                                                                            \
+    K       key;                                                                            \
+    size_t  id;                                                                             \
+} name##_entry;                                                                             \
+                                                                                            \
+typedef struct {                                                                            \
+    name##_entry    *heap;                                                                  \
+    size_t          *pos;                                                                   \
+} name;                                                                                     \
+                                                                                            \
+static inline void __##name##_sift_up__(name *q, size_t hole, name##_entry e) {             \
+    name##_entry *heap = q->heap;                                                           \
+    while(hole > 0) {                                                                       \
+        size_t parent = (hole - 1) / (arity);                                               \
+        if(!less(e.key, heap[parent].key)) break;                                           \
+        heap[hole] = heap[parent];                                                          \
+        q->pos[heap[hole].id] = hole;                                                       \
+        hole = parent;                                                                      \
+    }                                                                                       \
+    heap[hole] = e;                                                                         \
+    q->pos[e.id] = hole;                                                                    \
+}                                                                                           \
+                                                                                            \
+static inline void __##name##_sift_down__(name *q, size_t hole, name##_entry e) {           \
+    name##_entry *heap = q->heap;                                                           \
+    size_t n = array_length(heap);                                                          \
+    for(;;) {                                                                               \
+        size_t first = (arity) * hole + 1;                                                  \
+        if(first >= n) break;                                                               \
+                                                                                            \
+        size_t best = first;                                                                \
+        size_t last = first + (arity) < n ? first + (arity) : n;                            \
+        for(size_t c = first + 1; c < last; ++c) {                                          \
+            if(less(heap[c].key, heap[best].key)) best = c;                                 \
+        }                                                                                   \
+                                                                                            \
+        if(!less(heap[best].key, e.key)) break;                                             \
+        heap[hole] = heap[best];                                                            \
+        q->pos[heap[hole].id] = hole;                                                       \
+        hole = best;                                                                        \
+    }                                                                                       \
+    heap[hole] = e;                                                                         \
+    q->pos[e.id] = hole;                                                                    \
+}                                                                                           \
+                                                                                            \
+static inline size_t __##name##_position__(name *q, size_t id, const char *fn) {            \
+    if(id >= array_length(q->pos) || q->pos[id] == ARRAY_NPOS) {                            \
+        fprintf(stderr, "%s failed: id is not in the queue.\n", fn);                        \
+        exit(EXIT_FAILURE);                                                                 \
+    }                                                                                       \
+    return q->pos[id];                                                                      \
+}                                                                                           \
+                                                                                            \
+static inline name name##_create(void) {                                                    \
+    name q = { array_create(name##_entry), array_create(size_t) };                          \
+    return q;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline void name##_destroy(name *q) {                                                \
+    array_destroy(q->heap);                                                                 \
+    array_destroy(q->pos);                                                                  \
+}                                                                                           \
+                                                                                            \
+static inline size_t name##_length(name *q) {                                               \
+    return array_length(q->heap);                                                           \
+}                                                                                           \
+                                                                                            \
+static inline bool name##_contains(name *q, size_t id) {                                    \
+    return id < array_length(q->pos) && q->pos[id] != ARRAY_NPOS;                           \
+}                                                                                           \
+                                                                                            \
+static inline void name##_push(name *q, size_t id, K key) {                                 \
+    while(array_length(q->pos) <= id) {                                                     \
+        q->pos = array_append(size_t, q->pos);                                              \
+        q->pos[array_length(q->pos) - 1] = ARRAY_NPOS;                                      \
+    }                                                                                       \
+    if(q->pos[id] != ARRAY_NPOS) {                                                          \
+        fprintf(stderr, #name "_push failed: id is already in the queue.\n");               \
+        exit(EXIT_FAILURE);                                                                 \
+    }                                                                                       \
+    q->heap = array_append(name##_entry, q->heap);                                          \
+    name##_entry e = { key, id };                                                           \
+    __##name##_sift_up__(q, array_length(q->heap) - 1, e);                                  \
+}                                                                                           \
+                                                                                            \
+static inline name##_entry name##_peek(name *q) {                                           \
+    if(array_length(q->heap) == 0) {                                                        \
+        fprintf(stderr, #name "_peek failed: queue is empty.\n");                           \
+        exit(EXIT_FAILURE);                                                                 \
+    }                                                                                       \
+    return q->heap[0];                                                                      \
+}                                                                                           \
+                                                                                            \
+static inline void name##_remove(name *q, size_t id) {                                      \
+    size_t hole = __##name##_position__(q, id, #name "_remove");                            \
+    name##_entry last = array_pop(name##_entry, q->heap);                                   \
+    q->pos[id] = ARRAY_NPOS;                                                                \
+    if(hole == array_length(q->heap)) return;                                               \
+                                                                                            \
+    if(hole > 0 && less(last.key, q->heap[(hole - 1) / (arity)].key)) {                     \
+        __##name##_sift_up__(q, hole, last);                                                \
+    } else {                                                                                \
+        __##name##_sift_down__(q, hole, last);                                              \
+    }                                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline name##_entry name##_pop(name *q) {                                            \
+    name##_entry top = name##_peek(q);                                                      \
+    name##_remove(q, top.id);                                                               \
+    return top;                                                                             \
+}                                                                                           \
+                                                                                            \
+static inline K name##_key(name *q, size_t id) {                                            \
+    return q->heap[__##name##_position__(q, id, #name "_key")].key;                         \
+}                                                                                           \
+                                                                                            \
+static inline void name##_update(name *q, size_t id, K key) {                               \
+    size_t hole = __##name##_position__(q, id, #name "_update");                            \
+    name##_entry e = { key, id };                                                           \
+    if(less(key, q->heap[hole].key)) __##name##_sift_up__(q, hole, e);                      \
+    else __##name##_sift_down__(q, hole, e);                                                \
+}                                                                                           \
+                                                                                            \
+static inline void name##_set(name *q, size_t id, K key) {                                  \
+    if(name##_contains(q, id)) name##_update(q, id, key);                                   \
+    else name##_push(q, id, key);                                                           \
+}
+
+
+#endif // COLLECTIONS_IHEAP_H
@@ -0,0 +1,340 @@
+#ifndef COLLECTIONS_MPMC_H
+#define COLLECTIONS_MPMC_H
+
+
+#include <stdio.h>
+#include <stdbool.h>
+
+void        *__mpmc_create(size_t item_size, size_t capacity);
+bool        __mpmc_push(void *queue, const void *item);
+bool        __mpmc_pop(void *queue, void *out);
+void        __mpmc_push_wait(void *queue, const void *item);
+void        __mpmc_pop_wait(void *queue, void *out);
+size_t      __mpmc_capacity(void *queue);
+void        __mpmc_destroy(void *queue);
+
+/**
+ * @brief Defines a bounded multi-producer / multi-consumer queue type.
+ *
+ * Like the other containers this is a pointer to storage preceded by its
+ * header, but the storage is a ring of slots (sequence number plus item), so
+ * the pointer must only be used through the `mpmc_*` macros.
+ *
+ * Example:
+ * ```c
+ * Mpmc(Task) work = mpmc_create(Task, 4096);
+ * ```
+ *
+ * @tparam T The element type.
+ */
+#define Mpmc(T) T *
+
+/**
+ * @brief Creates a bounded MPMC queue able to hold at least `capacity` elements.
+ *
+ * This is Dmitry Vyukov's bounded queue: every slot carries a sequence number
+ * telling producers and consumers whose turn it is, so a push or pop costs one
+ * CAS on the shared position plus one store to the slot, and there is no ABA
+ * problem. The capacity is rounded up to a power of two (at least 2).
+ *
+ * Example:
+ * ```c
+ * Mpmc(Job) q = mpmc_create(Job, 1024);
+ * ```
+ *
+ * @tparam T        The element type (its size is fixed at creation, like `__array_create`).
+ * @param capacity  Minimum number of elements the queue can hold.
+ * @return Pointer to the queue storage.
+ */
+#define mpmc_create(T, capacity)        ((T *)(__mpmc_create(sizeof(T), capacity)))
+
+/**
+ * @brief Tries to push an element without blocking.
+ *
+ * Example:
+ * ```c
+ * if (!mpmc_push(Job, q, job)) { ... } // queue full
+ * ```
+ *
+ * @tparam T The element type.
+ * @param q  Pointer to the queue.
+ * @param v  The value to push.
+ * @return `true` on success, `false` if the queue is full.
+ */
+#define mpmc_push(T, q, v)              (__mpmc_push(q, (T[]){ (v) }))
+
+/**
+ * @brief Tries to pop an element without blocking.
+ *
+ * Example:
+ * ```c
+ * Job job;
+ * if (mpmc_pop(q, &job)) run(&job);
+ * ```
+ *
+ * @param q   Pointer to the queue.
+ * @param out Destination for the element.
+ * @return `true` on success, `false` if the queue is empty.
+ */
+#define mpmc_pop(q, out)                (__mpmc_pop(q, out))
+
+/**
+ * @brief Pushes an element, sleeping while the queue is full.
+ *
+ * Spins briefly, then parks on a condition variable. Non-blocking pushes and
+ * pops only touch the lock when a thread is actually parked.
+ *
+ * Example:
+ * ```c
+ * mpmc_push_wait(Job, q, job);
+ * ```
+ *
+ * @tparam T The element type.
+ * @param q  Pointer to the queue.
+ * @param v  The value to push.
+ */
+#define mpmc_push_wait(T, q, v)         (__mpmc_push_wait(q, (T[]){ (v) }))
+
+/**
+ * @brief Pops an element, sleeping while the queue is empty.
+ *
+ * Example:
+ * ```c
+ * Job job;
+ * mpmc_pop_wait(q, &job);
+ * ```
+ *
+ * @param q   Pointer to the queue.
+ * @param out Destination for the element.
+ */
+#define mpmc_pop_wait(q, out)           (__mpmc_pop_wait(q, out))
+
+/**
+ * @brief Returns the capacity of the queue (a power of two).
+ *
+ * @param q Pointer to the queue.
+ */
+#define mpmc_capacity(q)                (__mpmc_capacity(q))
+
+/**
+ * @brief Destroys the queue. No thread may use or wait on it afterwards.
+ *
+ * @param q Pointer to the queue.
+ */
+#define mpmc_destroy(q)                 (__mpmc_destroy(q))
+
+#ifdef COLLECTIONS_MPMC_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define __MPMC_CACHE_LINE   64
+#define __MPMC_SPIN_LIMIT   128
+
+/**
+ * @brief Metadata stored immediately before the queue slots.
+ *
+ * The two positions are written by every producer (resp. consumer), so each
+ * gets its own cache line. The waiter counters are read on every operation
+ * but only written by threads about to sleep.
+ */
+typedef struct {
+    _Alignas(__MPMC_CACHE_LINE) _Atomic size_t      enqueue_pos;
+    _Alignas(__MPMC_CACHE_LINE) _Atomic size_t      dequeue_pos;
+
+    _Alignas(__MPMC_CACHE_LINE) _Atomic unsigned    producers_waiting;
+    _Atomic unsigned                                consumers_waiting;
+
+    _Alignas(__MPMC_CACHE_LINE) size_t              mask;
+    size_t                                          item_size;
+    size_t                                          stride;
+    pthread_mutex_t                                 lock;
+    pthread_cond_t                                  not_full;
+    pthread_cond_t                                  not_empty;
+} MpmcHeader;
+
+/**
+ * @brief Per-slot sequence number, followed in memory by the item bytes.
+ *
+ * A slot at position `pos` is free for the producer of `pos` when
+ * `seq == pos`, and holds the item for the consumer of `pos` when
+ * `seq == pos + 1`.
+ */
+typedef struct {
+    _Atomic size_t  seq;
+} MpmcSlot;
+
+#define mpmcheader(p) ((MpmcHeader *)(p) - 1)
+
+static inline MpmcSlot *__mpmc_slot__(void *queue, size_t pos) {
+    MpmcHeader *header = mpmcheader(queue);
+    return (MpmcSlot *)((char *)queue + (pos & header->mask) * header->stride);
+}
+
+static inline void *__mpmc_slot_data__(MpmcSlot *slot) {
+    return (void *)(slot + 1);
+}
+
+static void __mpmc_wake__(MpmcHeader *header, _Atomic unsigned *waiting, pthread_cond_t *cond) {
+    // Pairs with the fence the blocking wrappers take before parking: either
+    // the sleeper sees our slot update on its retry, or we see its count here.
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load_explicit(waiting, memory_order_relaxed) == 0) return;
+
+    pthread_mutex_lock(&header->lock);
+    pthread_cond_broadcast(cond);
+    pthread_mutex_unlock(&header->lock);
+}
+
+void *__mpmc_create(size_t item_size, size_t capacity) {
+    size_t cap = 2;
+    while(cap < capacity) cap *= 2;
+
+    size_t align  = _Alignof(max_align_t);
+    size_t stride = (sizeof(MpmcSlot) + item_size + align - 1) & ~(align - 1);
+
+    size_t bytes = sizeof(MpmcHeader) + cap * stride;
+    bytes = (bytes + __MPMC_CACHE_LINE - 1) & ~(size_t)(__MPMC_CACHE_LINE - 1);
+
+    MpmcHeader *header = aligned_alloc(__MPMC_CACHE_LINE, bytes);
+    if(!header) {
+        fprintf(stderr, "__mpmc_create failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    atomic_init(&header->enqueue_pos, 0);
+    atomic_init(&header->dequeue_pos, 0);
+    atomic_init(&header->producers_waiting, 0);
+    atomic_init(&header->consumers_waiting, 0);
+    header->mask      = cap - 1;
+    header->item_size = item_size;
+    header->stride    = stride;
+    pthread_mutex_init(&header->lock, NULL);
+    pthread_cond_init(&header->not_full, NULL);
+    pthread_cond_init(&header->not_empty, NULL);
+
+    void *queue = (void *)(header + 1);
+    for(size_t i = 0; i < cap; ++i) atomic_init(&__mpmc_slot__(queue, i)->seq, i);
+
+    return queue;
+}
+
+static bool __mpmc_try_push__(void *queue, const void *item) {
+    MpmcHeader *header = mpmcheader(queue);
+    size_t pos = atomic_load_explicit(&header->enqueue_pos, memory_order_relaxed);
+    MpmcSlot *slot;
+
+    for(;;) {
+        slot = __mpmc_slot__(queue, pos);
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+        if(dif == 0) {
+            if(atomic_compare_exchange_weak_explicit(&header->enqueue_pos, &pos, pos + 1,
+                                                     memory_order_relaxed, memory_order_relaxed)) break;
+        } else if(dif < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&header->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(__mpmc_slot_data__(slot), item, header->item_size);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+static bool __mpmc_try_pop__(void *queue, void *out) {
+    MpmcHeader *header = mpmcheader(queue);
+    size_t pos = atomic_load_explicit(&header->dequeue_pos, memory_order_relaxed);
+    MpmcSlot *slot;
+
+    for(;;) {
+        slot = __mpmc_slot__(queue, pos);
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if(dif == 0) {
+            if(atomic_compare_exchange_weak_explicit(&header->dequeue_pos, &pos, pos + 1,
+                                                     memory_order_relaxed, memory_order_relaxed)) break;
+        } else if(dif < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&header->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(out, __mpmc_slot_data__(slot), header->item_size);
+    atomic_store_explicit(&slot->seq, pos + header->mask + 1, memory_order_release);
+    return true;
+}
+
+bool __mpmc_push(void *queue, const void *item) {
+    if(!__mpmc_try_push__(queue, item)) return false;
+
+    MpmcHeader *header = mpmcheader(queue);
+    __mpmc_wake__(header, &header->consumers_waiting, &header->not_empty);
+    return true;
+}
+
+bool __mpmc_pop(void *queue, void *out) {
+    if(!__mpmc_try_pop__(queue, out)) return false;
+
+    MpmcHeader *header = mpmcheader(queue);
+    __mpmc_wake__(header, &header->producers_waiting, &header->not_full);
+    return true;
+}
+
+void __mpmc_push_wait(void *queue, const void *item) {
+    for(int i = 0; i < __MPMC_SPIN_LIMIT; ++i) {
+        if(__mpmc_push(queue, item)) return;
+    }
+
+    MpmcHeader *header = mpmcheader(queue);
+    pthread_mutex_lock(&header->lock);
+    atomic_fetch_add_explicit(&header->producers_waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    while(!__mpmc_try_push__(queue, item)) pthread_cond_wait(&header->not_full, &header->lock);
+    atomic_fetch_sub_explicit(&header->producers_waiting, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&header->lock);
+
+    __mpmc_wake__(header, &header->consumers_waiting, &header->not_empty);
+}
+
+void __mpmc_pop_wait(void *queue, void *out) {
+    for(int i = 0; i < __MPMC_SPIN_LIMIT; ++i) {
+        if(__mpmc_pop(queue, out)) return;
+    }
+
+    MpmcHeader *header = mpmcheader(queue);
+    pthread_mutex_lock(&header->lock);
+    atomic_fetch_add_explicit(&header->consumers_waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    while(!__mpmc_try_pop__(queue, out)) pthread_cond_wait(&header->not_empty, &header->lock);
+    atomic_fetch_sub_explicit(&header->consumers_waiting, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&header->lock);
+
+    __mpmc_wake__(header, &header->producers_waiting, &header->not_full);
+}
+
+size_t __mpmc_capacity(void *queue) {
+    MpmcHeader *header = mpmcheader(queue);
+    return header->mask + 1;
+}
+
+void __mpmc_destroy(void *queue) {
+    MpmcHeader *header = mpmcheader(queue);
+    pthread_cond_destroy(&header->not_empty);
+    pthread_cond_destroy(&header->not_full);
+    pthread_mutex_destroy(&header->lock);
+    free(header);
+}
+
+#endif // COLLECTIONS_MPMC_IMPLEMENTATION
+
+
+#endif // COLLECTIONS_MPMC_H
@@ -0,0 +1,457 @@
+#ifndef COLLECTIONS_PACKED_H
+#define COLLECTIONS_PACKED_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/**
+ * @brief Number of values per compressed block.
+ */
+#define PACKED_BLOCK_SIZE   128
+
+/**
+ * @brief Skip entry of one compressed block.
+ *
+ * Entry `k` describes values `[k * 128, (k + 1) * 128)`, so finding the block
+ * of any index is a shift, and decoding it needs nothing but this entry.
+ */
+typedef struct {
+    uint64_t    base;       /**< First value of the block. */
+    int64_t     reference;  /**< Smallest delta in the block (frame of reference). */
+    uint64_t    offset;     /**< Index of the block's first word in `words`. */
+    uint8_t     bits;       /**< Width of every packed delta. */
+    uint8_t     exceptions; /**< Number of deltas wider than `bits`, stored apart. */
+} PackedBlock;
+
+/**
+ * @brief A compressed, append-only array of 64-bit integers.
+ *
+ * Values are grouped in blocks of 128. Each block stores its first value,
+ * then the differences between consecutive values minus the smallest such
+ * difference, bit-packed at the width that minimizes the block size; the few
+ * deltas that do not fit are kept as exceptions (patched frame of reference).
+ * Sorted IDs and slowly varying timestamps shrink to a few bits per value.
+ * Deltas wrap modulo 2^64, so any sequence round-trips exactly. The last,
+ * incomplete block is kept uncompressed in `tail` until it fills up.
+ */
+typedef struct {
+    PackedBlock *blocks; /**< Skip entries, one per full block. */
+    uint64_t    *words;  /**< Packed deltas and exceptions of all full blocks. */
+    uint64_t    *tail;   /**< Values not yet compressed, fewer than 128. */
+    size_t      length;  /**< Total number of values. */
+} PackedArray;
+
+/**
+ * @brief Creates an empty compressed array.
+ *
+ * @return A new PackedArray; release it with `packed_destroy`.
+ */
+PackedArray packed_create(void);
+
+/**
+ * @brief Frees the storage of a compressed array.
+ *
+ * @param a PackedArray to destroy.
+ */
+void packed_destroy(PackedArray *a);
+
+/**
+ * @brief Appends one value. Every 128th append compresses a block.
+ *
+ * @param a PackedArray to modify.
+ * @param value Value to append.
+ */
+void packed_append(PackedArray *a, uint64_t value);
+
+/**
+ * @brief Appends `n` values.
+ *
+ * Example:
+ * ```c
+ * PackedArray ids = packed_create();
+ * packed_append_n(&ids, raw_ids, array_length(raw_ids));
+ * ```
+ *
+ * @param a PackedArray to modify.
+ * @param values Values to append.
+ * @param n Number of values.
+ */
+void packed_append_n(PackedArray *a, const uint64_t *values, size_t n);
+
+/**
+ * @brief Returns the number of values.
+ *
+ * @param a Input PackedArray.
+ * @return Number of values.
+ */
+size_t packed_length(const PackedArray *a);
+
+/**
+ * @brief Returns value `i`.
+ *
+ * Looks up the block's skip entry and decodes that block only. To read many
+ * consecutive values, decode whole blocks with `packed_decode_block`.
+ *
+ * @param a Input PackedArray.
+ * @param i Index of the value.
+ * @return The value; the program exits if `i` is out of range.
+ */
+uint64_t packed_get(const PackedArray *a, size_t i);
+
+/**
+ * @brief Returns the number of blocks, counting the uncompressed tail.
+ *
+ * @param a Input PackedArray.
+ * @return `ceil(packed_length(a) / 128)`.
+ */
+size_t packed_block_count(const PackedArray *a);
+
+/**
+ * @brief Decodes block `block` into `out`.
+ *
+ * Uses AVX2 to unpack when the CPU supports it.
+ *
+ * Example:
+ * ```c
+ * uint64_t buf[PACKED_BLOCK_SIZE];
+ * for (size_t k = 0; k < packed_block_count(&ids); ++k) {
+ *     size_t n = packed_decode_block(&ids, k, buf);
+ *     for (size_t j = 0; j < n; ++j) visit(buf[j]);
+ * }
+ * ```
+ *
+ * @param a Input PackedArray.
+ * @param block Block index.
+ * @param out Receives up to 128 values.
+ * @return Number of values written (128, or fewer for the last block).
+ */
+size_t packed_decode_block(const PackedArray *a, size_t block, uint64_t *out);
+
+/**
+ * @brief Decodes every value into a new array.h array.
+ *
+ * @param a Input PackedArray.
+ * @return A new `Array(uint64_t)`.
+ */
+uint64_t *packed_to_array(const PackedArray *a);
+
+/**
+ * @brief Finds the first value not less than `value` in a sorted compressed array.
+ *
+ * Binary searches the block bases, then decodes a single block.
+ *
+ * @param a Input PackedArray, sorted in non-decreasing order.
+ * @param value Value to look for.
+ * @return Index of the first value `>= value`, or `packed_length(a)`.
+ */
+size_t packed_lower_bound(const PackedArray *a, uint64_t value);
+
+/**
+ * @brief Returns the number of bytes used by values and skip entries.
+ *
+ * @param a Input PackedArray.
+ * @return Bytes in use, excluding unused capacity.
+ */
+size_t packed_memory(const PackedArray *a);
+
+
+#ifdef COLLECTIONS_PACKED_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define __PACKED_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define __PACKED_SIMD_X86 0
+#endif
+
+// Deltas are packed in four interleaved lanes: delta `i` goes to lane `i % 4`
+// at slot `i / 4`, and word `k` of lane `l` is stored at `4 * k + l`. All
+// lanes share the same bit offsets, so one 256-bit load feeds four values.
+#define __PACKED_LANES              4
+#define __PACKED_SLOTS              (PACKED_BLOCK_SIZE / __PACKED_LANES)
+#define __PACKED_WORDS(bits)        (__PACKED_LANES * (((bits) + 1) / 2))
+#define __PACKED_MASK(bits)         ((bits) >= 64 ? ~UINT64_C(0) : (UINT64_C(1) << (bits)) - 1)
+
+// Words taken by the exceptions of a block: their positions, eight per
+// word, followed by the bits that did not fit.
+#define __PACKED_EXCEPTION_WORDS(n) (((n) + 7) / 8 + (n))
+
+static inline unsigned __packed_width__(uint64_t v) {
+    return v == 0 ? 0 : 64 - (unsigned)__builtin_clzll(v);
+}
+
+static void __packed_unpack_scalar__(const uint64_t *w, unsigned bits, uint64_t *out) {
+    uint64_t mask = __PACKED_MASK(bits);
+    for(unsigned j = 0; j < __PACKED_SLOTS; ++j) {
+        unsigned off   = j * bits;
+        unsigned k     = off / 64;
+        unsigned shift = off % 64;
+        for(unsigned l = 0; l < __PACKED_LANES; ++l) {
+            uint64_t v = w[__PACKED_LANES * k + l] >> shift;
+            if(shift + bits > 64) v |= w[__PACKED_LANES * (k + 1) + l] << (64 - shift);
+            out[__PACKED_LANES * j + l] = v & mask;
+        }
+    }
+}
+
+#if __PACKED_SIMD_X86
+
+__attribute__((target("avx2")))
+static void __packed_unpack_avx2__(const uint64_t *w, unsigned bits, uint64_t *out) {
+    const __m256i mask = _mm256_set1_epi64x((long long)__PACKED_MASK(bits));
+    for(unsigned j = 0; j < __PACKED_SLOTS; ++j) {
+        unsigned off   = j * bits;
+        unsigned k     = off / 64;
+        unsigned shift = off % 64;
+        __m256i v = _mm256_loadu_si256((const __m256i *)(w + __PACKED_LANES * k));
+        v = _mm256_srl_epi64(v, _mm_cvtsi32_si128((int)shift));
+        if(shift + bits > 64) {
+            __m256i next = _mm256_loadu_si256((const __m256i *)(w + __PACKED_LANES * (k + 1)));
+            v = _mm256_or_si256(v, _mm256_sll_epi64(next, _mm_cvtsi32_si128((int)(64 - shift))));
+        }
+        _mm256_storeu_si256((__m256i *)(out + __PACKED_LANES * j), _mm256_and_si256(v, mask));
+    }
+}
+
+static inline void __packed_unpack__(const uint64_t *w, unsigned bits, uint64_t *out) {
+    if(__builtin_cpu_supports("avx2")) __packed_unpack_avx2__(w, bits, out);
+    else __packed_unpack_scalar__(w, bits, out);
+}
+
+#else
+
+#define __packed_unpack__(w, bits, out)     (__packed_unpack_scalar__(w, bits, out))
+
+#endif // __PACKED_SIMD_X86
+
+static int __packed_compare_deltas__(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Size in words of a block whose deltas are taken relative to `reference`,
+// packed at the best width, which is stored in `*bits`. On a tie the wider
+// width wins, as it leaves fewer exceptions to patch.
+static size_t __packed_plan__(const uint64_t *values, uint64_t reference, unsigned *bits) {
+    size_t widths[65] = { 0 };
+    widths[0] = 1; // slot 0 holds no delta
+    for(size_t i = 1; i < PACKED_BLOCK_SIZE; ++i) {
+        widths[__packed_width__(values[i] - values[i - 1] - reference)] += 1;
+    }
+
+    size_t best = __PACKED_WORDS(64), above = 0;
+    *bits = 64;
+    for(int b = 64; b >= 0; --b) {
+        size_t words = __PACKED_WORDS(b) + __PACKED_EXCEPTION_WORDS(above);
+        if(words < best) {
+            best  = words;
+            *bits = (unsigned)b;
+        }
+        above += widths[b];
+    }
+    return best;
+}
+
+// Compresses one full block from `a->tail`.
+static void __packed_encode__(PackedArray *a) {
+    const uint64_t *values = a->tail;
+    uint64_t deltas[PACKED_BLOCK_SIZE];
+
+    // The frame of reference is the smallest delta, or a slightly higher
+    // quantile when that packs tighter: deltas below it wrap around and
+    // become exceptions, so a single outlier cannot widen the whole block.
+    int64_t sorted[PACKED_BLOCK_SIZE - 1];
+    for(size_t i = 1; i < PACKED_BLOCK_SIZE; ++i) sorted[i - 1] = (int64_t)(values[i] - values[i - 1]);
+    qsort(sorted, PACKED_BLOCK_SIZE - 1, sizeof(int64_t), __packed_compare_deltas__);
+
+    static const size_t quantiles[] = { 0, 1, 2, 4, 8, 16 };
+    int64_t reference = sorted[0];
+    unsigned bits;
+    size_t best = __packed_plan__(values, (uint64_t)reference, &bits);
+    for(size_t q = 1; q < sizeof(quantiles) / sizeof(quantiles[0]); ++q) {
+        unsigned b;
+        size_t words = __packed_plan__(values, (uint64_t)sorted[quantiles[q]], &b);
+        if(words < best) {
+            best      = words;
+            bits      = b;
+            reference = sorted[quantiles[q]];
+        }
+    }
+
+    deltas[0] = 0;
+    for(size_t i = 1; i < PACKED_BLOCK_SIZE; ++i) deltas[i] = values[i] - values[i - 1] - (uint64_t)reference;
+
+    size_t exceptions = 0;
+    for(size_t i = 1; i < PACKED_BLOCK_SIZE; ++i) exceptions += __packed_width__(deltas[i]) > bits;
+
+    size_t offset = array_length(a->words);
+    a->words = array_insert_n(uint64_t, a->words, offset, NULL, best);
+    uint64_t *w = a->words + offset;
+    memset(w, 0, best * sizeof(uint64_t));
+
+    uint64_t mask = __PACKED_MASK(bits);
+    uint8_t *positions = (uint8_t *)(w + __PACKED_WORDS(bits));
+    uint64_t *highs    = w + __PACKED_WORDS(bits) + (exceptions + 7) / 8;
+    size_t e = 0;
+    for(unsigned i = 0; i < PACKED_BLOCK_SIZE && bits > 0; ++i) {
+        unsigned j = i / __PACKED_LANES, l = i % __PACKED_LANES;
+        unsigned off = j * bits, k = off / 64, shift = off % 64;
+        uint64_t low = deltas[i] & mask;
+        w[__PACKED_LANES * k + l] |= low << shift;
+        if(shift + bits > 64) w[__PACKED_LANES * (k + 1) + l] |= low >> (64 - shift);
+    }
+    for(unsigned i = 1; i < PACKED_BLOCK_SIZE; ++i) {
+        if(__packed_width__(deltas[i]) <= bits) continue;
+        positions[e] = (uint8_t)i;
+        highs[e]     = deltas[i] >> bits;
+        e += 1;
+    }
+
+    PackedBlock block = {
+        .base       = values[0],
+        .reference  = reference,
+        .offset     = offset,
+        .bits       = (uint8_t)bits,
+        .exceptions = (uint8_t)exceptions,
+    };
+    a->blocks = array_append(PackedBlock, a->blocks);
+    a->blocks[array_length(a->blocks) - 1] = block;
+    array_clear(a->tail);
+}
+
+static void __packed_decode__(const PackedArray *a, size_t block, uint64_t *out) {
+    const PackedBlock *b = &a->blocks[block];
+    const uint64_t *w = a->words + b->offset;
+
+    if(b->bits > 0) __packed_unpack__(w, b->bits, out);
+    else memset(out, 0, PACKED_BLOCK_SIZE * sizeof(uint64_t));
+
+    const uint8_t *positions = (const uint8_t *)(w + __PACKED_WORDS(b->bits));
+    const uint64_t *highs    = w + __PACKED_WORDS(b->bits) + (b->exceptions + 7) / 8;
+    for(size_t e = 0; e < b->exceptions; ++e) out[positions[e]] |= highs[e] << b->bits;
+
+    uint64_t reference = (uint64_t)b->reference;
+    uint64_t run = b->base;
+    out[0] = run;
+    for(size_t i = 1; i < PACKED_BLOCK_SIZE; ++i) {
+        run += out[i] + reference;
+        out[i] = run;
+    }
+}
+
+PackedArray packed_create(void) {
+    return (PackedArray) {
+        .blocks = array_create(PackedBlock),
+        .words  = array_create(uint64_t),
+        .tail   = array_create(uint64_t),
+        .length = 0,
+    };
+}
+
+void packed_destroy(PackedArray *a) {
+    array_destroy(a->blocks);
+    array_destroy(a->words);
+    array_destroy(a->tail);
+    a->blocks = NULL;
+    a->words  = NULL;
+    a->tail   = NULL;
+    a->length = 0;
+}
+
+void packed_append(PackedArray *a, uint64_t value) {
+    a->tail = array_append(uint64_t, a->tail);
+    a->tail[array_length(a->tail) - 1] = value;
+    a->length += 1;
+    if(array_length(a->tail) == PACKED_BLOCK_SIZE) __packed_encode__(a);
+}
+
+void packed_append_n(PackedArray *a, const uint64_t *values, size_t n) {
+    while(n > 0) {
+        size_t have = array_length(a->tail);
+        size_t take = PACKED_BLOCK_SIZE - have < n ? PACKED_BLOCK_SIZE - have : n;
+        a->tail = array_insert_n(uint64_t, a->tail, have, values, take);
+        a->length += take;
+        values    += take;
+        n         -= take;
+        if(array_length(a->tail) == PACKED_BLOCK_SIZE) __packed_encode__(a);
+    }
+}
+
+size_t packed_length(const PackedArray *a) {
+    return a->length;
+}
+
+size_t packed_block_count(const PackedArray *a) {
+    return (a->length + PACKED_BLOCK_SIZE - 1) / PACKED_BLOCK_SIZE;
+}
+
+uint64_t packed_get(const PackedArray *a, size_t i) {
+    if(i >= a->length) {
+        fprintf(stderr, "packed_get failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t block = i / PACKED_BLOCK_SIZE;
+    if(block == array_length(a->blocks)) return a->tail[i % PACKED_BLOCK_SIZE];
+
+    uint64_t out[PACKED_BLOCK_SIZE];
+    __packed_decode__(a, block, out);
+    return out[i % PACKED_BLOCK_SIZE];
+}
+
+size_t packed_decode_block(const PackedArray *a, size_t block, uint64_t *out) {
+    size_t full = array_length(a->blocks);
+    if(block < full) {
+        __packed_decode__(a, block, out);
+        return PACKED_BLOCK_SIZE;
+    }
+    if(block == full && array_length(a->tail) > 0) {
+        size_t n = array_length(a->tail);
+        memcpy(out, a->tail, n * sizeof(uint64_t));
+        return n;
+    }
+    fprintf(stderr, "packed_decode_block failed: block out of range.\n");
+    exit(EXIT_FAILURE);
+}
+
+uint64_t *packed_to_array(const PackedArray *a) {
+    uint64_t *out = array_insert_n(uint64_t, array_create(uint64_t), 0, NULL, a->length);
+    size_t full = array_length(a->blocks);
+    for(size_t k = 0; k < full; ++k) __packed_decode__(a, k, out + k * PACKED_BLOCK_SIZE);
+    memcpy(out + full * PACKED_BLOCK_SIZE, a->tail, array_length(a->tail) * sizeof(uint64_t));
+    return out;
+}
+
+size_t packed_lower_bound(const PackedArray *a, uint64_t value) {
+    size_t full = array_length(a->blocks);
+    size_t count = packed_block_count(a);
+
+    // First block whose first value is not below `value`. The answer is in
+    // the block before it, or is that block's first index.
+    size_t lo = 0, hi = count;
+    while(lo < hi) {
+        size_t mid  = lo + (hi - lo) / 2;
+        uint64_t base = mid < full ? a->blocks[mid].base : a->tail[0];
+        if(base < value) lo = mid + 1;
+        else hi = mid;
+    }
+    if(lo == 0) return 0;
+
+    uint64_t buf[PACKED_BLOCK_SIZE];
+    size_t n = packed_decode_block(a, lo - 1, buf);
+    return (lo - 1) * PACKED_BLOCK_SIZE + __array_lower_bound_n(buf, n, sizeof(uint64_t), &value, __ARRAY_KEY_UNSIGNED);
+}
+
+size_t packed_memory(const PackedArray *a) {
+    return array_length(a->blocks) * sizeof(PackedBlock) +
+           array_length(a->words) * sizeof(uint64_t) +
+           array_length(a->tail) * sizeof(uint64_t);
+}
+
+#endif // COLLECTIONS_PACKED_IMPLEMENTATION
+#endif // COLLECTIONS_PACKED_H
@@ -0,0 +1,355 @@
+#ifndef COLLECTIONS_PARALLEL_H
+#define COLLECTIONS_PARALLEL_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "array.h"
+#include "scheduler.h"
+
+void    *__array_parallel_map(void *arr, size_t in_size, size_t out_size,
+                              void (*fn)(const void *in, void *out, void *ctx), void *ctx);
+void    *__array_parallel_filter(void *arr, size_t item_size,
+                                 bool (*pred)(const void *item, void *ctx), void *ctx);
+void    *__array_parallel_reduce(void *arr, size_t item_size, void *acc,
+                                 void (*op)(void *acc, const void *item, void *ctx), void *ctx);
+void    __array_parallel_scan(void *arr, size_t item_size, const void *identity,
+                              void (*op)(void *acc, const void *item, void *ctx), void *ctx, bool inclusive);
+
+/**
+ * @brief Applies `fn` to every element in parallel and returns the results in a new array.
+ *
+ * Work is split into chunks sized to fit in half of the L2 cache and
+ * distributed over the workers of the shared scheduler (scheduler.h), whose
+ * implementation must be compiled into the program. Small arrays are
+ * processed on the calling thread. `fn(in, out, ctx)` reads one `T` and
+ * writes one `U`; it is called concurrently from several threads.
+ *
+ * Example:
+ * ```c
+ * static void square(const void *in, void *out, void *ctx) {
+ *     *(double *)out = *(const double *)in * *(const double *)in;
+ * }
+ * Array(double) sq = array_parallel_map(double, double, xs, square, NULL);
+ * ```
+ *
+ * @tparam T  The input element type.
+ * @tparam U  The output element type.
+ * @param p   Pointer to the input array.
+ * @param fn  Element function.
+ * @param ctx Opaque pointer passed to `fn`.
+ * @return A new array of `array_length(p)` elements of type `U`.
+ */
+#define array_parallel_map(T, U, p, fn, ctx) \
+    ((U *)__array_parallel_map(p, sizeof(T), sizeof(U), fn, ctx))
+
+/**
+ * @brief Returns a new array holding the elements for which `pred` is true, in order.
+ *
+ * Each chunk evaluates the predicate once per element and counts the
+ * survivors; an exclusive prefix sum over the chunk counts then gives every
+ * chunk its output offset, and the chunks copy their survivors in parallel.
+ *
+ * Example:
+ * ```c
+ * static bool is_positive(const void *item, void *ctx) { return *(const int *)item > 0; }
+ * Array(int) pos = array_parallel_filter(int, xs, is_positive, NULL);
+ * ```
+ *
+ * @tparam T   The element type.
+ * @param p    Pointer to the array.
+ * @param pred Predicate.
+ * @param ctx  Opaque pointer passed to `pred`.
+ * @return A new array.
+ */
+#define array_parallel_filter(T, p, pred, ctx) \
+    ((T *)__array_parallel_filter(p, sizeof(T), pred, ctx))
+
+/**
+ * @brief Combines all elements with an associative operation.
+ *
+ * `op(acc, item, ctx)` must perform `*acc = *acc ⊕ *item`, where `⊕` is
+ * associative and `identity` is its neutral element. Chunks are reduced in
+ * parallel and their partial results combined left to right, so `⊕` need
+ * not be commutative.
+ *
+ * Example:
+ * ```c
+ * static void add(void *acc, const void *item, void *ctx) { *(double *)acc += *(const double *)item; }
+ * double total = array_parallel_reduce(double, xs, 0.0, add, NULL);
+ * ```
+ *
+ * @tparam T        The element type.
+ * @param p         Pointer to the array.
+ * @param identity  Neutral element of `op`.
+ * @param op        Combining operation.
+ * @param ctx       Opaque pointer passed to `op`.
+ * @return The reduced value.
+ */
+#define array_parallel_reduce(T, p, identity, op, ctx) \
+    (*(T *)__array_parallel_reduce(p, sizeof(T), (T[]){ (identity) }, op, ctx))
+
+/**
+ * @brief Replaces every element with the combination of itself and all elements before it.
+ *
+ * Uses the reduce-then-scan scheme: chunk totals are reduced in parallel,
+ * scanned serially, and each chunk is then rescanned from its offset.
+ * `op` and `identity` follow the same rules as for `array_parallel_reduce`.
+ *
+ * Example:
+ * ```c
+ * array_parallel_scan(long, counts, 0L, add_long, NULL); // running totals
+ * ```
+ *
+ * @tparam T        The element type.
+ * @param p         Pointer to the array, modified in place.
+ * @param identity  Neutral element of `op`.
+ * @param op        Combining operation.
+ * @param ctx       Opaque pointer passed to `op`.
+ */
+#define array_parallel_scan(T, p, identity, op, ctx) \
+    (__array_parallel_scan(p, sizeof(T), (T[]){ (identity) }, op, ctx, true))
+
+/**
+ * @brief Like `array_parallel_scan`, but element `i` becomes the combination
+ * of the elements strictly before it (the first becomes `identity`).
+ */
+#define array_parallel_exclusive_scan(T, p, identity, op, ctx) \
+    (__array_parallel_scan(p, sizeof(T), (T[]){ (identity) }, op, ctx, false))
+
+
+#ifdef COLLECTIONS_PARALLEL_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define __PARALLEL_DEFAULT_L2       (256 * 1024)
+#define __PARALLEL_MIN_CHUNK_ITEMS  1024
+
+/**
+ * @brief A chunked loop: `fn(ctx, c)` for every chunk `c`.
+ */
+typedef struct {
+    void    (*fn)(void *ctx, size_t chunk);
+    void    *ctx;
+} ParallelLoop;
+
+static void __parallel_chunks__(void *arg, size_t lo, size_t hi) {
+    ParallelLoop *loop = arg;
+    for(size_t c = lo; c < hi; ++c) loop->fn(loop->ctx, c);
+}
+
+// Runs `fn(ctx, c)` for every chunk in `[0, chunks)` on the shared scheduler.
+static void __parallel_for__(size_t chunks, void (*fn)(void *ctx, size_t chunk), void *ctx) {
+    ParallelLoop loop = { fn, ctx };
+    scheduler_parallel_for(0, chunks, 1, __parallel_chunks__, &loop);
+}
+
+// Elements per chunk so that a chunk's input fills about half of the L2 cache.
+static size_t __parallel_chunk_items__(size_t item_size) {
+    long l2 = -1;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    size_t bytes = l2 > 0 ? (size_t)l2 / 2 : __PARALLEL_DEFAULT_L2 / 2;
+    size_t items = bytes / (item_size > 0 ? item_size : 1);
+    return items > __PARALLEL_MIN_CHUNK_ITEMS ? items : __PARALLEL_MIN_CHUNK_ITEMS;
+}
+
+/**
+ * @brief State shared by the chunk bodies of one algorithm call.
+ */
+typedef struct {
+    char    *in;
+    char    *out;
+    size_t  n;
+    size_t  chunk_items;
+    size_t  in_size;
+    size_t  out_size;
+    union {                 // the callback, by algorithm
+        void    (*map)(const void *in, void *out, void *ctx);
+        bool    (*pred)(const void *item, void *ctx);
+        void    (*op)(void *acc, const void *item, void *ctx);
+    } fn;
+    void    *ctx;
+    char    *partials;      // one item per chunk: reduce results or scan offsets
+    size_t  *counts;        // filter survivors per chunk, then output offsets
+    uint8_t *flags;         // filter predicate results
+    const void *identity;
+    bool    inclusive;
+} ParallelArgs;
+
+#define __parallel_range__(a, c, lo, hi)                                                    \
+    size_t lo = (c) * (a)->chunk_items;                                                     \
+    size_t hi = lo + (a)->chunk_items < (a)->n ? lo + (a)->chunk_items : (a)->n
+
+static void __parallel_map_chunk__(void *arg, size_t c) {
+    ParallelArgs *a = arg;
+    __parallel_range__(a, c, lo, hi);
+    for(size_t i = lo; i < hi; ++i) a->fn.map(a->in + i * a->in_size, a->out + i * a->out_size, a->ctx);
+}
+
+void *__array_parallel_map(void *arr, size_t in_size, size_t out_size,
+                           void (*fn)(const void *in, void *out, void *ctx), void *ctx) {
+    size_t n = array_length(arr);
+    void *out = __array_insert_n(__array_create(out_size), 0, NULL, n);
+
+    ParallelArgs a = {
+        .in = arr, .out = out, .n = n, .in_size = in_size, .out_size = out_size,
+        .chunk_items = __parallel_chunk_items__(in_size > out_size ? in_size : out_size),
+        .fn.map = fn, .ctx = ctx,
+    };
+    __parallel_for__((n + a.chunk_items - 1) / a.chunk_items, __parallel_map_chunk__, &a);
+    return out;
+}
+
+static void __parallel_filter_count__(void *arg, size_t c) {
+    ParallelArgs *a = arg;
+    __parallel_range__(a, c, lo, hi);
+    size_t count = 0;
+    for(size_t i = lo; i < hi; ++i) {
+        uint8_t keep = a->fn.pred(a->in + i * a->in_size, a->ctx) ? 1 : 0;
+        a->flags[i] = keep;
+        count += keep;
+    }
+    a->counts[c] = count;
+}
+
+static void __parallel_filter_copy__(void *arg, size_t c) {
+    ParallelArgs *a = arg;
+    __parallel_range__(a, c, lo, hi);
+    char *dst = a->out + a->counts[c] * a->in_size;
+    for(size_t i = lo; i < hi; ++i) {
+        if(!a->flags[i]) continue;
+        memcpy(dst, a->in + i * a->in_size, a->in_size);
+        dst += a->in_size;
+    }
+}
+
+void *__array_parallel_filter(void *arr, size_t item_size,
+                              bool (*pred)(const void *item, void *ctx), void *ctx) {
+    size_t n = array_length(arr);
+    ParallelArgs a = {
+        .in = arr, .n = n, .in_size = item_size,
+        .chunk_items = __parallel_chunk_items__(item_size),
+        .fn.pred = pred, .ctx = ctx,
+    };
+    size_t chunks = (n + a.chunk_items - 1) / a.chunk_items;
+
+    a.flags  = malloc(n > 0 ? n : 1);
+    a.counts = malloc((chunks > 0 ? chunks : 1) * sizeof(size_t));
+    if(!a.flags || !a.counts) {
+        fprintf(stderr, "__array_parallel_filter failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    __parallel_for__(chunks, __parallel_filter_count__, &a);
+
+    size_t total = 0;
+    for(size_t c = 0; c < chunks; ++c) {
+        size_t count = a.counts[c];
+        a.counts[c] = total;
+        total += count;
+    }
+
+    a.out = __array_insert_n(__array_create(item_size), 0, NULL, total);
+    __parallel_for__(chunks, __parallel_filter_copy__, &a);
+
+    free(a.flags);
+    free(a.counts);
+    return a.out;
+}
+
+static void __parallel_reduce_chunk__(void *arg, size_t c) {
+    ParallelArgs *a = arg;
+    __parallel_range__(a, c, lo, hi);
+    char *acc = a->partials + c * a->in_size;
+    memcpy(acc, a->identity, a->in_size);
+    for(size_t i = lo; i < hi; ++i) a->fn.op(acc, a->in + i * a->in_size, a->ctx);
+}
+
+static char *__parallel_partials__(size_t chunks, size_t item_size, const char *fn) {
+    char *partials = malloc((chunks > 0 ? chunks : 1) * item_size);
+    if(!partials) {
+        fprintf(stderr, "%s failed: cannot allocate memory.\n", fn);
+        exit(EXIT_FAILURE);
+    }
+    return partials;
+}
+
+void *__array_parallel_reduce(void *arr, size_t item_size, void *acc,
+                              void (*op)(void *acc, const void *item, void *ctx), void *ctx) {
+    size_t n = array_length(arr);
+    ParallelArgs a = {
+        .in = arr, .n = n, .in_size = item_size,
+        .chunk_items = __parallel_chunk_items__(item_size),
+        .fn.op = op, .ctx = ctx,
+    };
+    size_t chunks = (n + a.chunk_items - 1) / a.chunk_items;
+
+    // `acc` holds the identity on entry and receives the result.
+    a.identity = acc;
+    a.partials = __parallel_partials__(chunks, item_size, "__array_parallel_reduce");
+    __parallel_for__(chunks, __parallel_reduce_chunk__, &a);
+
+    for(size_t c = 0; c < chunks; ++c) op(acc, a.partials + c * item_size, ctx);
+    free(a.partials);
+    return acc;
+}
+
+static void __parallel_scan_chunk__(void *arg, size_t c) {
+    ParallelArgs *a = arg;
+    __parallel_range__(a, c, lo, hi);
+
+    size_t size = a->in_size;
+    char *run   = a->partials + c * size;
+    char *saved = a->out + c * size;
+    for(size_t i = lo; i < hi; ++i) {
+        char *item = a->in + i * size;
+        if(a->inclusive) {
+            a->fn.op(run, item, a->ctx);
+            memcpy(item, run, size);
+        } else {
+            memcpy(saved, item, size);
+            memcpy(item, run, size);
+            a->fn.op(run, saved, a->ctx);
+        }
+    }
+}
+
+void __array_parallel_scan(void *arr, size_t item_size, const void *identity,
+                           void (*op)(void *acc, const void *item, void *ctx), void *ctx, bool inclusive) {
+    size_t n = array_length(arr);
+    ParallelArgs a = {
+        .in = arr, .n = n, .in_size = item_size,
+        .chunk_items = __parallel_chunk_items__(item_size),
+        .fn.op = op, .ctx = ctx, .identity = identity, .inclusive = inclusive,
+    };
+    size_t chunks = (n + a.chunk_items - 1) / a.chunk_items;
+
+    // Pass 1: chunk totals (the last chunk's total is never needed).
+    a.partials = __parallel_partials__(chunks, item_size, "__array_parallel_scan");
+    if(chunks > 1) __parallel_for__(chunks - 1, __parallel_reduce_chunk__, &a);
+
+    // Turn the totals into starting offsets, then rescan every chunk from its offset.
+    char *carry = __parallel_partials__(2, item_size, "__array_parallel_scan");
+    char *total = carry + item_size;
+    memcpy(carry, identity, item_size);
+    for(size_t c = 0; c < chunks; ++c) {
+        char *slot = a.partials + c * item_size;
+        bool last  = c + 1 == chunks;
+        if(!last) memcpy(total, slot, item_size);
+        memcpy(slot, carry, item_size);
+        if(!last) op(carry, total, ctx);
+    }
+    free(carry);
+
+    a.out = __parallel_partials__(chunks, item_size, "__array_parallel_scan");
+    __parallel_for__(chunks, __parallel_scan_chunk__, &a);
+    free(a.out);
+    free(a.partials);
+}
+
+#endif // COLLECTIONS_PARALLEL_IMPLEMENTATION
+#endif // COLLECTIONS_PARALLEL_H
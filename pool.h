@@ -0,0 +1,320 @@
+#ifndef COLLECTIONS_POOL_H
+#define COLLECTIONS_POOL_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/**
+ * @brief Counters describing the process-wide pool.
+ *
+ * `allocs` and `frees` are folded in whenever a thread exchanges objects with
+ * the shared depot, so they can lag behind by one magazine per thread;
+ * `pool_thread_flush` makes the calling thread's counts exact.
+ */
+typedef struct {
+    size_t slabs;          /**< Slabs obtained from the system. */
+    size_t reserved_bytes; /**< Bytes held in those slabs. */
+    size_t allocs;         /**< Small allocations served from the pool. */
+    size_t frees;          /**< Small allocations returned to the pool. */
+    size_t large_allocs;   /**< Requests above the largest size class, passed to `malloc`. */
+    size_t refills;        /**< Magazine refills taken from the depot. */
+    size_t flushes;        /**< Magazine flushes returned to the depot. */
+} PoolStats;
+
+/**
+ * @brief Allocates `size` bytes from the process-wide pool.
+ *
+ * Sizes up to 512 bytes are rounded up to a multiple of 16 and served from
+ * per-size-class slabs; larger requests go straight to `malloc`. The common
+ * case pops a pointer from the calling thread's magazine without locking.
+ * Memory is 16-byte aligned.
+ *
+ * Example:
+ * ```c
+ * Node *n = pool_alloc(sizeof(Node));
+ * pool_free(n, sizeof(Node));
+ * ```
+ *
+ * @param size Number of bytes.
+ * @return Pointer to the block; the program exits if memory runs out.
+ */
+void *pool_alloc(size_t size);
+
+/**
+ * @brief Returns a block to the pool.
+ *
+ * The block may be freed by another thread than the one that allocated it.
+ *
+ * @param p Block returned by `pool_alloc` or `pool_realloc`, or NULL.
+ * @param size The size the block was requested with.
+ */
+void pool_free(void *p, size_t size);
+
+/**
+ * @brief Resizes a block, moving it only when its size class changes.
+ *
+ * @param p Block to resize, or NULL.
+ * @param old_size The size the block was requested with.
+ * @param new_size The new size.
+ * @return Pointer to the resized block.
+ */
+void *pool_realloc(void *p, size_t old_size, size_t new_size);
+
+/**
+ * @brief Returns the calling thread's cached objects to the shared depot.
+ *
+ * Runs automatically when a thread that used the pool exits.
+ */
+void pool_thread_flush(void);
+
+/**
+ * @brief Returns a snapshot of the pool counters.
+ *
+ * @return The current statistics.
+ */
+PoolStats pool_stats(void);
+
+
+#ifdef COLLECTIONS_POOL_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define __POOL_GRANULE          16
+#define __POOL_MAX_SIZE         512
+#define __POOL_CLASS_COUNT      (__POOL_MAX_SIZE / __POOL_GRANULE)
+#define __POOL_SLAB_SIZE        (64 * 1024)
+#define __POOL_MAGAZINE_SIZE    64
+#define __POOL_BATCH            (__POOL_MAGAZINE_SIZE / 2)
+
+/**
+ * @brief A free object. The link lives in the object itself.
+ */
+typedef struct PoolObject {
+    struct PoolObject   *next;
+} PoolObject;
+
+/**
+ * @brief Slab prefix linking every slab ever allocated, padded to keep objects 16-byte aligned.
+ */
+typedef union PoolSlab {
+    union PoolSlab  *next;
+    char            pad[__POOL_GRANULE];
+} PoolSlab;
+
+/**
+ * @brief Shared per-class state: returned objects and the unused tail of the newest slab.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    PoolObject      *free;
+    char            *bump;
+    char            *end;
+} PoolDepot;
+
+/**
+ * @brief A thread's stack of cached objects for one size class.
+ */
+typedef struct {
+    size_t  count;
+    void    *items[__POOL_MAGAZINE_SIZE];
+} PoolMagazine;
+
+typedef struct {
+    PoolMagazine    magazines[__POOL_CLASS_COUNT];
+    size_t          allocs;
+    size_t          frees;
+    bool            registered;
+} PoolCache;
+
+static PoolDepot                __pool_depots__[__POOL_CLASS_COUNT];
+static PoolSlab                 *__pool_slabs__;
+static pthread_mutex_t          __pool_slab_lock__ = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t           __pool_once__ = PTHREAD_ONCE_INIT;
+static pthread_key_t            __pool_key__;
+static _Thread_local PoolCache  __pool_cache__;
+
+static _Atomic size_t __pool_stat_slabs__;
+static _Atomic size_t __pool_stat_allocs__;
+static _Atomic size_t __pool_stat_frees__;
+static _Atomic size_t __pool_stat_large__;
+static _Atomic size_t __pool_stat_refills__;
+static _Atomic size_t __pool_stat_flushes__;
+
+static void __pool_thread_exit__(void *cache) {
+    pool_thread_flush();
+    ((PoolCache *)cache)->registered = false;
+}
+
+static void __pool_init__(void) {
+    for(size_t i = 0; i < __POOL_CLASS_COUNT; ++i) pthread_mutex_init(&__pool_depots__[i].lock, NULL);
+    if(pthread_key_create(&__pool_key__, __pool_thread_exit__) != 0) {
+        fprintf(stderr, "pool_alloc failed: cannot create thread key.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static inline size_t __pool_class__(size_t size) {
+    return size == 0 ? 0 : (size - 1) / __POOL_GRANULE;
+}
+
+static void __pool_fold_counters__(PoolCache *cache) {
+    atomic_fetch_add_explicit(&__pool_stat_allocs__, cache->allocs, memory_order_relaxed);
+    atomic_fetch_add_explicit(&__pool_stat_frees__, cache->frees, memory_order_relaxed);
+    cache->allocs = 0;
+    cache->frees  = 0;
+}
+
+// Called with the depot lock held when both the free list and the slab tail are empty.
+static void __pool_new_slab__(PoolDepot *depot) {
+    PoolSlab *slab = malloc(__POOL_SLAB_SIZE);
+    if(!slab) {
+        fprintf(stderr, "pool_alloc failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_lock(&__pool_slab_lock__);
+    slab->next = __pool_slabs__;
+    __pool_slabs__ = slab;
+    pthread_mutex_unlock(&__pool_slab_lock__);
+    atomic_fetch_add_explicit(&__pool_stat_slabs__, 1, memory_order_relaxed);
+
+    depot->bump = (char *)(slab + 1);
+    depot->end  = (char *)slab + __POOL_SLAB_SIZE;
+}
+
+// Arranges for the thread's magazines to be flushed when it exits.
+static void __pool_register__(PoolCache *cache) {
+    pthread_once(&__pool_once__, __pool_init__);
+    pthread_setspecific(__pool_key__, cache);
+    cache->registered = true;
+}
+
+static void __pool_refill__(PoolCache *cache, size_t cls) {
+    if(!cache->registered) __pool_register__(cache);
+
+    PoolMagazine *mag  = &cache->magazines[cls];
+    PoolDepot   *depot = &__pool_depots__[cls];
+    size_t object_size = (cls + 1) * __POOL_GRANULE;
+
+    pthread_mutex_lock(&depot->lock);
+    while(mag->count < __POOL_BATCH && depot->free) {
+        mag->items[mag->count++] = depot->free;
+        depot->free = depot->free->next;
+    }
+    while(mag->count < __POOL_BATCH) {
+        if((size_t)(depot->end - depot->bump) < object_size) {
+            if(mag->count > 0) break;
+            __pool_new_slab__(depot);
+        }
+        mag->items[mag->count++] = depot->bump;
+        depot->bump += object_size;
+    }
+    pthread_mutex_unlock(&depot->lock);
+
+    atomic_fetch_add_explicit(&__pool_stat_refills__, 1, memory_order_relaxed);
+    __pool_fold_counters__(cache);
+}
+
+static void __pool_flush__(PoolCache *cache, size_t cls, size_t keep) {
+    PoolMagazine *mag  = &cache->magazines[cls];
+    PoolDepot   *depot = &__pool_depots__[cls];
+    if(mag->count <= keep) return;
+
+    pthread_mutex_lock(&depot->lock);
+    while(mag->count > keep) {
+        PoolObject *object = mag->items[--mag->count];
+        object->next = depot->free;
+        depot->free  = object;
+    }
+    pthread_mutex_unlock(&depot->lock);
+
+    atomic_fetch_add_explicit(&__pool_stat_flushes__, 1, memory_order_relaxed);
+}
+
+void *pool_alloc(size_t size) {
+    if(size > __POOL_MAX_SIZE) {
+        atomic_fetch_add_explicit(&__pool_stat_large__, 1, memory_order_relaxed);
+        void *p = malloc(size);
+        if(!p) {
+            fprintf(stderr, "pool_alloc failed: cannot allocate memory.\n");
+            exit(EXIT_FAILURE);
+        }
+        return p;
+    }
+
+    PoolCache *cache  = &__pool_cache__;
+    size_t cls        = __pool_class__(size);
+    PoolMagazine *mag = &cache->magazines[cls];
+
+    if(mag->count == 0) __pool_refill__(cache, cls);
+    cache->allocs += 1;
+    return mag->items[--mag->count];
+}
+
+void pool_free(void *p, size_t size) {
+    if(!p) return;
+    if(size > __POOL_MAX_SIZE) {
+        free(p);
+        return;
+    }
+
+    PoolCache *cache  = &__pool_cache__;
+    size_t cls        = __pool_class__(size);
+    PoolMagazine *mag = &cache->magazines[cls];
+
+    if(!cache->registered) __pool_register__(cache);
+    if(mag->count == __POOL_MAGAZINE_SIZE) {
+        __pool_flush__(cache, cls, __POOL_MAGAZINE_SIZE - __POOL_BATCH);
+        __pool_fold_counters__(cache);
+    }
+    cache->frees += 1;
+    mag->items[mag->count++] = p;
+}
+
+void *pool_realloc(void *p, size_t old_size, size_t new_size) {
+    if(!p) return pool_alloc(new_size);
+
+    if(old_size > __POOL_MAX_SIZE && new_size > __POOL_MAX_SIZE) {
+        void *q = realloc(p, new_size);
+        if(!q) {
+            fprintf(stderr, "pool_realloc failed: cannot allocate memory.\n");
+            exit(EXIT_FAILURE);
+        }
+        return q;
+    }
+    if(old_size <= __POOL_MAX_SIZE && new_size <= __POOL_MAX_SIZE &&
+       __pool_class__(old_size) == __pool_class__(new_size)) {
+        return p;
+    }
+
+    void *q = pool_alloc(new_size);
+    memcpy(q, p, old_size < new_size ? old_size : new_size);
+    pool_free(p, old_size);
+    return q;
+}
+
+void pool_thread_flush(void) {
+    PoolCache *cache = &__pool_cache__;
+    for(size_t cls = 0; cls < __POOL_CLASS_COUNT; ++cls) __pool_flush__(cache, cls, 0);
+    __pool_fold_counters__(cache);
+}
+
+PoolStats pool_stats(void) {
+    size_t slabs = atomic_load_explicit(&__pool_stat_slabs__, memory_order_relaxed);
+    return (PoolStats) {
+        .slabs          = slabs,
+        .reserved_bytes = slabs * __POOL_SLAB_SIZE,
+        .allocs         = atomic_load_explicit(&__pool_stat_allocs__, memory_order_relaxed),
+        .frees          = atomic_load_explicit(&__pool_stat_frees__, memory_order_relaxed),
+        .large_allocs   = atomic_load_explicit(&__pool_stat_large__, memory_order_relaxed),
+        .refills        = atomic_load_explicit(&__pool_stat_refills__, memory_order_relaxed),
+        .flushes        = atomic_load_explicit(&__pool_stat_flushes__, memory_order_relaxed),
+    };
+}
+
+#endif // COLLECTIONS_POOL_IMPLEMENTATION
+#endif // COLLECTIONS_POOL_H
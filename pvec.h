@@ -0,0 +1,504 @@
+#ifndef COLLECTIONS_PVEC_H
+#define COLLECTIONS_PVEC_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/**
+ * @brief An immutable vector version: a 32-ary trie of leaves plus a tail leaf.
+ *
+ * Elements live in leaves of 32; all but the last leaf hang off a trie of
+ * 32-way branch nodes, and the last (the tail) is kept apart so pushes and
+ * pops at the end usually touch only the tail. An update copies the nodes on
+ * one root-to-leaf path and shares everything else with the previous
+ * version, so it costs O(log32 n) (at most 7 levels for 2^32 elements) and
+ * the old version stays valid. Indexing walks the same path; elements within
+ * a leaf are contiguous, and `pvec_chunk` hands out whole leaves for scans.
+ *
+ * Nodes are reference counted with atomic counts, so versions can be shared
+ * between threads. A PVec is a small handle passed by value; each handle owns
+ * one reference to its nodes and must be released with `pvec_release` (or
+ * consumed by a transient operation). `pvec_clone` copies a handle in O(1).
+ *
+ * Transient operations (`pvec_transient_push` and friends) update a handle in
+ * place instead of returning a new version: nodes that the handle alone
+ * references are modified directly, and only shared nodes are copied, once.
+ * A batch of transient pushes therefore fills each leaf in place. Other
+ * versions are never affected; clone first to keep the original.
+ */
+typedef struct PVecNode PVecNode;
+
+typedef struct {
+    PVecNode   *root;       /**< Trie holding all leaves but the tail; NULL when empty. */
+    PVecNode   *tail;       /**< Last leaf, holding 1 to 32 elements; NULL when empty. */
+    size_t      length;     /**< Number of elements. */
+    size_t      item_size;  /**< Size of one element in bytes. */
+    unsigned    shift;      /**< Bit offset of the root's index digit: 5 * trie depth. */
+} PVec;
+
+/**
+ * @brief Documents the element type of a PVec, like `Array(T)`.
+ *
+ * Example:
+ * ```c
+ * PVec(int) v = pvec_create(int);
+ * ```
+ */
+#define PVec(T) PVec
+
+PVec        __pvec_create(size_t item_size);
+PVec        __pvec_from(const void *items, size_t length, size_t item_size);
+const void  *__pvec_at(const PVec *v, size_t idx);
+const void  *__pvec_chunk(const PVec *v, size_t idx, size_t *count);
+PVec        __pvec_push(PVec v, const void *item);
+PVec        __pvec_set(PVec v, size_t idx, const void *item);
+void        __pvec_transient_append_n(PVec *v, const void *items, size_t count);
+void        __pvec_transient_set(PVec *v, size_t idx, const void *item);
+void        *__pvec_to_array(PVec v);
+
+/**
+ * @brief Returns another handle to the same version, in O(1).
+ *
+ * @param v The version.
+ * @return A handle that must be released separately.
+ */
+PVec pvec_clone(PVec v);
+
+/**
+ * @brief Releases a handle; nodes no other version uses are freed.
+ *
+ * @param v The handle.
+ */
+void pvec_release(PVec v);
+
+/**
+ * @brief Returns a new version without the last element, in O(log32 n).
+ *
+ * @param v The version; it stays valid.
+ * @return The new version.
+ */
+PVec pvec_pop(PVec v);
+
+/**
+ * @brief Removes the last element in place, copying only shared nodes.
+ *
+ * @param v Handle to update.
+ */
+void pvec_transient_pop(PVec *v);
+
+/**
+ * @brief Creates an empty persistent vector for elements of type `T`.
+ *
+ * @tparam T The element type.
+ * @return An empty version; creating it does not allocate.
+ */
+#define pvec_create(T)                  (__pvec_create(sizeof(T)))
+
+/**
+ * @brief Creates a persistent vector holding a copy of an array.h array.
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the array.
+ * @return The new version.
+ */
+#define pvec_from_array(T, p)           (__pvec_from(p, array_length(p), sizeof(T)))
+
+/**
+ * @brief Copies the elements of a version into a new array.h array.
+ *
+ * @tparam T The element type.
+ * @param v  The version.
+ * @return A new array, to be freed with `array_destroy`.
+ */
+#define pvec_to_array(T, v)             ((T *)__pvec_to_array(v))
+
+/**
+ * @brief Returns the number of elements.
+ *
+ * @param v The version.
+ * @return The length.
+ */
+#define pvec_length(v)                  ((v).length)
+
+/**
+ * @brief Returns the element at `idx`, in O(log32 n); elements in the tail take O(1).
+ *
+ * @tparam T  The element type.
+ * @param v   The version (an lvalue).
+ * @param idx Index of the element.
+ * @return The element.
+ */
+#define pvec_at(T, v, idx)              (*(const T *)__pvec_at(&(v), idx))
+
+/**
+ * @brief Returns the contiguous run of elements starting at `idx`, up to the end of its leaf.
+ *
+ * Scanning leaf by leaf costs one trie walk per 32 elements and reads each
+ * leaf sequentially.
+ *
+ * Example:
+ * ```c
+ * for(size_t i = 0, n; i < pvec_length(v); i += n) {
+ *     const double *run = pvec_chunk(double, v, i, &n);
+ *     for(size_t k = 0; k < n; ++k) total += run[k];
+ * }
+ * ```
+ *
+ * @tparam T     The element type.
+ * @param v      The version (an lvalue).
+ * @param idx    Index of the first element.
+ * @param count  Receives the number of elements in the run (1 to 32).
+ * @return Pointer to the element at `idx`.
+ */
+#define pvec_chunk(T, v, idx, count)    ((const T *)__pvec_chunk(&(v), idx, count))
+
+/**
+ * @brief Returns a new version with `x` appended; `v` stays valid.
+ *
+ * Example:
+ * ```c
+ * PVec(int) v1 = pvec_push(int, v0, 42);
+ * pvec_release(v0); // unless v0 is still needed
+ * ```
+ *
+ * @tparam T The element type.
+ * @param v  The version.
+ * @param x  Value to append.
+ * @return The new version.
+ */
+#define pvec_push(T, v, x)              (__pvec_push(v, (T[]){ (x) }))
+
+/**
+ * @brief Returns a new version with the element at `idx` replaced; `v` stays valid.
+ *
+ * @tparam T  The element type.
+ * @param v   The version.
+ * @param idx Index of the element.
+ * @param x   New value.
+ * @return The new version.
+ */
+#define pvec_set(T, v, idx, x)          (__pvec_set(v, idx, (T[]){ (x) }))
+
+/**
+ * @brief Appends `x` in place, copying only nodes shared with other versions.
+ *
+ * Example:
+ * ```c
+ * PVec(int) t = pvec_clone(v);     // keep v, batch-edit t
+ * for(int i = 0; i < 1000; ++i) pvec_transient_push(int, &t, i);
+ * ```
+ *
+ * @tparam T The element type.
+ * @param v  Pointer to the handle to update.
+ * @param x  Value to append.
+ */
+#define pvec_transient_push(T, v, x)    (__pvec_transient_append_n(v, (T[]){ (x) }, 1))
+
+/**
+ * @brief Appends `n` elements in place, filling whole leaves at a time.
+ *
+ * @tparam T     The element type.
+ * @param v      Pointer to the handle to update.
+ * @param items  Pointer to `n` elements.
+ * @param n      Number of elements.
+ */
+#define pvec_transient_append_n(T, v, items, n) (__pvec_transient_append_n(v, items, n))
+
+/**
+ * @brief Replaces the element at `idx` in place, copying only nodes shared with other versions.
+ *
+ * @tparam T  The element type.
+ * @param v   Pointer to the handle to update.
+ * @param idx Index of the element.
+ * @param x   New value.
+ */
+#define pvec_transient_set(T, v, idx, x) (__pvec_transient_set(v, idx, (T[]){ (x) }))
+
+
+#ifdef COLLECTIONS_PVEC_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define __PVEC_BITS     5
+#define __PVEC_BRANCH   (1u << __PVEC_BITS)
+#define __PVEC_MASK     (__PVEC_BRANCH - 1)
+
+struct PVecNode {
+    _Atomic size_t  refs;
+    _Alignas(max_align_t) unsigned char data[]; // __PVEC_BRANCH child pointers or elements
+};
+
+#define __pvec_children__(n)    ((PVecNode **)(void *)(n)->data)
+#define __pvec_items__(n)       ((char *)(n)->data)
+
+static PVecNode *__pvec_node__(size_t bytes) {
+    PVecNode *node = malloc(offsetof(PVecNode, data) + bytes);
+    if(!node) {
+        fprintf(stderr, "pvec failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    atomic_init(&node->refs, 1);
+    return node;
+}
+
+static PVecNode *__pvec_branch__(void) {
+    PVecNode *node = __pvec_node__(__PVEC_BRANCH * sizeof(PVecNode *));
+    memset(node->data, 0, __PVEC_BRANCH * sizeof(PVecNode *));
+    return node;
+}
+
+static inline PVecNode *__pvec_retain__(PVecNode *node) {
+    if(node) atomic_fetch_add_explicit(&node->refs, 1, memory_order_relaxed);
+    return node;
+}
+
+// `level` is the shift of the node's own index digit: 0 for leaves.
+static void __pvec_release_node__(PVecNode *node, unsigned level) {
+    if(!node || atomic_fetch_sub_explicit(&node->refs, 1, memory_order_acq_rel) != 1) return;
+    if(level > 0) {
+        for(unsigned i = 0; i < __PVEC_BRANCH; ++i) __pvec_release_node__(__pvec_children__(node)[i], level - __PVEC_BITS);
+    }
+    free(node);
+}
+
+// Returns a node the caller may modify in place: `node` itself when the
+// caller holds the only reference, otherwise a copy that takes over the
+// caller's reference. The acquire load pairs with the releases of other
+// holders, as in cow.h.
+static PVecNode *__pvec_editable__(PVecNode *node, unsigned level, size_t item_size) {
+    if(atomic_load_explicit(&node->refs, memory_order_acquire) == 1) return node;
+
+    PVecNode *copy;
+    if(level > 0) {
+        copy = __pvec_node__(__PVEC_BRANCH * sizeof(PVecNode *));
+        for(unsigned i = 0; i < __PVEC_BRANCH; ++i) {
+            __pvec_children__(copy)[i] = __pvec_retain__(__pvec_children__(node)[i]);
+        }
+    } else {
+        copy = __pvec_node__(__PVEC_BRANCH * item_size);
+        memcpy(copy->data, node->data, __PVEC_BRANCH * item_size);
+    }
+    __pvec_release_node__(node, level);
+    return copy;
+}
+
+// Index of the first element stored in the tail.
+static inline size_t __pvec_tailoff__(size_t length) {
+    return length < __PVEC_BRANCH ? 0 : ((length - 1) >> __PVEC_BITS) << __PVEC_BITS;
+}
+
+static PVecNode *__pvec_leaf_for__(const PVec *v, size_t idx) {
+    if(idx >= __pvec_tailoff__(v->length)) return v->tail;
+    PVecNode *node = v->root;
+    for(unsigned level = v->shift; level > 0; level -= __PVEC_BITS) {
+        node = __pvec_children__(node)[(idx >> level) & __PVEC_MASK];
+    }
+    return node;
+}
+
+// A chain of single-child branches from `level` down to `leaf`.
+static PVecNode *__pvec_new_path__(unsigned level, PVecNode *leaf) {
+    if(level == 0) return leaf;
+    PVecNode *node = __pvec_branch__();
+    __pvec_children__(node)[0] = __pvec_new_path__(level - __PVEC_BITS, leaf);
+    return node;
+}
+
+// Moves the full tail into the trie, growing it by one level when the root is full.
+static void __pvec_push_tail__(PVec *v) {
+    size_t last = v->length - 1;
+    if(!v->root) v->root = __pvec_branch__();
+
+    if((v->length >> __PVEC_BITS) > ((size_t)1 << v->shift)) {
+        PVecNode *root = __pvec_branch__();
+        __pvec_children__(root)[0] = v->root;
+        __pvec_children__(root)[1] = __pvec_new_path__(v->shift, v->tail);
+        v->root   = root;
+        v->shift += __PVEC_BITS;
+        return;
+    }
+
+    PVecNode *node = v->root = __pvec_editable__(v->root, v->shift, v->item_size);
+    for(unsigned level = v->shift; level > __PVEC_BITS; level -= __PVEC_BITS) {
+        PVecNode **slot = &__pvec_children__(node)[(last >> level) & __PVEC_MASK];
+        if(!*slot) {
+            *slot = __pvec_new_path__(level - __PVEC_BITS, v->tail);
+            return;
+        }
+        node = *slot = __pvec_editable__(*slot, level - __PVEC_BITS, v->item_size);
+    }
+    __pvec_children__(node)[(last >> __PVEC_BITS) & __PVEC_MASK] = v->tail;
+}
+
+// Removes the leaf holding element `last` (the new last element) from the
+// subtree; consumes the caller's reference and returns NULL if it empties.
+static PVecNode *__pvec_pop_tail__(PVecNode *node, unsigned level, size_t last, size_t item_size) {
+    size_t sub = (last >> level) & __PVEC_MASK;
+    node = __pvec_editable__(node, level, item_size);
+    PVecNode **slot = &__pvec_children__(node)[sub];
+    if(level > __PVEC_BITS) {
+        *slot = __pvec_pop_tail__(*slot, level - __PVEC_BITS, last, item_size);
+    } else {
+        __pvec_release_node__(*slot, 0);
+        *slot = NULL;
+    }
+    if(sub == 0 && !*slot) {
+        __pvec_release_node__(node, level);
+        return NULL;
+    }
+    return node;
+}
+
+PVec __pvec_create(size_t item_size) {
+    return (PVec){ .root = NULL, .tail = NULL, .length = 0, .item_size = item_size, .shift = __PVEC_BITS };
+}
+
+PVec __pvec_from(const void *items, size_t length, size_t item_size) {
+    PVec v = __pvec_create(item_size);
+    __pvec_transient_append_n(&v, items, length);
+    return v;
+}
+
+PVec pvec_clone(PVec v) {
+    __pvec_retain__(v.root);
+    __pvec_retain__(v.tail);
+    return v;
+}
+
+void pvec_release(PVec v) {
+    __pvec_release_node__(v.root, v.shift);
+    __pvec_release_node__(v.tail, 0);
+}
+
+const void *__pvec_at(const PVec *v, size_t idx) {
+    if(idx >= v->length) {
+        fprintf(stderr, "__pvec_at failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+    return __pvec_items__(__pvec_leaf_for__(v, idx)) + (idx & __PVEC_MASK) * v->item_size;
+}
+
+const void *__pvec_chunk(const PVec *v, size_t idx, size_t *count) {
+    if(idx >= v->length) {
+        fprintf(stderr, "__pvec_chunk failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t end = idx >= __pvec_tailoff__(v->length) ? v->length : (idx | __PVEC_MASK) + 1;
+    *count = end - idx;
+    return __pvec_items__(__pvec_leaf_for__(v, idx)) + (idx & __PVEC_MASK) * v->item_size;
+}
+
+void __pvec_transient_append_n(PVec *v, const void *items, size_t count) {
+    const char *p = items;
+    size_t size   = v->item_size;
+    while(count > 0) {
+        size_t used = v->length - __pvec_tailoff__(v->length);
+        if(!v->tail) {
+            v->tail = __pvec_node__(__PVEC_BRANCH * size);
+        } else if(used == __PVEC_BRANCH) {
+            __pvec_push_tail__(v);
+            v->tail = __pvec_node__(__PVEC_BRANCH * size);
+            used = 0;
+        } else {
+            v->tail = __pvec_editable__(v->tail, 0, size);
+        }
+
+        size_t take = __PVEC_BRANCH - used < count ? __PVEC_BRANCH - used : count;
+        memcpy(__pvec_items__(v->tail) + used * size, p, take * size);
+        v->length += take;
+        p         += take * size;
+        count     -= take;
+    }
+}
+
+void __pvec_transient_set(PVec *v, size_t idx, const void *item) {
+    if(idx >= v->length) {
+        fprintf(stderr, "__pvec_transient_set failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t size = v->item_size;
+    PVecNode *node;
+    if(idx >= __pvec_tailoff__(v->length)) {
+        node = v->tail = __pvec_editable__(v->tail, 0, size);
+    } else {
+        node = v->root = __pvec_editable__(v->root, v->shift, size);
+        for(unsigned level = v->shift; level > 0; level -= __PVEC_BITS) {
+            PVecNode **slot = &__pvec_children__(node)[(idx >> level) & __PVEC_MASK];
+            node = *slot = __pvec_editable__(*slot, level - __PVEC_BITS, size);
+        }
+    }
+    memcpy(__pvec_items__(node) + (idx & __PVEC_MASK) * size, item, size);
+}
+
+void pvec_transient_pop(PVec *v) {
+    if(v->length == 0) {
+        fprintf(stderr, "pvec_transient_pop failed: vector is empty.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Elements past the length are never read, so dropping one from the
+    // tail needs no copy even when the tail is shared.
+    if(v->length - __pvec_tailoff__(v->length) > 1) {
+        v->length -= 1;
+        return;
+    }
+    if(v->length == 1) {
+        pvec_release(*v);
+        *v = __pvec_create(v->item_size);
+        return;
+    }
+
+    // The tail empties: the last leaf of the trie becomes the new tail.
+    size_t last   = v->length - 2;
+    PVecNode *leaf = __pvec_retain__(__pvec_leaf_for__(v, last));
+    v->root = __pvec_pop_tail__(v->root, v->shift, last, v->item_size);
+    __pvec_release_node__(v->tail, 0);
+    v->tail    = leaf;
+    v->length -= 1;
+
+    if(!v->root) {
+        v->shift = __PVEC_BITS;
+    } else if(v->shift > __PVEC_BITS && !__pvec_children__(v->root)[1]) {
+        PVecNode *child = __pvec_retain__(__pvec_children__(v->root)[0]);
+        __pvec_release_node__(v->root, v->shift);
+        v->root   = child;
+        v->shift -= __PVEC_BITS;
+    }
+}
+
+PVec __pvec_push(PVec v, const void *item) {
+    PVec next = pvec_clone(v);
+    __pvec_transient_append_n(&next, item, 1);
+    return next;
+}
+
+PVec __pvec_set(PVec v, size_t idx, const void *item) {
+    PVec next = pvec_clone(v);
+    __pvec_transient_set(&next, idx, item);
+    return next;
+}
+
+PVec pvec_pop(PVec v) {
+    PVec next = pvec_clone(v);
+    pvec_transient_pop(&next);
+    return next;
+}
+
+void *__pvec_to_array(PVec v) {
+    void *arr = __array_create(v.item_size);
+    for(size_t i = 0, n; i < v.length; i += n) {
+        const void *run = __pvec_chunk(&v, i, &n);
+        arr = __array_insert_n(arr, i, run, n);
+    }
+    return arr;
+}
+
+#endif // COLLECTIONS_PVEC_IMPLEMENTATION
+#endif // COLLECTIONS_PVEC_H
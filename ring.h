@@ -0,0 +1,382 @@
+#ifndef COLLECTIONS_RING_H
+#define COLLECTIONS_RING_H
+
+
+#include <stdio.h>
+
+void        *__ring_create(size_t item_size);
+void        *__ring_push_back(void *ring, const void *item);
+void        *__ring_push_front(void *ring, const void *item);
+void        *__ring_pop_back(void *ring);
+void        *__ring_pop_front(void *ring);
+void        *__ring_at(void *ring, size_t idx);
+void        *__ring_back(void *ring);
+void        *__ring_push_back_n(void *ring, const void *items, size_t count);
+size_t      __ring_pop_front_n(void *ring, void *out, size_t count);
+size_t      __ring_length(void *ring);
+void        __ring_clear(void *ring);
+void        __ring_destroy(void *ring);
+
+/**
+ * @brief Defines a ring buffer (double-ended queue) type for a given element type.
+ *
+ * Like `Array(T)`, this is a plain pointer to the element storage, preceded in
+ * memory by a `RingHeader`. The storage is circular, so `p[i]` is not the i-th
+ * element in queue order; use `ring_at` instead.
+ *
+ * Example:
+ * ```c
+ * Ring(int) queue = ring_create(int);
+ * ```
+ *
+ * @tparam T The element type of the ring.
+ */
+#define Ring(T) T *
+
+/**
+ * @brief Creates a new, empty ring buffer for elements of type `T`.
+ *
+ * The capacity is always a power of two, so wrapping an index is a single mask.
+ *
+ * Example:
+ * ```c
+ * Ring(Job) jobs = ring_create(Job);
+ * ```
+ *
+ * @tparam T The element type.
+ * @return Pointer to the start of the ring storage.
+ */
+#define ring_create(T)                  ((T *)(__ring_create(sizeof(T))))
+
+/**
+ * @brief Appends an element at the back of the ring.
+ *
+ * Doubles the capacity when full. Growth reallocates and then moves only the
+ * wrapped prefix behind the old end, so the contents are unwrapped in one pass.
+ * The pointer returned may differ from the original.
+ *
+ * Example:
+ * ```c
+ * queue = ring_push_back(int, queue, 42);
+ * ```
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the ring.
+ * @param v  The value to append.
+ * @return Updated pointer to the ring storage.
+ */
+#define ring_push_back(T, p, v)         ((T *)__ring_push_back(p, (T[]){ (v) }))
+
+/**
+ * @brief Prepends an element at the front of the ring.
+ *
+ * Same growth behaviour as `ring_push_back`.
+ *
+ * Example:
+ * ```c
+ * queue = ring_push_front(int, queue, 7);
+ * ```
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the ring.
+ * @param v  The value to prepend.
+ * @return Updated pointer to the ring storage.
+ */
+#define ring_push_front(T, p, v)        ((T *)__ring_push_front(p, (T[]){ (v) }))
+
+/**
+ * @brief Removes and returns the element at the back of the ring.
+ *
+ * Example:
+ * ```c
+ * int last = ring_pop_back(int, queue);
+ * ```
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the ring.
+ * @return The removed element.
+ */
+#define ring_pop_back(T, p)             (*((T *)__ring_pop_back(p)))
+
+/**
+ * @brief Removes and returns the element at the front of the ring.
+ *
+ * Example:
+ * ```c
+ * int first = ring_pop_front(int, queue);
+ * ```
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the ring.
+ * @return The removed element.
+ */
+#define ring_pop_front(T, p)            (*((T *)__ring_pop_front(p)))
+
+/**
+ * @brief Retrieves the element at a logical position (0 is the front).
+ *
+ * Example:
+ * ```c
+ * int second = ring_at(int, queue, 1);
+ * ```
+ *
+ * @tparam T  The element type.
+ * @param p   Pointer to the ring.
+ * @param idx Logical index, counted from the front.
+ * @return The element at that position.
+ */
+#define ring_at(T, p, idx)              (*((T *)__ring_at(p, idx)))
+
+/**
+ * @brief Returns the element at the front of a non-empty ring.
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the ring.
+ */
+#define ring_front(T, p)                (ring_at(T, p, 0))
+
+/**
+ * @brief Returns the element at the back of a non-empty ring.
+ *
+ * @tparam T The element type.
+ * @param p  Pointer to the ring.
+ */
+#define ring_back(T, p)                 (*((T *)__ring_back(p)))
+
+/**
+ * @brief Appends `n` elements at the back of the ring.
+ *
+ * Grows at most once, then copies the items with at most two `memcpy` calls
+ * (one up to the physical end of the storage, one from its start).
+ *
+ * Example:
+ * ```c
+ * queue = ring_push_back_n(int, queue, batch, 64);
+ * ```
+ *
+ * @tparam T    The element type.
+ * @param p     Pointer to the ring.
+ * @param items Pointer to `n` elements to copy.
+ * @param n     Number of elements.
+ * @return Updated pointer to the ring storage.
+ */
+#define ring_push_back_n(T, p, items, n) ((T *)__ring_push_back_n(p, items, n))
+
+/**
+ * @brief Removes up to `n` elements from the front of the ring into `out`.
+ *
+ * Copies with at most two `memcpy` calls.
+ *
+ * Example:
+ * ```c
+ * int batch[64];
+ * size_t got = ring_pop_front_n(queue, batch, 64);
+ * ```
+ *
+ * @param p   Pointer to the ring.
+ * @param out Destination buffer with room for `n` elements.
+ * @param n   Maximum number of elements to remove.
+ * @return The number of elements actually removed.
+ */
+#define ring_pop_front_n(p, out, n)     (__ring_pop_front_n(p, out, n))
+
+/**
+ * @brief Returns the number of elements in the ring.
+ *
+ * @param p Pointer to the ring.
+ */
+#define ring_length(p)                  (__ring_length(p))
+
+/**
+ * @brief Removes all elements, keeping the allocated capacity.
+ *
+ * @param p Pointer to the ring.
+ */
+#define ring_clear(p)                   (__ring_clear(p))
+
+/**
+ * @brief Destroys the ring and frees its allocated memory.
+ *
+ * @param p Pointer to the ring.
+ */
+#define ring_destroy(p)                 (__ring_destroy(p))
+
+#ifdef COLLECTIONS_RING_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+#define __RING_INITIAL_CAPACITY 16
+
+/**
+ * @brief Metadata stored immediately before the ring storage.
+ *
+ * `cap` is always a power of two; the element at logical index `i` lives in
+ * slot `(head + i) & (cap - 1)`.
+ */
+typedef struct {
+    size_t  head;
+    size_t  length;
+    size_t  cap;
+    size_t  item_size;
+} RingHeader;
+
+#define ringheader(p) ((RingHeader *)(p) - 1)
+
+static inline char *__ring_slot__(void *ring, size_t idx) {
+    RingHeader *header = ringheader(ring);
+    return (char *)ring + ((header->head + idx) & (header->cap - 1)) * header->item_size;
+}
+
+// Makes room for at least `extra` more elements. After realloc the elements
+// in [head, old_cap) are still in place, so only the wrapped prefix
+// [0, head + length - old_cap) has to move, to just past the old end.
+static void *__ring_grow__(void *ring, size_t extra) {
+    RingHeader *header = ringheader(ring);
+    size_t need = header->length + extra;
+    if(need <= header->cap) return ring;
+
+    size_t old_cap = header->cap;
+    size_t cap = old_cap;
+    while(cap < need) cap *= 2;
+
+    void *p = realloc(header, sizeof(RingHeader) + cap * header->item_size);
+    if(!p) {
+        fprintf(stderr, "__ring_grow__ failed: cannot resize ring.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    header = (RingHeader *)p;
+    header->cap = cap;
+    ring = (void *)(header + 1);
+
+    if(header->head + header->length > old_cap) {
+        size_t wrapped = header->head + header->length - old_cap;
+        memcpy((char *)ring + old_cap * header->item_size, ring, wrapped * header->item_size);
+    }
+
+    return ring;
+}
+
+void *__ring_create(size_t item_size) {
+    RingHeader *header = malloc(sizeof(RingHeader) + __RING_INITIAL_CAPACITY * item_size);
+    if(!header) {
+        fprintf(stderr, "__ring_create failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    header->head      = 0;
+    header->length    = 0;
+    header->cap       = __RING_INITIAL_CAPACITY;
+    header->item_size = item_size;
+
+    return (void *)(header + 1);
+}
+
+void *__ring_push_back(void *ring, const void *item) {
+    ring = __ring_grow__(ring, 1);
+    RingHeader *header = ringheader(ring);
+    header->length += 1;
+    memcpy(__ring_slot__(ring, header->length - 1), item, header->item_size);
+    return ring;
+}
+
+void *__ring_push_front(void *ring, const void *item) {
+    ring = __ring_grow__(ring, 1);
+    RingHeader *header = ringheader(ring);
+    header->head    = (header->head - 1) & (header->cap - 1);
+    header->length += 1;
+    memcpy(__ring_slot__(ring, 0), item, header->item_size);
+    return ring;
+}
+
+void *__ring_pop_back(void *ring) {
+    RingHeader *header = ringheader(ring);
+    if(header->length == 0) {
+        fprintf(stderr, "__ring_pop_back failed: ring is empty.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    header->length -= 1;
+    return __ring_slot__(ring, header->length);
+}
+
+void *__ring_pop_front(void *ring) {
+    RingHeader *header = ringheader(ring);
+    if(header->length == 0) {
+        fprintf(stderr, "__ring_pop_front failed: ring is empty.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    void *item = __ring_slot__(ring, 0);
+    header->head    = (header->head + 1) & (header->cap - 1);
+    header->length -= 1;
+    return item;
+}
+
+void *__ring_at(void *ring, size_t idx) {
+    RingHeader *header = ringheader(ring);
+    if(idx >= header->length) {
+        fprintf(stderr, "__ring_at failed: index out of range.\n");
+        exit(EXIT_FAILURE);
+    }
+    return __ring_slot__(ring, idx);
+}
+
+void *__ring_back(void *ring) {
+    RingHeader *header = ringheader(ring);
+    if(header->length == 0) {
+        fprintf(stderr, "__ring_back failed: ring is empty.\n");
+        exit(EXIT_FAILURE);
+    }
+    return __ring_slot__(ring, header->length - 1);
+}
+
+void *__ring_push_back_n(void *ring, const void *items, size_t count) {
+    ring = __ring_grow__(ring, count);
+    RingHeader *header = ringheader(ring);
+    size_t size = header->item_size;
+
+    size_t tail  = (header->head + header->length) & (header->cap - 1);
+    size_t first = header->cap - tail < count ? header->cap - tail : count;
+    memcpy((char *)ring + tail * size, items, first * size);
+    memcpy(ring, (const char *)items + first * size, (count - first) * size);
+
+    header->length += count;
+    return ring;
+}
+
+size_t __ring_pop_front_n(void *ring, void *out, size_t count) {
+    RingHeader *header = ringheader(ring);
+    size_t size = header->item_size;
+    if(count > header->length) count = header->length;
+
+    size_t first = header->cap - header->head < count ? header->cap - header->head : count;
+    memcpy(out, (char *)ring + header->head * size, first * size);
+    memcpy((char *)out + first * size, ring, (count - first) * size);
+
+    header->head    = (header->head + count) & (header->cap - 1);
+    header->length -= count;
+    return count;
+}
+
+size_t __ring_length(void *ring) {
+    RingHeader *header = ringheader(ring);
+    return header->length;
+}
+
+void __ring_clear(void *ring) {
+    RingHeader *header = ringheader(ring);
+    header->head   = 0;
+    header->length = 0;
+}
+
+void __ring_destroy(void *ring) {
+    RingHeader *header = ringheader(ring);
+    free(header);
+}
+
+#endif // COLLECTIONS_RING_IMPLEMENTATION
+
+
+#endif // COLLECTIONS_RING_H
@@ -0,0 +1,754 @@
+#ifndef COLLECTIONS_ROARING_H
+#define COLLECTIONS_ROARING_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/**
+ * @brief A maximal run of consecutive values `[start, start + length]` in one chunk.
+ */
+typedef struct {
+    uint16_t start;  /**< First value of the run. */
+    uint16_t length; /**< Number of values after `start` in the run. */
+} RoaringRun;
+
+/**
+ * @brief The set of low 16-bit halves that share one high half.
+ *
+ * Depending on its density a container is a sorted `Array(uint16_t)` (up to
+ * 4096 values), a 1024-word `Array(uint64_t)` bitmap, or a sorted
+ * `Array(RoaringRun)`.
+ */
+typedef struct {
+    uint32_t  type;        /**< Array, bitmap or run container. */
+    uint32_t  cardinality; /**< Number of values in the container. */
+    void     *data;        /**< array.h storage; its element type depends on `type`. */
+} RoaringContainer;
+
+/**
+ * @brief A compressed set of 32-bit integers (Roaring bitmap).
+ *
+ * Values are split into a 16-bit chunk key and a 16-bit low half. The chunk
+ * directory is a sorted `Array(uint16_t)` searched with `array_lower_bound`,
+ * parallel to an `Array(RoaringContainer)`. Empty chunks are never stored.
+ */
+typedef struct {
+    uint16_t         *keys;       /**< Sorted chunk keys. */
+    RoaringContainer *containers; /**< One container per key. */
+} Roaring;
+
+/**
+ * @brief Creates an empty bitmap.
+ *
+ * @return A new Roaring; release it with `roaring_destroy`.
+ */
+Roaring roaring_create(void);
+
+/**
+ * @brief Frees all containers and the directory of a bitmap.
+ *
+ * @param r Bitmap to destroy.
+ */
+void roaring_destroy(Roaring *r);
+
+/**
+ * @brief Adds a value to the bitmap.
+ *
+ * A run container that receives a value is expanded back to an array or
+ * bitmap container; call `roaring_optimize` again afterwards.
+ *
+ * @param r Bitmap to modify.
+ * @param value Value to add.
+ */
+void roaring_add(Roaring *r, uint32_t value);
+
+/**
+ * @brief Removes a value from the bitmap.
+ *
+ * @param r Bitmap to modify.
+ * @param value Value to remove.
+ * @return true if the value was present.
+ */
+bool roaring_remove(Roaring *r, uint32_t value);
+
+/**
+ * @brief Checks whether a value is in the bitmap.
+ *
+ * @param r Input bitmap.
+ * @param value Value to look up.
+ * @return true if present.
+ */
+bool roaring_contains(const Roaring *r, uint32_t value);
+
+/**
+ * @brief Returns the number of values in the bitmap.
+ *
+ * Each container keeps its own count, so this is linear in the number of chunks.
+ *
+ * @param r Input bitmap.
+ * @return Cardinality of the set.
+ */
+uint64_t roaring_cardinality(const Roaring *r);
+
+/**
+ * @brief Computes the intersection of two bitmaps.
+ *
+ * Array pairs of very different sizes are intersected by galloping through
+ * the larger one; bitmap pairs are combined word by word.
+ *
+ * @param a First operand.
+ * @param b Second operand.
+ * @return A new bitmap holding `a & b`.
+ */
+Roaring roaring_and(const Roaring *a, const Roaring *b);
+
+/**
+ * @brief Computes the union of two bitmaps.
+ *
+ * @param a First operand.
+ * @param b Second operand.
+ * @return A new bitmap holding `a | b`.
+ */
+Roaring roaring_or(const Roaring *a, const Roaring *b);
+
+/**
+ * @brief Converts every container to its smallest representation.
+ *
+ * Containers holding long stretches of consecutive values become run
+ * containers; the others stay (or become) arrays or bitmaps.
+ *
+ * @param r Bitmap to compact.
+ */
+void roaring_optimize(Roaring *r);
+
+/**
+ * @brief Copies all values to `out` in increasing order.
+ *
+ * @param r Input bitmap.
+ * @param out Buffer with room for `roaring_cardinality(r)` values.
+ * @return Number of values written.
+ */
+size_t roaring_to_array(const Roaring *r, uint32_t *out);
+
+/**
+ * @brief Returns the number of bytes `roaring_serialize` writes.
+ *
+ * @param r Input bitmap.
+ * @return Serialized size in bytes.
+ */
+size_t roaring_serialized_size(const Roaring *r);
+
+/**
+ * @brief Writes the bitmap to `buffer` in a portable little-endian format.
+ *
+ * The layout is a `"RBM1"` magic and the chunk count (both `uint32_t`),
+ * followed for each chunk by its key (`uint16_t`), container type
+ * (`uint16_t`), element count (`uint32_t`) and payload: the sorted values, the
+ * 1024 bitmap words, or `(start, length)` pairs.
+ *
+ * @param r Input bitmap.
+ * @param buffer Destination with room for `roaring_serialized_size(r)` bytes.
+ * @return Number of bytes written.
+ */
+size_t roaring_serialize(const Roaring *r, void *buffer);
+
+/**
+ * @brief Reads a bitmap written by `roaring_serialize`.
+ *
+ * Malformed or truncated input is reported on stderr and ends the program.
+ *
+ * @param buffer Serialized bytes.
+ * @param size Number of bytes available in `buffer`.
+ * @return A new bitmap.
+ */
+Roaring roaring_deserialize(const void *buffer, size_t size);
+
+
+#ifdef COLLECTIONS_ROARING_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+enum { __ROARING_ARRAY, __ROARING_BITMAP, __ROARING_RUN };
+
+#define __ROARING_MAGIC             0x314d4252u // "RBM1"
+#define __ROARING_BITMAP_WORDS      1024
+#define __ROARING_ARRAY_MAX         4096
+#define __ROARING_GALLOP_RATIO      32
+
+static uint64_t *__roaring_bitmap_new__(void) {
+    uint64_t *words = array_insert_n(uint64_t, array_create(uint64_t), 0, NULL, __ROARING_BITMAP_WORDS);
+    memset(words, 0, __ROARING_BITMAP_WORDS * sizeof(uint64_t));
+    return words;
+}
+
+static uint32_t __roaring_popcount__(const uint64_t *words) {
+    uint32_t count = 0;
+    for(size_t i = 0; i < __ROARING_BITMAP_WORDS; ++i) count += (uint32_t)__builtin_popcountll(words[i]);
+    return count;
+}
+
+static uint16_t *__roaring_bitmap_values__(const uint64_t *words, uint32_t cardinality) {
+    uint16_t *values = array_insert_n(uint16_t, array_create(uint16_t), 0, NULL, cardinality);
+    size_t n = 0;
+    for(size_t w = 0; w < __ROARING_BITMAP_WORDS; ++w) {
+        for(uint64_t word = words[w]; word != 0; word &= word - 1) {
+            values[n++] = (uint16_t)(w * 64 + (size_t)__builtin_ctzll(word));
+        }
+    }
+    return values;
+}
+
+static void __roaring_set_range__(uint64_t *words, uint32_t lower, uint32_t upper) {
+    for(uint32_t v = lower; v <= upper;) {
+        if(v % 64 == 0 && upper - v >= 63) {
+            words[v / 64] = ~UINT64_C(0);
+            v += 64;
+        } else {
+            words[v / 64] |= UINT64_C(1) << (v % 64);
+            v += 1;
+        }
+    }
+}
+
+static void __roaring_container_free__(RoaringContainer *c) {
+    array_destroy(c->data);
+    c->data = NULL;
+}
+
+static RoaringContainer __roaring_container_copy__(const RoaringContainer *c) {
+    RoaringContainer copy = *c;
+    size_t n = array_length(c->data);
+    switch(c->type) {
+        case __ROARING_ARRAY:
+            copy.data = array_insert_n(uint16_t, array_create(uint16_t), 0, c->data, n);
+            break;
+        case __ROARING_BITMAP:
+            copy.data = array_insert_n(uint64_t, array_create(uint64_t), 0, c->data, n);
+            break;
+        case __ROARING_RUN:
+            copy.data = array_insert_n(RoaringRun, array_create(RoaringRun), 0, c->data, n);
+            break;
+    }
+    return copy;
+}
+
+/**
+ * @brief Converts a container to an array or bitmap in place, whichever its cardinality calls for.
+ */
+static void __roaring_container_normalize__(RoaringContainer *c) {
+    if(c->type == __ROARING_ARRAY && c->cardinality > __ROARING_ARRAY_MAX) {
+        uint16_t *values = c->data;
+        uint64_t *words  = __roaring_bitmap_new__();
+        for(size_t i = 0; i < c->cardinality; ++i) words[values[i] / 64] |= UINT64_C(1) << (values[i] % 64);
+        array_destroy(values);
+        c->type = __ROARING_BITMAP;
+        c->data = words;
+    } else if(c->type == __ROARING_BITMAP && c->cardinality <= __ROARING_ARRAY_MAX) {
+        uint16_t *values = __roaring_bitmap_values__(c->data, c->cardinality);
+        array_destroy(c->data);
+        c->type = __ROARING_ARRAY;
+        c->data = values;
+    } else if(c->type == __ROARING_RUN) {
+        RoaringRun *runs = c->data;
+        uint64_t *words  = __roaring_bitmap_new__();
+        for(size_t i = 0; i < array_length(runs); ++i) {
+            __roaring_set_range__(words, runs[i].start, (uint32_t)runs[i].start + runs[i].length);
+        }
+        array_destroy(runs);
+        c->type = __ROARING_BITMAP;
+        c->data = words;
+        __roaring_container_normalize__(c);
+    }
+}
+
+static bool __roaring_container_contains__(const RoaringContainer *c, uint16_t low) {
+    switch(c->type) {
+        case __ROARING_ARRAY: {
+            uint16_t *values = c->data;
+            size_t idx = array_lower_bound(uint16_t, values, low);
+            return idx < array_length(values) && values[idx] == low;
+        }
+        case __ROARING_BITMAP: {
+            const uint64_t *words = c->data;
+            return (words[low / 64] >> (low % 64)) & 1;
+        }
+        default: {
+            RoaringRun *runs = c->data;
+            size_t lo = 0, hi = array_length(runs);
+            while(lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if(runs[mid].start <= low) lo = mid + 1;
+                else hi = mid;
+            }
+            return lo > 0 && low - runs[lo - 1].start <= runs[lo - 1].length;
+        }
+    }
+}
+
+static size_t __roaring_find_key__(const Roaring *r, uint16_t key) {
+    size_t idx = array_lower_bound(uint16_t, r->keys, key);
+    if(idx < array_length(r->keys) && r->keys[idx] == key) return idx;
+    return ARRAY_NPOS;
+}
+
+static void __roaring_append__(Roaring *r, uint16_t key, RoaringContainer c) {
+    if(c.cardinality == 0) {
+        __roaring_container_free__(&c);
+        return;
+    }
+    r->keys = array_append(uint16_t, r->keys);
+    r->keys[array_length(r->keys) - 1] = key;
+    r->containers = array_append(RoaringContainer, r->containers);
+    r->containers[array_length(r->containers) - 1] = c;
+}
+
+Roaring roaring_create(void) {
+    return (Roaring) {
+        .keys       = array_create(uint16_t),
+        .containers = array_create(RoaringContainer),
+    };
+}
+
+void roaring_destroy(Roaring *r) {
+    for(size_t i = 0; i < array_length(r->containers); ++i) __roaring_container_free__(&r->containers[i]);
+    array_destroy(r->keys);
+    array_destroy(r->containers);
+    r->keys       = NULL;
+    r->containers = NULL;
+}
+
+void roaring_add(Roaring *r, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16), low = (uint16_t)value;
+
+    size_t idx = array_lower_bound(uint16_t, r->keys, key);
+    if(idx == array_length(r->keys) || r->keys[idx] != key) {
+        RoaringContainer c = { __ROARING_ARRAY, 0, array_create(uint16_t) };
+        r->keys       = array_insert(uint16_t, r->keys, idx, key);
+        r->containers = array_insert(RoaringContainer, r->containers, idx, c);
+    }
+
+    RoaringContainer *c = &r->containers[idx];
+    if(c->type == __ROARING_RUN) {
+        if(__roaring_container_contains__(c, low)) return;
+        __roaring_container_normalize__(c);
+    }
+
+    if(c->type == __ROARING_ARRAY) {
+        uint16_t *values = c->data;
+        size_t pos = array_lower_bound(uint16_t, values, low);
+        if(pos < array_length(values) && values[pos] == low) return;
+        c->data = array_insert(uint16_t, values, pos, low);
+        c->cardinality++;
+        __roaring_container_normalize__(c);
+    } else {
+        uint64_t *words = c->data;
+        uint64_t bit = UINT64_C(1) << (low % 64);
+        c->cardinality += !(words[low / 64] & bit);
+        words[low / 64] |= bit;
+    }
+}
+
+bool roaring_remove(Roaring *r, uint32_t value) {
+    uint16_t key = (uint16_t)(value >> 16), low = (uint16_t)value;
+
+    size_t idx = __roaring_find_key__(r, key);
+    if(idx == ARRAY_NPOS) return false;
+
+    RoaringContainer *c = &r->containers[idx];
+    if(!__roaring_container_contains__(c, low)) return false;
+    if(c->type == __ROARING_RUN) __roaring_container_normalize__(c);
+
+    if(c->type == __ROARING_ARRAY) {
+        array_remove(c->data, array_lower_bound(uint16_t, (uint16_t *)c->data, low));
+    } else {
+        ((uint64_t *)c->data)[low / 64] &= ~(UINT64_C(1) << (low % 64));
+    }
+    c->cardinality--;
+
+    if(c->cardinality == 0) {
+        __roaring_container_free__(c);
+        array_remove(r->keys, idx);
+        array_remove(r->containers, idx);
+    } else {
+        __roaring_container_normalize__(c);
+    }
+    return true;
+}
+
+bool roaring_contains(const Roaring *r, uint32_t value) {
+    size_t idx = __roaring_find_key__(r, (uint16_t)(value >> 16));
+    return idx != ARRAY_NPOS && __roaring_container_contains__(&r->containers[idx], (uint16_t)value);
+}
+
+uint64_t roaring_cardinality(const Roaring *r) {
+    uint64_t total = 0;
+    for(size_t i = 0; i < array_length(r->containers); ++i) total += r->containers[i].cardinality;
+    return total;
+}
+
+/**
+ * @brief Returns the first index in `values[lo, n)` whose value is at least
+ * `target`, probing 1, 2, 4, ... positions ahead before a binary search.
+ */
+static size_t __roaring_gallop__(const uint16_t *values, size_t lo, size_t n, uint16_t target) {
+    size_t step = 1, hi = lo;
+    while(hi < n && values[hi] < target) {
+        lo = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    if(hi > n) hi = n;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(values[mid] < target) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static RoaringContainer __roaring_and_array_array__(uint16_t *a, uint16_t *b) {
+    size_t na = array_length(a), nb = array_length(b);
+    if(na > nb) {
+        uint16_t *t = a; a = b; b = t;
+        size_t tn = na; na = nb; nb = tn;
+    }
+
+    uint16_t *out = array_insert_n(uint16_t, array_create(uint16_t), 0, NULL, na);
+    size_t n = 0;
+    if(na * __ROARING_GALLOP_RATIO < nb) {
+        size_t j = 0;
+        for(size_t i = 0; i < na && j < nb; ++i) {
+            j = __roaring_gallop__(b, j, nb, a[i]);
+            if(j < nb && b[j] == a[i]) out[n++] = a[i];
+        }
+    } else {
+        size_t i = 0, j = 0;
+        while(i < na && j < nb) {
+            uint16_t x = a[i], y = b[j];
+            if(x == y) out[n++] = x;
+            i += x <= y;
+            j += y <= x;
+        }
+    }
+    array_truncate(out, n);
+    return (RoaringContainer) { __ROARING_ARRAY, (uint32_t)n, out };
+}
+
+static RoaringContainer __roaring_and_array_bitmap__(uint16_t *a, const uint64_t *words) {
+    size_t na = array_length(a), n = 0;
+    uint16_t *out = array_insert_n(uint16_t, array_create(uint16_t), 0, NULL, na);
+    for(size_t i = 0; i < na; ++i) {
+        out[n] = a[i];
+        n += (words[a[i] / 64] >> (a[i] % 64)) & 1;
+    }
+    array_truncate(out, n);
+    return (RoaringContainer) { __ROARING_ARRAY, (uint32_t)n, out };
+}
+
+static RoaringContainer __roaring_and_bitmap_bitmap__(const uint64_t *a, const uint64_t *b) {
+    uint64_t *words = __roaring_bitmap_new__();
+    for(size_t i = 0; i < __ROARING_BITMAP_WORDS; ++i) words[i] = a[i] & b[i];
+    RoaringContainer c = { __ROARING_BITMAP, __roaring_popcount__(words), words };
+    __roaring_container_normalize__(&c);
+    return c;
+}
+
+static RoaringContainer __roaring_or_array_array__(uint16_t *a, uint16_t *b) {
+    size_t na = array_length(a), nb = array_length(b);
+    uint16_t *out = array_insert_n(uint16_t, array_create(uint16_t), 0, NULL, na + nb);
+    size_t i = 0, j = 0, n = 0;
+    while(i < na && j < nb) {
+        uint16_t x = a[i], y = b[j];
+        out[n++] = x <= y ? x : y;
+        i += x <= y;
+        j += y <= x;
+    }
+    while(i < na) out[n++] = a[i++];
+    while(j < nb) out[n++] = b[j++];
+    array_truncate(out, n);
+
+    RoaringContainer c = { __ROARING_ARRAY, (uint32_t)n, out };
+    __roaring_container_normalize__(&c);
+    return c;
+}
+
+static RoaringContainer __roaring_or_bitmap__(const uint64_t *a, const RoaringContainer *b) {
+    uint64_t *words = array_insert_n(uint64_t, array_create(uint64_t), 0, a, __ROARING_BITMAP_WORDS);
+    if(b->type == __ROARING_ARRAY) {
+        const uint16_t *values = b->data;
+        for(size_t i = 0; i < b->cardinality; ++i) words[values[i] / 64] |= UINT64_C(1) << (values[i] % 64);
+    } else {
+        const uint64_t *other = b->data;
+        for(size_t i = 0; i < __ROARING_BITMAP_WORDS; ++i) words[i] |= other[i];
+    }
+    return (RoaringContainer) { __ROARING_BITMAP, __roaring_popcount__(words), words };
+}
+
+/**
+ * @brief Combines two containers; run containers are expanded into temporaries first.
+ */
+static RoaringContainer __roaring_container_op__(const RoaringContainer *a, const RoaringContainer *b, bool intersect) {
+    RoaringContainer ta = { 0 }, tb = { 0 };
+    if(a->type == __ROARING_RUN) {
+        ta = __roaring_container_copy__(a);
+        __roaring_container_normalize__(&ta);
+        a = &ta;
+    }
+    if(b->type == __ROARING_RUN) {
+        tb = __roaring_container_copy__(b);
+        __roaring_container_normalize__(&tb);
+        b = &tb;
+    }
+    if(a->type == __ROARING_BITMAP && b->type == __ROARING_ARRAY) {
+        const RoaringContainer *t = a; a = b; b = t;
+    }
+
+    RoaringContainer out;
+    if(intersect) {
+        if(a->type == __ROARING_ARRAY && b->type == __ROARING_ARRAY) out = __roaring_and_array_array__(a->data, b->data);
+        else if(a->type == __ROARING_ARRAY) out = __roaring_and_array_bitmap__(a->data, b->data);
+        else out = __roaring_and_bitmap_bitmap__(a->data, b->data);
+    } else {
+        if(a->type == __ROARING_ARRAY && b->type == __ROARING_ARRAY) out = __roaring_or_array_array__(a->data, b->data);
+        else out = __roaring_or_bitmap__(b->data, a);
+    }
+
+    if(ta.data) __roaring_container_free__(&ta);
+    if(tb.data) __roaring_container_free__(&tb);
+    return out;
+}
+
+Roaring roaring_and(const Roaring *a, const Roaring *b) {
+    Roaring out = roaring_create();
+    size_t na = array_length(a->keys), nb = array_length(b->keys);
+    size_t i = 0, j = 0;
+    while(i < na && j < nb) {
+        if(a->keys[i] < b->keys[j]) {
+            i = array_lower_bound(uint16_t, a->keys, b->keys[j]);
+        } else if(b->keys[j] < a->keys[i]) {
+            j = array_lower_bound(uint16_t, b->keys, a->keys[i]);
+        } else {
+            __roaring_append__(&out, a->keys[i], __roaring_container_op__(&a->containers[i], &b->containers[j], true));
+            ++i;
+            ++j;
+        }
+    }
+    return out;
+}
+
+Roaring roaring_or(const Roaring *a, const Roaring *b) {
+    Roaring out = roaring_create();
+    size_t na = array_length(a->keys), nb = array_length(b->keys);
+    size_t i = 0, j = 0;
+    while(i < na || j < nb) {
+        if(j == nb || (i < na && a->keys[i] < b->keys[j])) {
+            __roaring_append__(&out, a->keys[i], __roaring_container_copy__(&a->containers[i]));
+            ++i;
+        } else if(i == na || b->keys[j] < a->keys[i]) {
+            __roaring_append__(&out, b->keys[j], __roaring_container_copy__(&b->containers[j]));
+            ++j;
+        } else {
+            __roaring_append__(&out, a->keys[i], __roaring_container_op__(&a->containers[i], &b->containers[j], false));
+            ++i;
+            ++j;
+        }
+    }
+    return out;
+}
+
+static RoaringRun *__roaring_runs_of__(const RoaringContainer *c) {
+    RoaringRun *runs = array_create(RoaringRun);
+    uint16_t *values = c->type == __ROARING_ARRAY ? c->data : __roaring_bitmap_values__(c->data, c->cardinality);
+
+    for(size_t i = 0; i < c->cardinality;) {
+        size_t j = i;
+        while(j + 1 < c->cardinality && values[j + 1] == values[j] + 1) ++j;
+        runs = array_append(RoaringRun, runs);
+        runs[array_length(runs) - 1] = (RoaringRun) { values[i], (uint16_t)(j - i) };
+        i = j + 1;
+    }
+
+    if(values != c->data) array_destroy(values);
+    return runs;
+}
+
+static size_t __roaring_run_count__(const RoaringContainer *c) {
+    size_t count = 0;
+    if(c->type == __ROARING_ARRAY) {
+        const uint16_t *values = c->data;
+        for(size_t i = 0; i < c->cardinality; ++i) count += i == 0 || values[i] != values[i - 1] + 1;
+    } else {
+        // A run starts at every set bit whose lower neighbour is clear.
+        const uint64_t *words = c->data;
+        uint64_t carry = 0;
+        for(size_t i = 0; i < __ROARING_BITMAP_WORDS; ++i) {
+            uint64_t w = words[i];
+            count += (size_t)__builtin_popcountll(w & ~((w << 1) | carry));
+            carry = w >> 63;
+        }
+    }
+    return count;
+}
+
+void roaring_optimize(Roaring *r) {
+    for(size_t i = 0; i < array_length(r->containers); ++i) {
+        RoaringContainer *c = &r->containers[i];
+        if(c->type == __ROARING_RUN) __roaring_container_normalize__(c);
+
+        size_t current = c->type == __ROARING_ARRAY ? c->cardinality * sizeof(uint16_t)
+                                                    : __ROARING_BITMAP_WORDS * sizeof(uint64_t);
+        if(__roaring_run_count__(c) * sizeof(RoaringRun) < current) {
+            RoaringRun *runs = __roaring_runs_of__(c);
+            array_destroy(c->data);
+            c->type = __ROARING_RUN;
+            c->data = runs;
+        }
+    }
+}
+
+size_t roaring_to_array(const Roaring *r, uint32_t *out) {
+    size_t n = 0;
+    for(size_t i = 0; i < array_length(r->keys); ++i) {
+        const RoaringContainer *c = &r->containers[i];
+        uint32_t high = (uint32_t)r->keys[i] << 16;
+
+        if(c->type == __ROARING_ARRAY) {
+            const uint16_t *values = c->data;
+            for(size_t j = 0; j < c->cardinality; ++j) out[n++] = high | values[j];
+        } else if(c->type == __ROARING_BITMAP) {
+            const uint64_t *words = c->data;
+            for(size_t w = 0; w < __ROARING_BITMAP_WORDS; ++w) {
+                for(uint64_t word = words[w]; word != 0; word &= word - 1) {
+                    out[n++] = high | (uint32_t)(w * 64 + (size_t)__builtin_ctzll(word));
+                }
+            }
+        } else {
+            RoaringRun *runs = c->data;
+            for(size_t j = 0; j < array_length(runs); ++j) {
+                for(uint32_t v = runs[j].start; v <= (uint32_t)runs[j].start + runs[j].length; ++v) out[n++] = high | v;
+            }
+        }
+    }
+    return n;
+}
+
+static unsigned char *__roaring_put__(unsigned char *p, uint64_t value, size_t bytes) {
+    for(size_t i = 0; i < bytes; ++i) p[i] = (unsigned char)(value >> (8 * i));
+    return p + bytes;
+}
+
+static uint64_t __roaring_get__(const unsigned char *p, size_t bytes) {
+    uint64_t value = 0;
+    for(size_t i = 0; i < bytes; ++i) value |= (uint64_t)p[i] << (8 * i);
+    return value;
+}
+
+static size_t __roaring_payload_size__(const RoaringContainer *c) {
+    switch(c->type) {
+        case __ROARING_ARRAY:  return c->cardinality * 2;
+        case __ROARING_BITMAP: return __ROARING_BITMAP_WORDS * 8;
+        default:               return array_length(c->data) * 4;
+    }
+}
+
+size_t roaring_serialized_size(const Roaring *r) {
+    size_t size = 8;
+    for(size_t i = 0; i < array_length(r->containers); ++i) size += 8 + __roaring_payload_size__(&r->containers[i]);
+    return size;
+}
+
+size_t roaring_serialize(const Roaring *r, void *buffer) {
+    unsigned char *p = buffer;
+    p = __roaring_put__(p, __ROARING_MAGIC, 4);
+    p = __roaring_put__(p, array_length(r->keys), 4);
+
+    for(size_t i = 0; i < array_length(r->keys); ++i) {
+        const RoaringContainer *c = &r->containers[i];
+        size_t count = c->type == __ROARING_RUN ? array_length(c->data) : c->cardinality;
+        p = __roaring_put__(p, r->keys[i], 2);
+        p = __roaring_put__(p, c->type, 2);
+        p = __roaring_put__(p, count, 4);
+
+        if(c->type == __ROARING_ARRAY) {
+            const uint16_t *values = c->data;
+            for(size_t j = 0; j < count; ++j) p = __roaring_put__(p, values[j], 2);
+        } else if(c->type == __ROARING_BITMAP) {
+            const uint64_t *words = c->data;
+            for(size_t j = 0; j < __ROARING_BITMAP_WORDS; ++j) p = __roaring_put__(p, words[j], 8);
+        } else {
+            const RoaringRun *runs = c->data;
+            for(size_t j = 0; j < count; ++j) {
+                p = __roaring_put__(p, runs[j].start, 2);
+                p = __roaring_put__(p, runs[j].length, 2);
+            }
+        }
+    }
+    return (size_t)(p - (unsigned char *)buffer);
+}
+
+static void __roaring_corrupt__(const char *what) {
+    fprintf(stderr, "roaring_deserialize failed: %s.\n", what);
+    exit(EXIT_FAILURE);
+}
+
+Roaring roaring_deserialize(const void *buffer, size_t size) {
+    const unsigned char *p = buffer, *end = p + size;
+    if(size < 8 || __roaring_get__(p, 4) != __ROARING_MAGIC) __roaring_corrupt__("bad header");
+
+    size_t chunks = (size_t)__roaring_get__(p + 4, 4);
+    p += 8;
+
+    Roaring r = roaring_create();
+    for(size_t i = 0; i < chunks; ++i) {
+        if((size_t)(end - p) < 8) __roaring_corrupt__("truncated input");
+        uint16_t key   = (uint16_t)__roaring_get__(p, 2);
+        uint32_t type  = (uint32_t)__roaring_get__(p + 2, 2);
+        size_t   count = (size_t)__roaring_get__(p + 4, 4);
+        p += 8;
+
+        if(i > 0 && key <= r.keys[i - 1]) __roaring_corrupt__("chunk keys out of order");
+        if(count == 0 || count > 65536) __roaring_corrupt__("bad container size");
+
+        RoaringContainer c = { type, 0, NULL };
+        if(type == __ROARING_ARRAY) {
+            if(count > __ROARING_ARRAY_MAX || (size_t)(end - p) < count * 2) __roaring_corrupt__("bad array container");
+            uint16_t *values = array_insert_n(uint16_t, array_create(uint16_t), 0, NULL, count);
+            for(size_t j = 0; j < count; ++j, p += 2) {
+                values[j] = (uint16_t)__roaring_get__(p, 2);
+                if(j > 0 && values[j] <= values[j - 1]) __roaring_corrupt__("array values out of order");
+            }
+            c.cardinality = (uint32_t)count;
+            c.data = values;
+        } else if(type == __ROARING_BITMAP) {
+            if((size_t)(end - p) < __ROARING_BITMAP_WORDS * 8) __roaring_corrupt__("bad bitmap container");
+            uint64_t *words = __roaring_bitmap_new__();
+            for(size_t j = 0; j < __ROARING_BITMAP_WORDS; ++j, p += 8) words[j] = __roaring_get__(p, 8);
+            c.cardinality = __roaring_popcount__(words);
+            c.data = words;
+            if(c.cardinality != count) __roaring_corrupt__("bitmap cardinality mismatch");
+        } else if(type == __ROARING_RUN) {
+            if((size_t)(end - p) < count * 4) __roaring_corrupt__("bad run container");
+            RoaringRun *runs = array_insert_n(RoaringRun, array_create(RoaringRun), 0, NULL, count);
+            uint32_t next = 0;
+            for(size_t j = 0; j < count; ++j, p += 4) {
+                runs[j].start  = (uint16_t)__roaring_get__(p, 2);
+                runs[j].length = (uint16_t)__roaring_get__(p + 2, 2);
+                if(runs[j].start < next || (uint32_t)runs[j].start + runs[j].length > 0xffff) __roaring_corrupt__("runs overlap");
+                next = (uint32_t)runs[j].start + runs[j].length + 2;
+                c.cardinality += (uint32_t)runs[j].length + 1;
+            }
+            c.data = runs;
+        } else {
+            __roaring_corrupt__("unknown container type");
+        }
+        __roaring_append__(&r, key, c);
+    }
+    return r;
+}
+
+#endif // COLLECTIONS_ROARING_IMPLEMENTATION
+#endif // COLLECTIONS_ROARING_H
@@ -0,0 +1,448 @@
+#ifndef COLLECTIONS_SCHEDULER_H
+#define COLLECTIONS_SCHEDULER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/**
+ * @brief Returns the number of worker threads of the shared scheduler.
+ *
+ * The scheduler is started on first use with one worker per online CPU.
+ * Every worker owns a Chase-Lev deque: it pushes and pops forked tasks at
+ * the bottom without locking, and idle workers steal from the top of a
+ * random victim's deque. Workers that find nothing to do go to sleep and
+ * are woken when new tasks appear.
+ *
+ * @return The number of workers (at least 1).
+ */
+size_t scheduler_workers(void);
+
+/**
+ * @brief Runs `a(a_arg)` and `b(b_arg)`, possibly in parallel, and returns when both are done.
+ *
+ * Inside a worker, `b` is pushed on the worker's deque and `a` runs right
+ * away; if nobody stole `b` in the meantime it runs next on the same thread,
+ * so an uncontended fork costs a push and a pop. While waiting for a stolen
+ * `b`, the worker runs other tasks. Called from any other thread, the pair is
+ * handed to the workers and the caller blocks until it completes. Tasks may
+ * fork further tasks.
+ *
+ * Example:
+ * ```c
+ * static void sum_half(void *arg) { Half *h = arg; h->sum = sum(h->data, h->n); }
+ * scheduler_join(sum_half, &lo, sum_half, &hi);
+ * ```
+ *
+ * @param a     First task.
+ * @param a_arg Argument of the first task.
+ * @param b     Second task, the one offered to other workers.
+ * @param b_arg Argument of the second task.
+ */
+void scheduler_join(void (*a)(void *), void *a_arg, void (*b)(void *), void *b_arg);
+
+/**
+ * @brief Calls `body(ctx, lo, hi)` on disjoint subranges covering `[begin, end)`, in parallel.
+ *
+ * Ranges are split lazily: a worker halves its range and offers one half to
+ * thieves only when its own deque is empty, and otherwise runs `grain`
+ * iterations at a time. Balanced loops therefore split about once per worker,
+ * while irregular ones keep splitting where the work is. A `grain` of 0
+ * picks one eighth of an even share per worker.
+ *
+ * Example:
+ * ```c
+ * static void scale(void *ctx, size_t lo, size_t hi) {
+ *     double *x = ctx;
+ *     for(size_t i = lo; i < hi; ++i) x[i] *= 2.0;
+ * }
+ * scheduler_parallel_for(0, n, 4096, scale, x);
+ * ```
+ *
+ * @param begin First index.
+ * @param end   One past the last index.
+ * @param grain Smallest subrange worth running on its own, or 0.
+ * @param body  Loop body; called concurrently from several threads.
+ * @param ctx   Opaque pointer passed to `body`.
+ */
+void scheduler_parallel_for(size_t begin, size_t end, size_t grain,
+                            void (*body)(void *ctx, size_t lo, size_t hi), void *ctx);
+
+
+#ifdef COLLECTIONS_SCHEDULER_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define __SCHEDULER_DEQUE_SIZE      1024
+#define __SCHEDULER_DEQUE_MASK      (__SCHEDULER_DEQUE_SIZE - 1)
+#define __SCHEDULER_SPIN_ROUNDS     64
+#define __SCHEDULER_RANGE_SPLITS    8
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define __scheduler_pause__()       __builtin_ia32_pause()
+#else
+#define __scheduler_pause__()       ((void)0)
+#endif
+
+/**
+ * @brief A forked task. Lives on the stack of the thread that forked it until joined.
+ */
+typedef struct SchedulerTask {
+    void                    (*fn)(void *arg);
+    void                    *arg;
+    _Atomic int             done;
+    bool                    external;   // submitted by a thread outside the pool
+    struct SchedulerTask    *next;      // link in the injection queue
+} SchedulerTask;
+
+/**
+ * @brief Chase-Lev work-stealing deque of fixed capacity.
+ *
+ * Follows the C11 formulation of Lê, Pop, Cohen and Zappa Nardelli. The owner
+ * pushes and pops at `bottom`; thieves take from `top`. When the deque is
+ * full, forks simply run inline.
+ */
+typedef struct {
+    _Atomic int64_t             top;
+    char                        pad0[64 - sizeof(int64_t)];
+    _Atomic int64_t             bottom;
+    char                        pad1[64 - sizeof(int64_t)];
+    _Atomic(SchedulerTask *)    tasks[__SCHEDULER_DEQUE_SIZE];
+} SchedulerDeque;
+
+typedef struct {
+    SchedulerDeque  deque;
+    uint64_t        rng;
+    size_t          index;
+} SchedulerWorker;
+
+typedef struct {
+    SchedulerWorker *workers;
+    size_t          count;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;       // idle workers wait here
+    pthread_cond_t  finished;   // threads outside the pool wait here for their task
+    _Atomic size_t  sleepers;
+    _Atomic size_t  injected;
+    SchedulerTask   *inject_head;
+    SchedulerTask   *inject_tail;
+} SchedulerPool;
+
+static SchedulerPool __scheduler_pool__ = {
+    .lock     = PTHREAD_MUTEX_INITIALIZER,
+    .wake     = PTHREAD_COND_INITIALIZER,
+    .finished = PTHREAD_COND_INITIALIZER,
+};
+static pthread_once_t                   __scheduler_once__ = PTHREAD_ONCE_INIT;
+static _Thread_local SchedulerWorker    *__scheduler_self__;
+
+// Marks a steal that lost a race: the victim may still hold work.
+#define __SCHEDULER_ABORT           ((SchedulerTask *)1)
+
+static bool __scheduler_push__(SchedulerDeque *d, SchedulerTask *task) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    if(b - t >= __SCHEDULER_DEQUE_SIZE) return false;
+    atomic_store_explicit(&d->tasks[b & __SCHEDULER_DEQUE_MASK], task, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+    return true;
+}
+
+static SchedulerTask *__scheduler_pop__(SchedulerDeque *d) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if(t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    SchedulerTask *task = atomic_load_explicit(&d->tasks[b & __SCHEDULER_DEQUE_MASK], memory_order_relaxed);
+    if(t == b) {
+        // Last task: race the thieves for it.
+        if(!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                    memory_order_seq_cst, memory_order_relaxed)) {
+            task = NULL;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static SchedulerTask *__scheduler_steal__(SchedulerDeque *d) {
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if(t >= b) return NULL;
+
+    SchedulerTask *task = atomic_load_explicit(&d->tasks[t & __SCHEDULER_DEQUE_MASK], memory_order_relaxed);
+    if(!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                memory_order_seq_cst, memory_order_relaxed)) {
+        return __SCHEDULER_ABORT;
+    }
+    return task;
+}
+
+static bool __scheduler_deque_empty__(SchedulerDeque *d) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    return b <= t;
+}
+
+static void __scheduler_run__(SchedulerTask *task) {
+    // The owner may return as soon as `done` is set, so read the flag first.
+    bool external = task->external;
+    task->fn(task->arg);
+    if(!external) {
+        atomic_store_explicit(&task->done, 1, memory_order_release);
+        return;
+    }
+
+    SchedulerPool *pool = &__scheduler_pool__;
+    pthread_mutex_lock(&pool->lock);
+    atomic_store_explicit(&task->done, 1, memory_order_release);
+    pthread_cond_broadcast(&pool->finished);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Wakes one sleeping worker after new work became visible.
+static void __scheduler_notify__(void) {
+    SchedulerPool *pool = &__scheduler_pool__;
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load_explicit(&pool->sleepers, memory_order_relaxed) == 0) return;
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Takes the oldest injected task. Called with the pool lock held.
+static SchedulerTask *__scheduler_take_injected__(SchedulerPool *pool) {
+    SchedulerTask *task = pool->inject_head;
+    if(!task) return NULL;
+    pool->inject_head = task->next;
+    if(!pool->inject_head) pool->inject_tail = NULL;
+    atomic_fetch_sub_explicit(&pool->injected, 1, memory_order_relaxed);
+    return task;
+}
+
+// Tries every other worker once, starting at a random victim.
+static SchedulerTask *__scheduler_steal_any__(SchedulerWorker *self) {
+    SchedulerPool *pool = &__scheduler_pool__;
+    for(;;) {
+        self->rng ^= self->rng << 13;
+        self->rng ^= self->rng >> 7;
+        self->rng ^= self->rng << 17;
+
+        bool contended = false;
+        size_t start = (size_t)(self->rng % pool->count);
+        for(size_t k = 0; k < pool->count; ++k) {
+            SchedulerWorker *victim = &pool->workers[(start + k) % pool->count];
+            if(victim == self) continue;
+            SchedulerTask *task = __scheduler_steal__(&victim->deque);
+            if(task == __SCHEDULER_ABORT) contended = true;
+            else if(task) return task;
+        }
+        if(!contended) return NULL;
+    }
+}
+
+static SchedulerTask *__scheduler_find__(SchedulerWorker *self) {
+    SchedulerPool *pool = &__scheduler_pool__;
+    SchedulerTask *task = __scheduler_pop__(&self->deque);
+    if(!task) task = __scheduler_steal_any__(self);
+    if(!task && atomic_load_explicit(&pool->injected, memory_order_relaxed) > 0) {
+        pthread_mutex_lock(&pool->lock);
+        task = __scheduler_take_injected__(pool);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return task;
+}
+
+static void *__scheduler_worker__(void *arg) {
+    SchedulerWorker *self = arg;
+    SchedulerPool *pool = &__scheduler_pool__;
+    __scheduler_self__ = self;
+
+    for(;;) {
+        SchedulerTask *task = NULL;
+        for(int round = 0; !task && round < __SCHEDULER_SPIN_ROUNDS; ++round) {
+            task = __scheduler_find__(self);
+            if(task) break;
+            if(round % 8 == 7) sched_yield();
+            else __scheduler_pause__();
+        }
+
+        if(!task) {
+            // Announce the sleep before the last look, so that a concurrent
+            // push either sees the sleeper or is seen by the look.
+            pthread_mutex_lock(&pool->lock);
+            atomic_fetch_add_explicit(&pool->sleepers, 1, memory_order_seq_cst);
+            while(!(task = __scheduler_take_injected__(pool)) && !(task = __scheduler_steal_any__(self))) {
+                pthread_cond_wait(&pool->wake, &pool->lock);
+            }
+            atomic_fetch_sub_explicit(&pool->sleepers, 1, memory_order_relaxed);
+            pthread_mutex_unlock(&pool->lock);
+        }
+
+        __scheduler_run__(task);
+    }
+    return NULL;
+}
+
+static void __scheduler_start__(void) {
+    SchedulerPool *pool = &__scheduler_pool__;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t count = cpus > 1 ? (size_t)cpus : 1;
+
+    pool->workers = calloc(count, sizeof(SchedulerWorker));
+    if(!pool->workers) {
+        fprintf(stderr, "scheduler_join failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < count; ++i) {
+        pool->workers[i].index = i;
+        pool->workers[i].rng   = 0x9E3779B97F4A7C15ull * (i + 1);
+    }
+
+    // Workers may steal from any slot as soon as they start, so publish the
+    // count first. Slots whose thread could not be created stay empty.
+    pool->count = count;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for(size_t i = 0; i < count; ++i) {
+        pthread_t thread;
+        if(pthread_create(&thread, &attr, __scheduler_worker__, &pool->workers[i]) != 0 && i == 0) {
+            fprintf(stderr, "scheduler_join failed: cannot create worker thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    pthread_attr_destroy(&attr);
+}
+
+// Runs `fn(arg)` on a worker and blocks the calling (non-worker) thread until it returns.
+static void __scheduler_external__(void (*fn)(void *), void *arg) {
+    SchedulerPool *pool = &__scheduler_pool__;
+    SchedulerTask task = { .fn = fn, .arg = arg, .external = true, .next = NULL };
+    atomic_init(&task.done, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    if(pool->inject_tail) pool->inject_tail->next = &task;
+    else pool->inject_head = &task;
+    pool->inject_tail = &task;
+    atomic_fetch_add_explicit(&pool->injected, 1, memory_order_relaxed);
+    pthread_cond_signal(&pool->wake);
+
+    while(!atomic_load_explicit(&task.done, memory_order_acquire)) pthread_cond_wait(&pool->finished, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+size_t scheduler_workers(void) {
+    pthread_once(&__scheduler_once__, __scheduler_start__);
+    return __scheduler_pool__.count;
+}
+
+/**
+ * @brief Arguments of a join submitted from outside the pool.
+ */
+typedef struct {
+    void    (*a)(void *);
+    void    *a_arg;
+    void    (*b)(void *);
+    void    *b_arg;
+} SchedulerPair;
+
+static void __scheduler_pair__(void *arg) {
+    SchedulerPair *pair = arg;
+    scheduler_join(pair->a, pair->a_arg, pair->b, pair->b_arg);
+}
+
+void scheduler_join(void (*a)(void *), void *a_arg, void (*b)(void *), void *b_arg) {
+    SchedulerWorker *self = __scheduler_self__;
+    if(!self) {
+        if(scheduler_workers() < 2) {
+            a(a_arg);
+            b(b_arg);
+            return;
+        }
+        SchedulerPair pair = { a, a_arg, b, b_arg };
+        __scheduler_external__(__scheduler_pair__, &pair);
+        return;
+    }
+
+    SchedulerTask task = { .fn = b, .arg = b_arg, .external = false, .next = NULL };
+    atomic_init(&task.done, 0);
+    if(!__scheduler_push__(&self->deque, &task)) {
+        a(a_arg);
+        b(b_arg);
+        return;
+    }
+    __scheduler_notify__();
+
+    a(a_arg);
+
+    // Everything `a` forked has been joined, so `task` is either still at the
+    // bottom of the deque or was stolen.
+    if(__scheduler_pop__(&self->deque) == &task) {
+        b(b_arg);
+        return;
+    }
+    while(!atomic_load_explicit(&task.done, memory_order_acquire)) {
+        SchedulerTask *other = __scheduler_steal_any__(self);
+        if(other) __scheduler_run__(other);
+        else sched_yield();
+    }
+}
+
+/**
+ * @brief A subrange of a `scheduler_parallel_for` loop.
+ */
+typedef struct {
+    void    (*body)(void *ctx, size_t lo, size_t hi);
+    void    *ctx;
+    size_t  lo;
+    size_t  hi;
+    size_t  grain;
+} SchedulerRange;
+
+static void __scheduler_range__(void *arg) {
+    SchedulerRange *r = arg;
+    SchedulerWorker *self = __scheduler_self__;
+    size_t lo = r->lo;
+
+    while(r->hi - lo > r->grain) {
+        if(self && __scheduler_deque_empty__(&self->deque)) {
+            // Nothing left for thieves: offer them half of what remains.
+            size_t mid = lo + (r->hi - lo) / 2;
+            SchedulerRange left  = { r->body, r->ctx, lo, mid, r->grain };
+            SchedulerRange right = { r->body, r->ctx, mid, r->hi, r->grain };
+            scheduler_join(__scheduler_range__, &left, __scheduler_range__, &right);
+            return;
+        }
+        r->body(r->ctx, lo, lo + r->grain);
+        lo += r->grain;
+    }
+    if(lo < r->hi) r->body(r->ctx, lo, r->hi);
+}
+
+void scheduler_parallel_for(size_t begin, size_t end, size_t grain,
+                            void (*body)(void *ctx, size_t lo, size_t hi), void *ctx) {
+    if(begin >= end) return;
+
+    size_t workers = scheduler_workers();
+    if(grain == 0) grain = (end - begin) / (__SCHEDULER_RANGE_SPLITS * workers);
+    if(grain == 0) grain = 1;
+
+    SchedulerRange range = { body, ctx, begin, end, grain };
+    if(end - begin <= grain || (workers < 2 && !__scheduler_self__)) body(ctx, begin, end);
+    else if(__scheduler_self__) __scheduler_range__(&range);
+    else __scheduler_external__(__scheduler_range__, &range);
+}
+
+#endif // COLLECTIONS_SCHEDULER_IMPLEMENTATION
+#endif // COLLECTIONS_SCHEDULER_H
@@ -0,0 +1,159 @@
+#ifndef COLLECTIONS_SLOTMAP_H
+#define COLLECTIONS_SLOTMAP_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/**
+ * @brief A handle value that never refers to a live element.
+ */
+#define SLOTMAP_NULL ((uint64_t)0)
+
+/**
+ * @brief One entry of the sparse index of a slot map.
+ *
+ * While the slot is live, `index` is the position of its element in the dense
+ * array; while it is free, `index` is the next free slot (`UINT32_MAX` ends the
+ * list). `generation` is bumped every time the slot is freed.
+ */
+typedef struct {
+    uint32_t    index;
+    uint32_t    generation;
+} SlotMapSlot;
+
+/**
+ * @brief Generates a typed generational slot map.
+ *
+ * Elements live contiguously in an `Array(T)` so they can be iterated like
+ * any array; removal moves the last element into the hole. Callers refer to
+ * elements through 64-bit handles made of a slot number (low 32 bits) and the
+ * slot's generation (high 32 bits). A slot's generation changes when its
+ * element is removed, so a stale handle is detected instead of aliasing a
+ * newer element. Handles are never `SLOTMAP_NULL`.
+ *
+ * The macro declares the type `name` and a set of `static inline` functions:
+ *
+ * - `name`: `{ Array(T) data; Array(uint32_t) owner; Array(SlotMapSlot) slots;
+ *   uint32_t free; }`. `data[i]` is the `i`-th element and `owner[i]` its slot.
+ * - `name name_create(void)` / `void name_destroy(name *m)`.
+ * - `size_t name_length(name *m)`.
+ * - `uint64_t name_insert(name *m, T value)` — O(1) amortized.
+ * - `T *name_get(name *m, uint64_t handle)` — NULL for stale handles. The
+ *   pointer is invalidated by the next insert or remove.
+ * - `bool name_contains(name *m, uint64_t handle)`.
+ * - `bool name_remove(name *m, uint64_t handle)` — O(1), false if stale.
+ * - `uint64_t name_handle_at(name *m, size_t i)` — handle of `data[i]`.
+ *
+ * The array.h implementation must be compiled into the program.
+ *
+ * Example:
+ * ```c
+ * typedef struct { float x, y; } Body;
+ * SLOTMAP_DEFINE(bodies, Body)
+ *
+ * bodies world = bodies_create();
+ * uint64_t h = bodies_insert(&world, (Body){ 0, 0 });
+ * for (size_t i = 0; i < bodies_length(&world); ++i) world.data[i].y -= 9.8f;
+ * bodies_remove(&world, h);
+ * assert(bodies_get(&world, h) == NULL);
+ * bodies_destroy(&world);
+ * ```
+ *
+ * @param name Prefix of the generated type and functions.
+ * @param T    The element type.
+ */
+#define SLOTMAP_DEFINE(name, T)                                                             \
+typedef struct {                                                                            \
+    T               *data;                                                                  \
+    uint32_t        *owner;                                                                 \
+    SlotMapSlot     *slots;                                                                 \
+    uint32_t        free;                                                                   \
+} name;                                                                                     \
+                                                                                            \
+static inline name name##_create(void) {                                                    \
+    name m = { array_create(T), array_create(uint32_t), array_create(SlotMapSlot), 0 };     \
+    m.free = UINT32_MAX;                                                                    \
+    return m;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline void name##_destroy(name *m) {                                                \
+    array_destroy(m->data);                                                                 \
+    array_destroy(m->owner);                                                                \
+    array_destroy(m->slots);                                                                \
+}                                                                                           \
+                                                                                            \
+static inline size_t name##_length(name *m) {                                               \
+    return array_length(m->data);                                                           \
+}                                                                                           \
+                                                                                            \
+static inline SlotMapSlot *__##name##_slot__(name *m, uint64_t handle) {                    \
+    uint32_t slot = (uint32_t)handle;                                                       \
+    if(slot >= array_length(m->slots)) return NULL;                                         \
+    SlotMapSlot *s = &m->slots[slot];                                                       \
+    if(s->generation != (uint32_t)(handle >> 32)) return NULL;                              \
+    if(s->index >= array_length(m->owner) || m->owner[s->index] != slot) return NULL;       \
+    return s;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline uint64_t name##_insert(name *m, T value) {                                    \
+    uint32_t slot = m->free;                                                                \
+    if(slot == UINT32_MAX) {                                                                \
+        slot = (uint32_t)array_length(m->slots);                                            \
+        if(slot == UINT32_MAX) {                                                            \
+            fprintf(stderr, #name "_insert failed: slot map is full.\n");                   \
+            exit(EXIT_FAILURE);                                                             \
+        }                                                                                   \
+        m->slots = array_append(SlotMapSlot, m->slots);                                     \
+        m->slots[slot].generation = 1;                                                      \
+    } else {                                                                                \
+        m->free = m->slots[slot].index;                                                     \
+    }                                                                                       \
+                                                                                            \
+    size_t idx = array_length(m->data);                                                     \
+    m->data = array_append(T, m->data);                                                     \
+    m->data[idx] = value;                                                                   \
+    m->owner = array_append(uint32_t, m->owner);                                            \
+    m->owner[idx] = slot;                                                                   \
+    m->slots[slot].index = (uint32_t)idx;                                                   \
+    return (uint64_t)m->slots[slot].generation << 32 | slot;                                \
+}                                                                                           \
+                                                                                            \
+static inline T *name##_get(name *m, uint64_t handle) {                                     \
+    SlotMapSlot *s = __##name##_slot__(m, handle);                                          \
+    return s ? &m->data[s->index] : NULL;                                                   \
+}                                                                                           \
+                                                                                            \
+static inline bool name##_contains(name *m, uint64_t handle) {                              \
+    return __##name##_slot__(m, handle) != NULL;                                            \
+}                                                                                           \
+                                                                                            \
+static inline bool name##_remove(name *m, uint64_t handle) {                                \
+    SlotMapSlot *s = __##name##_slot__(m, handle);                                          \
+    if(!s) return false;                                                                    \
+                                                                                            \
+    uint32_t idx  = s->index;                                                               \
+    uint32_t last = (uint32_t)array_length(m->data) - 1;                                    \
+    m->data[idx]  = m->data[last];                                                          \
+    m->owner[idx] = m->owner[last];                                                         \
+    m->slots[m->owner[idx]].index = idx;                                                    \
+    array_truncate(m->data, last);                                                          \
+    array_truncate(m->owner, last);                                                         \
+                                                                                            \
+    s->generation = s->generation + 1 ? s->generation + 1 : 1;                              \
+    s->index = m->free;                                                                     \
+    m->free = (uint32_t)handle;                                                             \
+    return true;                                                                            \
+}                                                                                           \
+                                                                                            \
+static inline uint64_t name##_handle_at(name *m, size_t i) {                                \
+    uint32_t slot = m->owner[i];                                                            \
+    return (uint64_t)m->slots[slot].generation << 32 | slot;                                \
+}
+
+
+#endif // COLLECTIONS_SLOTMAP_H
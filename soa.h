@@ -0,0 +1,148 @@
+#ifndef COLLECTIONS_SOA_H
+#define COLLECTIONS_SOA_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "array.h"
+
+/**
+ * @brief Generates a structure-of-arrays container.
+ *
+ * `FIELDS` is an X-macro listing the columns as `X(type, name)` entries. The
+ * macro declares a row type `name_row` with those fields, and a container
+ * `name` holding one array.h `Array(type)` per field plus the shared row
+ * count `length`. A loop reading one column only touches that column's
+ * cache lines, and each column can be passed as is to array.h algorithms
+ * (`array_sum`, `array_find`, `array_sort`, ...) or to a vectorized kernel.
+ * Columns must not be resized individually.
+ *
+ * Generated `static inline` functions:
+ *
+ * - `name name_create(void)` / `void name_destroy(name *s)`.
+ * - `size_t name_length(name *s)` / `void name_clear(name *s)`.
+ * - `void name_push(name *s, name_row row)` / `name_row name_pop(name *s)`.
+ * - `name_row name_at(name *s, size_t i)`.
+ * - `void name_set(name *s, size_t i, name_row row)`.
+ * - `void name_from_aos(name *s, const name_row *rows, size_t n)` — appends
+ *   `n` rows, growing every column once.
+ * - `void name_to_aos(name *s, name_row *out)` — writes all rows to `out`.
+ *
+ * The array.h implementation must be compiled into the program.
+ *
+ * Example:
+ * ```c
+ * #define TRADE_FIELDS(X) \
+ *     X(uint64_t, time)   \
+ *     X(double,   price)  \
+ *     X(uint32_t, volume)
+ * SOA_DEFINE(trades, TRADE_FIELDS)
+ *
+ * trades t = trades_create();
+ * trades_push(&t, (trades_row){ .time = 1, .price = 9.5, .volume = 100 });
+ * double total = array_sum(double, t.price);
+ * trades_destroy(&t);
+ * ```
+ *
+ * @param name   Prefix of the generated types and functions.
+ * @param FIELDS X-macro taking one argument `X` and expanding to `X(type, field)` entries.
+ */
+#define SOA_DEFINE(name, FIELDS)                                                            \
+typedef struct {                                                                            \
+    FIELDS(__SOA_ROW_FIELD__)                                                               \
+} name##_row;                                                                               \
+                                                                                            \
+typedef struct {                                                                            \
+    size_t  length;                                                                         \
+    FIELDS(__SOA_COLUMN_FIELD__)                                                            \
+} name;                                                                                     \
+                                                                                            \
+static inline name name##_create(void) {                                                    \
+    name soa;                                                                               \
+    name *s = &soa;                                                                         \
+    s->length = 0;                                                                          \
+    FIELDS(__SOA_CREATE__)                                                                  \
+    return soa;                                                                             \
+}                                                                                           \
+                                                                                            \
+static inline void name##_destroy(name *s) {                                                \
+    FIELDS(__SOA_DESTROY__)                                                                 \
+    s->length = 0;                                                                          \
+}                                                                                           \
+                                                                                            \
+static inline size_t name##_length(name *s) {                                               \
+    return s->length;                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline void name##_clear(name *s) {                                                  \
+    FIELDS(__SOA_CLEAR__)                                                                   \
+    s->length = 0;                                                                          \
+}                                                                                           \
+                                                                                            \
+static inline void name##_push(name *s, name##_row row) {                                   \
+    size_t i = s->length;                                                                   \
+    FIELDS(__SOA_PUSH__)                                                                    \
+    s->length = i + 1;                                                                      \
+}                                                                                           \
+                                                                                            \
+static inline name##_row name##_pop(name *s) {                                              \
+    if(s->length == 0) {                                                                    \
+        fprintf(stderr, #name "_pop failed: container is empty.\n");                        \
+        exit(EXIT_FAILURE);                                                                 \
+    }                                                                                       \
+    name##_row row;                                                                         \
+    size_t i = --s->length;                                                                 \
+    FIELDS(__SOA_GET__)                                                                     \
+    FIELDS(__SOA_TRUNCATE__)                                                                \
+    return row;                                                                             \
+}                                                                                           \
+                                                                                            \
+static inline name##_row name##_at(name *s, size_t i) {                                     \
+    if(i >= s->length) {                                                                    \
+        fprintf(stderr, #name "_at failed: index out of range.\n");                         \
+        exit(EXIT_FAILURE);                                                                 \
+    }                                                                                       \
+    name##_row row;                                                                         \
+    FIELDS(__SOA_GET__)                                                                     \
+    return row;                                                                             \
+}                                                                                           \
+                                                                                            \
+static inline void name##_set(name *s, size_t i, name##_row row) {                          \
+    if(i >= s->length) {                                                                    \
+        fprintf(stderr, #name "_set failed: index out of range.\n");                        \
+        exit(EXIT_FAILURE);                                                                 \
+    }                                                                                       \
+    FIELDS(__SOA_SET__)                                                                     \
+}                                                                                           \
+                                                                                            \
+static inline void name##_from_aos(name *s, const name##_row *rows, size_t n) {             \
+    size_t i = s->length;                                                                   \
+    FIELDS(__SOA_SCATTER__)                                                                 \
+    s->length = i + n;                                                                      \
+}                                                                                           \
+                                                                                            \
+static inline void name##_to_aos(name *s, name##_row *out) {                                \
+    size_t n = s->length;                                                                   \
+    FIELDS(__SOA_GATHER__)                                                                  \
+}
+
+// Per-field expansions used by SOA_DEFINE. They refer to the locals `s`,
+// `row`, `rows`, `out`, `i` and `n` of the generated functions.
+#define __SOA_ROW_FIELD__(T, f)     T f;
+#define __SOA_COLUMN_FIELD__(T, f)  T *f;
+#define __SOA_CREATE__(T, f)        s->f = array_create(T);
+#define __SOA_DESTROY__(T, f)       array_destroy(s->f);
+#define __SOA_CLEAR__(T, f)         array_clear(s->f);
+#define __SOA_PUSH__(T, f)          s->f = array_append(T, s->f); s->f[i] = row.f;
+#define __SOA_GET__(T, f)           row.f = s->f[i];
+#define __SOA_SET__(T, f)           s->f[i] = row.f;
+#define __SOA_TRUNCATE__(T, f)      array_truncate(s->f, i);
+#define __SOA_SCATTER__(T, f)                                                               \
+    s->f = array_insert_n(T, s->f, i, NULL, n);                                             \
+    for(size_t k = 0; k < n; ++k) s->f[i + k] = rows[k].f;
+#define __SOA_GATHER__(T, f)                                                                \
+    for(size_t k = 0; k < n; ++k) out[k].f = s->f[k];
+
+
+#endif // COLLECTIONS_SOA_H
@@ -0,0 +1,495 @@
+#ifndef COLLECTIONS_SORTED_H
+#define COLLECTIONS_SORTED_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/**
+ * @brief Appends the intersection of two sorted `uint32_t` arrays to `out`.
+ *
+ * Both inputs must be strictly increasing, as posting lists are. Lists of
+ * similar length are intersected eight against eight elements at a time with
+ * AVX2 when the CPU has it, and with a branch-free merge otherwise. When one
+ * list is more than 32 times longer than the other, each element of the short
+ * list gallops (1, 2, 4, ... steps, then a binary search) through the long one
+ * instead, so the cost follows the short list.
+ *
+ * `out` is reserved once for the largest possible result and then filled in
+ * place, so nothing is reallocated while the result is produced. Reusing one
+ * output array across queries avoids allocating at all.
+ *
+ * Example:
+ * ```c
+ * uint32_t *hits = sorted_intersect(array_create(uint32_t), docs_cat, docs_dog);
+ * ```
+ *
+ * @param out Array receiving the result after its current elements; must not alias `a` or `b`.
+ * @param a   Strictly increasing array.
+ * @param b   Strictly increasing array.
+ * @return The output array, possibly moved.
+ */
+uint32_t *sorted_intersect(uint32_t *out, const uint32_t *a, const uint32_t *b);
+
+/**
+ * @brief Appends the union of two sorted `uint32_t` arrays to `out`, without duplicates.
+ *
+ * With AVX2, blocks of eight are merged with a bitonic merging network and
+ * duplicates are dropped by comparing each lane with its predecessor. Skewed
+ * inputs copy the runs of the long list between elements of the short one
+ * with `memcpy`, galloping to find where each run ends.
+ *
+ * Example:
+ * ```c
+ * uint32_t *any = sorted_union(array_create(uint32_t), docs_cat, docs_dog);
+ * ```
+ *
+ * @param out Array receiving the result after its current elements; must not alias `a` or `b`.
+ * @param a   Strictly increasing array.
+ * @param b   Strictly increasing array.
+ * @return The output array, possibly moved.
+ */
+uint32_t *sorted_union(uint32_t *out, const uint32_t *a, const uint32_t *b);
+
+/**
+ * @brief Appends the k-way merge of `k` sorted `uint32_t` arrays to `out`.
+ *
+ * Uses a loser tree: every element costs one path of log2(k) comparisons
+ * from its leaf to the root, each against a single stored loser. Duplicates,
+ * within or across lists, are kept.
+ *
+ * Example:
+ * ```c
+ * uint32_t *lists[] = { docs_cat, docs_dog, docs_cow };
+ * uint32_t *all = sorted_merge(array_create(uint32_t), lists, 3);
+ * ```
+ *
+ * @param out   Array receiving the result after its current elements.
+ * @param lists `k` non-decreasing arrays.
+ * @param k     Number of arrays.
+ * @return The output array, possibly moved.
+ */
+uint32_t *sorted_merge(uint32_t *out, uint32_t *const *lists, size_t k);
+
+/**
+ * @brief Appends the union of `k` sorted `uint32_t` arrays to `out`, without duplicates.
+ *
+ * The same loser-tree merge as `sorted_merge`, dropping repeated values.
+ *
+ * @param out   Array receiving the result after its current elements.
+ * @param lists `k` non-decreasing arrays.
+ * @param k     Number of arrays.
+ * @return The output array, possibly moved.
+ */
+uint32_t *sorted_merge_unique(uint32_t *out, uint32_t *const *lists, size_t k);
+
+
+#ifdef COLLECTIONS_SORTED_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define __SORTED_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define __SORTED_SIMD_X86 0
+#endif
+
+#define __SORTED_GALLOP_RATIO   32
+#define __SORTED_SLACK          8           // SIMD stores may write this far past the result
+#define __SORTED_DONE           UINT64_MAX  // loser-tree key of an exhausted list
+
+/**
+ * @brief Returns the first index in `values[lo, n)` whose value is at least
+ * `target`, probing 1, 2, 4, ... positions ahead before a binary search.
+ */
+static size_t __sorted_gallop__(const uint32_t *values, size_t lo, size_t n, uint32_t target) {
+    size_t step = 1, hi = lo;
+    while(hi < n && values[hi] < target) {
+        lo = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    if(hi > n) hi = n;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(values[mid] < target) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static size_t __sorted_intersect_scalar__(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out) {
+    size_t i = 0, j = 0, n = 0;
+    while(i < na && j < nb) {
+        uint32_t x = a[i], y = b[j];
+        out[n] = x;
+        n += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    return n;
+}
+
+// `a` is the short list.
+static size_t __sorted_intersect_gallop__(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out) {
+    size_t j = 0, n = 0;
+    for(size_t i = 0; i < na && j < nb; ++i) {
+        j = __sorted_gallop__(b, j, nb, a[i]);
+        if(j < nb && b[j] == a[i]) out[n++] = a[i];
+    }
+    return n;
+}
+
+// Appends to out[0, n) and returns the new count; a value equal to the last
+// one written is dropped, so the output is duplicate-free even across calls.
+static size_t __sorted_union_scalar__(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out, size_t n) {
+    size_t i = 0, j = 0;
+    while(i < na && j < nb) {
+        uint32_t x = a[i], y = b[j], v = x < y ? x : y;
+        out[n] = v;
+        n += n == 0 || out[n - 1] != v;
+        i += x <= y;
+        j += y <= x;
+    }
+    for(; i < na; ++i) {
+        out[n] = a[i];
+        n += n == 0 || out[n - 1] != a[i];
+    }
+    for(; j < nb; ++j) {
+        out[n] = b[j];
+        n += n == 0 || out[n - 1] != b[j];
+    }
+    return n;
+}
+
+// Two-way merge keeping duplicates.
+static size_t __sorted_merge2__(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out) {
+    size_t i = 0, j = 0, n = 0;
+    while(i < na && j < nb) {
+        uint32_t x = a[i], y = b[j];
+        bool take = x <= y;
+        out[n++] = take ? x : y;
+        i += take;
+        j += !take;
+    }
+    memcpy(out + n, a + i, (na - i) * sizeof(uint32_t));
+    n += na - i;
+    memcpy(out + n, b + j, (nb - j) * sizeof(uint32_t));
+    return n + nb - j;
+}
+
+// `a` is the short list: copies the run of `b` below each of its elements in one go.
+static size_t __sorted_union_gallop__(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out) {
+    size_t j = 0, n = 0;
+    for(size_t i = 0; i <= na; ++i) {
+        size_t k = i < na ? __sorted_gallop__(b, j, nb, a[i]) : nb;
+        // Only the head of a run can repeat the previous element of `a`.
+        if(j < k && n > 0 && out[n - 1] == b[j]) ++j;
+        memcpy(out + n, b + j, (k - j) * sizeof(uint32_t));
+        n += k - j;
+        j = k;
+        if(i < na) out[n++] = a[i];
+    }
+    return n;
+}
+
+#if __SORTED_SIMD_X86
+
+// For each 8-bit lane mask, the indices of the set lanes packed four bits
+// apiece from the low end: the permutation that packs the selected lanes.
+static const uint32_t __sorted_compact_table__[256] = {
+    0x00000000, 0x00000000, 0x00000001, 0x00000010, 0x00000002, 0x00000020, 0x00000021, 0x00000210,
+    0x00000003, 0x00000030, 0x00000031, 0x00000310, 0x00000032, 0x00000320, 0x00000321, 0x00003210,
+    0x00000004, 0x00000040, 0x00000041, 0x00000410, 0x00000042, 0x00000420, 0x00000421, 0x00004210,
+    0x00000043, 0x00000430, 0x00000431, 0x00004310, 0x00000432, 0x00004320, 0x00004321, 0x00043210,
+    0x00000005, 0x00000050, 0x00000051, 0x00000510, 0x00000052, 0x00000520, 0x00000521, 0x00005210,
+    0x00000053, 0x00000530, 0x00000531, 0x00005310, 0x00000532, 0x00005320, 0x00005321, 0x00053210,
+    0x00000054, 0x00000540, 0x00000541, 0x00005410, 0x00000542, 0x00005420, 0x00005421, 0x00054210,
+    0x00000543, 0x00005430, 0x00005431, 0x00054310, 0x00005432, 0x00054320, 0x00054321, 0x00543210,
+    0x00000006, 0x00000060, 0x00000061, 0x00000610, 0x00000062, 0x00000620, 0x00000621, 0x00006210,
+    0x00000063, 0x00000630, 0x00000631, 0x00006310, 0x00000632, 0x00006320, 0x00006321, 0x00063210,
+    0x00000064, 0x00000640, 0x00000641, 0x00006410, 0x00000642, 0x00006420, 0x00006421, 0x00064210,
+    0x00000643, 0x00006430, 0x00006431, 0x00064310, 0x00006432, 0x00064320, 0x00064321, 0x00643210,
+    0x00000065, 0x00000650, 0x00000651, 0x00006510, 0x00000652, 0x00006520, 0x00006521, 0x00065210,
+    0x00000653, 0x00006530, 0x00006531, 0x00065310, 0x00006532, 0x00065320, 0x00065321, 0x00653210,
+    0x00000654, 0x00006540, 0x00006541, 0x00065410, 0x00006542, 0x00065420, 0x00065421, 0x00654210,
+    0x00006543, 0x00065430, 0x00065431, 0x00654310, 0x00065432, 0x00654320, 0x00654321, 0x06543210,
+    0x00000007, 0x00000070, 0x00000071, 0x00000710, 0x00000072, 0x00000720, 0x00000721, 0x00007210,
+    0x00000073, 0x00000730, 0x00000731, 0x00007310, 0x00000732, 0x00007320, 0x00007321, 0x00073210,
+    0x00000074, 0x00000740, 0x00000741, 0x00007410, 0x00000742, 0x00007420, 0x00007421, 0x00074210,
+    0x00000743, 0x00007430, 0x00007431, 0x00074310, 0x00007432, 0x00074320, 0x00074321, 0x00743210,
+    0x00000075, 0x00000750, 0x00000751, 0x00007510, 0x00000752, 0x00007520, 0x00007521, 0x00075210,
+    0x00000753, 0x00007530, 0x00007531, 0x00075310, 0x00007532, 0x00075320, 0x00075321, 0x00753210,
+    0x00000754, 0x00007540, 0x00007541, 0x00075410, 0x00007542, 0x00075420, 0x00075421, 0x00754210,
+    0x00007543, 0x00075430, 0x00075431, 0x00754310, 0x00075432, 0x00754320, 0x00754321, 0x07543210,
+    0x00000076, 0x00000760, 0x00000761, 0x00007610, 0x00000762, 0x00007620, 0x00007621, 0x00076210,
+    0x00000763, 0x00007630, 0x00007631, 0x00076310, 0x00007632, 0x00076320, 0x00076321, 0x00763210,
+    0x00000764, 0x00007640, 0x00007641, 0x00076410, 0x00007642, 0x00076420, 0x00076421, 0x00764210,
+    0x00007643, 0x00076430, 0x00076431, 0x00764310, 0x00076432, 0x00764320, 0x00764321, 0x07643210,
+    0x00000765, 0x00007650, 0x00007651, 0x00076510, 0x00007652, 0x00076520, 0x00076521, 0x00765210,
+    0x00007653, 0x00076530, 0x00076531, 0x00765310, 0x00076532, 0x00765320, 0x00765321, 0x07653210,
+    0x00007654, 0x00076540, 0x00076541, 0x00765410, 0x00076542, 0x00765420, 0x00765421, 0x07654210,
+    0x00076543, 0x00765430, 0x00765431, 0x07654310, 0x00765432, 0x07654320, 0x07654321, 0x76543210,
+};
+
+// Stores the lanes of `v` selected by `mask` contiguously at `out`; writes
+// all eight lanes.
+__attribute__((target("avx2,popcnt")))
+static inline size_t __sorted_compact_avx2__(__m256i v, unsigned mask, uint32_t *out) {
+    __m256i packed  = _mm256_set1_epi32((int)__sorted_compact_table__[mask]);
+    __m256i shifts  = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+    __m256i indices = _mm256_and_si256(_mm256_srlv_epi32(packed, shifts), _mm256_set1_epi32(15));
+    _mm256_storeu_si256((__m256i *)out, _mm256_permutevar8x32_epi32(v, indices));
+    return (size_t)__builtin_popcount(mask);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t __sorted_intersect_avx2__(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out) {
+    size_t i = 0, j = 0, n = 0;
+    __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    while(i + 8 <= na && j + 8 <= nb) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+
+        // Compare every element of `va` with every element of `vb` by
+        // rotating `vb` through all eight lanes.
+        __m256i eq = _mm256_cmpeq_epi32(va, vb);
+        for(int r = 1; r < 8; ++r) {
+            vb = _mm256_permutevar8x32_epi32(vb, rotate);
+            eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, vb));
+        }
+        n += __sorted_compact_avx2__(va, (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(eq)), out + n);
+
+        // Retire the block(s) whose largest element is the smaller one: none
+        // of their elements can match anything further on.
+        uint32_t amax = a[i + 7], bmax = b[j + 7];
+        i += amax <= bmax ? 8 : 0;
+        j += bmax <= amax ? 8 : 0;
+    }
+    return n + __sorted_intersect_scalar__(a + i, na - i, b + j, nb - j, out + n);
+}
+
+// Sorts a bitonic sequence of eight lanes.
+__attribute__((target("avx2")))
+static inline __m256i __sorted_bitonic8_avx2__(__m256i v) {
+    __m256i t = _mm256_permute2x128_si256(v, v, 0x01);
+    v = _mm256_blend_epi32(_mm256_min_epu32(v, t), _mm256_max_epu32(v, t), 0xF0);
+    t = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    v = _mm256_blend_epi32(_mm256_min_epu32(v, t), _mm256_max_epu32(v, t), 0xCC);
+    t = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+    v = _mm256_blend_epi32(_mm256_min_epu32(v, t), _mm256_max_epu32(v, t), 0xAA);
+    return v;
+}
+
+// Merges two sorted vectors: `lo` receives the eight smallest lanes and `hi`
+// the eight largest, both sorted.
+__attribute__((target("avx2")))
+static inline void __sorted_merge8_avx2__(__m256i a, __m256i b, __m256i *lo, __m256i *hi) {
+    b   = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    *lo = __sorted_bitonic8_avx2__(_mm256_min_epu32(a, b));
+    *hi = __sorted_bitonic8_avx2__(_mm256_max_epu32(a, b));
+}
+
+// Stores the lanes of sorted `v` that differ from their predecessor; `last`
+// holds the previous value written in every lane and is updated.
+__attribute__((target("avx2,popcnt")))
+static inline size_t __sorted_emit_unique_avx2__(__m256i v, __m256i *last, uint32_t *out) {
+    __m256i prev = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+    prev = _mm256_blend_epi32(prev, *last, 0x01);
+    unsigned dup = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, prev)));
+    *last = _mm256_permutevar8x32_epi32(v, _mm256_set1_epi32(7));
+    return __sorted_compact_avx2__(v, ~dup & 0xFF, out);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t __sorted_union_avx2__(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out) {
+    uint32_t first = a[0] < b[0] ? a[0] : b[0];
+    __m256i last   = _mm256_set1_epi32((int)(first - 1));
+    __m256i lo, hi;
+    size_t i = 8, j = 8, n = 0;
+
+    __sorted_merge8_avx2__(_mm256_loadu_si256((const __m256i *)a), _mm256_loadu_si256((const __m256i *)b), &lo, &hi);
+    n += __sorted_emit_unique_avx2__(lo, &last, out + n);
+
+    // `hi` carries the eight largest values seen so far. Loading next from the
+    // list with the smaller head keeps every emitted `lo` below what remains.
+    while(i + 8 <= na && j + 8 <= nb) {
+        __m256i next;
+        if(a[i] <= b[j]) {
+            next = _mm256_loadu_si256((const __m256i *)(a + i));
+            i += 8;
+        } else {
+            next = _mm256_loadu_si256((const __m256i *)(b + j));
+            j += 8;
+        }
+        __sorted_merge8_avx2__(next, hi, &lo, &hi);
+        n += __sorted_emit_unique_avx2__(lo, &last, out + n);
+    }
+
+    // Finish with the carried values, the short remainder and the long one.
+    uint32_t carry[8], rest[16];
+    _mm256_storeu_si256((__m256i *)carry, hi);
+    const uint32_t *sa = a + i, *sb = b + j;
+    size_t ra = na - i, rb = nb - j;
+    if(ra > rb) {
+        const uint32_t *t = sa; sa = sb; sb = t;
+        size_t tn = ra; ra = rb; rb = tn;
+    }
+    size_t m = __sorted_union_scalar__(carry, 8, sa, ra, rest, 0);
+    return __sorted_union_scalar__(rest, m, sb, rb, out, n);
+}
+
+static inline bool __sorted_has_avx2__(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+#define __sorted_has_avx2__()                               false
+#define __sorted_intersect_avx2__(a, na, b, nb, out)        __sorted_intersect_scalar__(a, na, b, nb, out)
+#define __sorted_union_avx2__(a, na, b, nb, out)            __sorted_union_scalar__(a, na, b, nb, out, 0)
+
+#endif
+
+static size_t __sorted_intersect_n__(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out) {
+    if(na > nb) {
+        const uint32_t *t = a; a = b; b = t;
+        size_t tn = na; na = nb; nb = tn;
+    }
+    if(na * __SORTED_GALLOP_RATIO < nb) return __sorted_intersect_gallop__(a, na, b, nb, out);
+    if(na >= 8 && __sorted_has_avx2__()) return __sorted_intersect_avx2__(a, na, b, nb, out);
+    return __sorted_intersect_scalar__(a, na, b, nb, out);
+}
+
+static size_t __sorted_union_n__(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out) {
+    if(na > nb) {
+        const uint32_t *t = a; a = b; b = t;
+        size_t tn = na; na = nb; nb = tn;
+    }
+    if(na * __SORTED_GALLOP_RATIO < nb) return __sorted_union_gallop__(a, na, b, nb, out);
+    if(na >= 8 && __sorted_has_avx2__()) return __sorted_union_avx2__(a, na, b, nb, out);
+    return __sorted_union_scalar__(a, na, b, nb, out, 0);
+}
+
+// Reserves room for `bound` results (plus SIMD slack) after the current
+// elements and extends the length over it; the caller truncates afterwards.
+static uint32_t *__sorted_prepare__(uint32_t *out, size_t bound) {
+    size_t base = __array_length(out);
+    out = __array_reserve(out, base + bound + __SORTED_SLACK);
+    return __array_insert_n(out, base, NULL, bound);
+}
+
+uint32_t *sorted_intersect(uint32_t *out, const uint32_t *a, const uint32_t *b) {
+    size_t na = __array_length((void *)a), nb = __array_length((void *)b);
+    size_t base = __array_length(out);
+    out = __sorted_prepare__(out, na < nb ? na : nb);
+    __array_truncate(out, base + __sorted_intersect_n__(a, na, b, nb, out + base));
+    return out;
+}
+
+uint32_t *sorted_union(uint32_t *out, const uint32_t *a, const uint32_t *b) {
+    size_t na = __array_length((void *)a), nb = __array_length((void *)b);
+    size_t base = __array_length(out);
+    out = __sorted_prepare__(out, na + nb);
+    __array_truncate(out, base + __sorted_union_n__(a, na, b, nb, out + base));
+    return out;
+}
+
+static size_t __sorted_merge_k__(uint32_t *const *lists, size_t k, uint32_t *out, bool unique) {
+    const uint32_t **cur = malloc(k * sizeof(uint32_t *));
+    const uint32_t **end = malloc(k * sizeof(uint32_t *));
+    uint64_t *keys       = malloc(k * sizeof(uint64_t));
+    size_t *tree         = malloc(k * sizeof(size_t));
+    if(!cur || !end || !keys || !tree) {
+        fprintf(stderr, "sorted_merge failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for(size_t i = 0; i < k; ++i) {
+        cur[i]  = lists[i];
+        end[i]  = lists[i] + __array_length(lists[i]);
+        keys[i] = cur[i] < end[i] ? *cur[i] : __SORTED_DONE;
+        tree[i] = k;
+    }
+
+    // Internal node t holds the loser of its match. While building, `k` marks
+    // a node no leaf has reached yet: it beats every leaf and rises unchanged.
+    for(size_t leaf = k; leaf-- > 0;) {
+        size_t w = leaf;
+        for(size_t t = (leaf + k) / 2; t > 0; t /= 2) {
+            if(w == k) continue;
+            if(tree[t] == k || keys[tree[t]] < keys[w]) {
+                size_t loser = w;
+                w       = tree[t];
+                tree[t] = loser;
+            }
+        }
+        tree[0] = w;
+    }
+
+    size_t n = 0, w = tree[0];
+    uint64_t key = keys[w];
+    while(key != __SORTED_DONE) {
+        out[n] = (uint32_t)key;
+        n += !unique || n == 0 || out[n - 1] != (uint32_t)key;
+
+        key = ++cur[w] < end[w] ? *cur[w] : __SORTED_DONE;
+        keys[w] = key;
+        // Which side wins a match is unpredictable on real data, so the
+        // replay swaps winner and loser with masks instead of branching.
+        for(size_t t = (w + k) / 2; t > 0; t /= 2) {
+            size_t other  = tree[t];
+            uint64_t okey = keys[other];
+            size_t diff   = (w ^ other) & ((size_t)0 - (size_t)(okey < key));
+            tree[t] = other ^ diff;
+            w      ^= diff;
+            key     = okey < key ? okey : key;
+        }
+    }
+
+    free(cur);
+    free(end);
+    free(keys);
+    free(tree);
+    return n;
+}
+
+static uint32_t *__sorted_merge__(uint32_t *out, uint32_t *const *lists, size_t k, bool unique) {
+    size_t total = 0;
+    for(size_t i = 0; i < k; ++i) total += __array_length(lists[i]);
+    size_t base = __array_length(out);
+    out = __sorted_prepare__(out, total);
+
+    size_t n;
+    if(k == 1 && !unique) {
+        memcpy(out + base, lists[0], total * sizeof(uint32_t));
+        n = total;
+    } else if(k == 1) {
+        n = __sorted_union_scalar__(lists[0], total, NULL, 0, out + base, 0);
+    } else if(k == 2 && unique) {
+        // Not sorted_union: its fast paths assume strictly increasing inputs,
+        // while the scalar union also drops repeats within a list.
+        n = __sorted_union_scalar__(lists[0], __array_length(lists[0]), lists[1], __array_length(lists[1]), out + base, 0);
+    } else if(k == 2) {
+        n = __sorted_merge2__(lists[0], __array_length(lists[0]), lists[1], __array_length(lists[1]), out + base);
+    } else {
+        n = k ? __sorted_merge_k__(lists, k, out + base, unique) : 0;
+    }
+    __array_truncate(out, base + n);
+    return out;
+}
+
+uint32_t *sorted_merge(uint32_t *out, uint32_t *const *lists, size_t k) {
+    return __sorted_merge__(out, lists, k, false);
+}
+
+uint32_t *sorted_merge_unique(uint32_t *out, uint32_t *const *lists, size_t k) {
+    return __sorted_merge__(out, lists, k, true);
+}
+
+#endif // COLLECTIONS_SORTED_IMPLEMENTATION
+#endif // COLLECTIONS_SORTED_H
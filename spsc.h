@@ -0,0 +1,289 @@
+#ifndef COLLECTIONS_SPSC_H
+#define COLLECTIONS_SPSC_H
+
+
+#include <stdio.h>
+#include <stdbool.h>
+
+void        *__spsc_create(size_t item_size, size_t capacity);
+bool        __spsc_push(void *queue, const void *item);
+bool        __spsc_pop(void *queue, void *out);
+size_t      __spsc_push_n(void *queue, const void *items, size_t count);
+size_t      __spsc_pop_n(void *queue, void *out, size_t count);
+size_t      __spsc_length(void *queue);
+size_t      __spsc_capacity(void *queue);
+void        __spsc_destroy(void *queue);
+
+/**
+ * @brief Defines a single-producer / single-consumer queue type for elements of type `T`.
+ *
+ * The queue is a fixed-capacity ring preceded in memory by its header, like
+ * `Array(T)`. Exactly one thread may push and exactly one (other) thread may
+ * pop; both sides are wait-free.
+ *
+ * Example:
+ * ```c
+ * Spsc(Batch) pipe = spsc_create(Batch, 1024);
+ * ```
+ *
+ * @tparam T The element type.
+ */
+#define Spsc(T) T *
+
+/**
+ * @brief Creates an SPSC queue able to hold at least `capacity` elements.
+ *
+ * The capacity is rounded up to a power of two. The head and tail indices
+ * live on separate cache lines, each next to the side's cached copy of the
+ * opposite index, so a push or pop only touches the shared line of the other
+ * side when the cached value says the queue looks full (or empty).
+ *
+ * Example:
+ * ```c
+ * Spsc(uint64_t) q = spsc_create(uint64_t, 1 << 16);
+ * ```
+ *
+ * @tparam T        The element type.
+ * @param capacity  Minimum number of elements the queue can hold.
+ * @return Pointer to the queue storage.
+ */
+#define spsc_create(T, capacity)        ((T *)(__spsc_create(sizeof(T), capacity)))
+
+/**
+ * @brief Pushes one element (producer thread only).
+ *
+ * Example:
+ * ```c
+ * while (!spsc_push(int, q, 42)) { } // spin while full
+ * ```
+ *
+ * @tparam T The element type.
+ * @param q  Pointer to the queue.
+ * @param v  The value to push.
+ * @return `true` on success, `false` if the queue is full.
+ */
+#define spsc_push(T, q, v)              (__spsc_push(q, (T[]){ (v) }))
+
+/**
+ * @brief Pops one element into `*out` (consumer thread only).
+ *
+ * Example:
+ * ```c
+ * int v;
+ * if (spsc_pop(q, &v)) { ... }
+ * ```
+ *
+ * @param q   Pointer to the queue.
+ * @param out Destination for the element.
+ * @return `true` on success, `false` if the queue is empty.
+ */
+#define spsc_pop(q, out)                (__spsc_pop(q, out))
+
+/**
+ * @brief Pushes up to `n` elements (producer thread only).
+ *
+ * Copies as many items as currently fit with at most two `memcpy` calls and
+ * publishes them with a single release store. This is the fast path for
+ * streaming many small items.
+ *
+ * Example:
+ * ```c
+ * size_t sent = 0;
+ * while (sent < n) sent += spsc_push_n(q, items + sent, n - sent);
+ * ```
+ *
+ * @param q     Pointer to the queue.
+ * @param items Pointer to the elements to push.
+ * @param n     Number of elements available.
+ * @return The number of elements actually pushed.
+ */
+#define spsc_push_n(q, items, n)        (__spsc_push_n(q, items, n))
+
+/**
+ * @brief Pops up to `n` elements into `out` (consumer thread only).
+ *
+ * Example:
+ * ```c
+ * uint64_t buf[256];
+ * size_t got = spsc_pop_n(q, buf, 256);
+ * ```
+ *
+ * @param q   Pointer to the queue.
+ * @param out Destination buffer with room for `n` elements.
+ * @param n   Maximum number of elements to pop.
+ * @return The number of elements actually popped.
+ */
+#define spsc_pop_n(q, out, n)           (__spsc_pop_n(q, out, n))
+
+/**
+ * @brief Returns the number of queued elements.
+ *
+ * Only a snapshot when called while the other side is running.
+ *
+ * @param q Pointer to the queue.
+ */
+#define spsc_length(q)                  (__spsc_length(q))
+
+/**
+ * @brief Returns the capacity of the queue (a power of two).
+ *
+ * @param q Pointer to the queue.
+ */
+#define spsc_capacity(q)                (__spsc_capacity(q))
+
+/**
+ * @brief Destroys the queue. Neither side may use it afterwards.
+ *
+ * @param q Pointer to the queue.
+ */
+#define spsc_destroy(q)                 (__spsc_destroy(q))
+
+#ifdef COLLECTIONS_SPSC_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define __SPSC_CACHE_LINE 64
+
+/**
+ * @brief Metadata stored immediately before the queue storage.
+ *
+ * `head` and `tail` are free-running counters; the slot of counter `i` is
+ * `i & mask`. Each index shares its cache line only with the state owned by
+ * the same thread.
+ */
+typedef struct {
+    /** Consumer line: next index to pop, and the last tail it observed. */
+    _Alignas(__SPSC_CACHE_LINE) _Atomic size_t  head;
+    size_t                                      cached_tail;
+
+    /** Producer line: next index to push, and the last head it observed. */
+    _Alignas(__SPSC_CACHE_LINE) _Atomic size_t  tail;
+    size_t                                      cached_head;
+
+    /** Read-only after creation. */
+    _Alignas(__SPSC_CACHE_LINE) size_t          mask;
+    size_t                                      item_size;
+} SpscHeader;
+
+#define spscheader(p) ((SpscHeader *)(p) - 1)
+
+void *__spsc_create(size_t item_size, size_t capacity) {
+    size_t cap = 1;
+    while(cap < capacity) cap *= 2;
+
+    size_t bytes = sizeof(SpscHeader) + cap * item_size;
+    bytes = (bytes + __SPSC_CACHE_LINE - 1) & ~(size_t)(__SPSC_CACHE_LINE - 1);
+
+    SpscHeader *header = aligned_alloc(__SPSC_CACHE_LINE, bytes);
+    if(!header) {
+        fprintf(stderr, "__spsc_create failed: cannot allocate memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    atomic_init(&header->head, 0);
+    atomic_init(&header->tail, 0);
+    header->cached_tail = 0;
+    header->cached_head = 0;
+    header->mask        = cap - 1;
+    header->item_size   = item_size;
+
+    return (void *)(header + 1);
+}
+
+size_t __spsc_push_n(void *queue, const void *items, size_t count) {
+    SpscHeader *header = spscheader(queue);
+    size_t cap  = header->mask + 1;
+    size_t tail = atomic_load_explicit(&header->tail, memory_order_relaxed);
+
+    size_t room = cap - (tail - header->cached_head);
+    if(room < count) {
+        header->cached_head = atomic_load_explicit(&header->head, memory_order_acquire);
+        room = cap - (tail - header->cached_head);
+    }
+    if(count > room) count = room;
+    if(count == 0) return 0;
+
+    size_t size  = header->item_size;
+    size_t slot  = tail & header->mask;
+    size_t first = cap - slot < count ? cap - slot : count;
+    memcpy((char *)queue + slot * size, items, first * size);
+    memcpy(queue, (const char *)items + first * size, (count - first) * size);
+
+    atomic_store_explicit(&header->tail, tail + count, memory_order_release);
+    return count;
+}
+
+size_t __spsc_pop_n(void *queue, void *out, size_t count) {
+    SpscHeader *header = spscheader(queue);
+    size_t cap  = header->mask + 1;
+    size_t head = atomic_load_explicit(&header->head, memory_order_relaxed);
+
+    size_t avail = header->cached_tail - head;
+    if(avail < count) {
+        header->cached_tail = atomic_load_explicit(&header->tail, memory_order_acquire);
+        avail = header->cached_tail - head;
+    }
+    if(count > avail) count = avail;
+    if(count == 0) return 0;
+
+    size_t size  = header->item_size;
+    size_t slot  = head & header->mask;
+    size_t first = cap - slot < count ? cap - slot : count;
+    memcpy(out, (char *)queue + slot * size, first * size);
+    memcpy((char *)out + first * size, queue, (count - first) * size);
+
+    atomic_store_explicit(&header->head, head + count, memory_order_release);
+    return count;
+}
+
+bool __spsc_push(void *queue, const void *item) {
+    SpscHeader *header = spscheader(queue);
+    size_t tail = atomic_load_explicit(&header->tail, memory_order_relaxed);
+
+    if(tail - header->cached_head > header->mask) {
+        header->cached_head = atomic_load_explicit(&header->head, memory_order_acquire);
+        if(tail - header->cached_head > header->mask) return false;
+    }
+
+    memcpy((char *)queue + (tail & header->mask) * header->item_size, item, header->item_size);
+    atomic_store_explicit(&header->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool __spsc_pop(void *queue, void *out) {
+    SpscHeader *header = spscheader(queue);
+    size_t head = atomic_load_explicit(&header->head, memory_order_relaxed);
+
+    if(head == header->cached_tail) {
+        header->cached_tail = atomic_load_explicit(&header->tail, memory_order_acquire);
+        if(head == header->cached_tail) return false;
+    }
+
+    memcpy(out, (char *)queue + (head & header->mask) * header->item_size, header->item_size);
+    atomic_store_explicit(&header->head, head + 1, memory_order_release);
+    return true;
+}
+
+size_t __spsc_length(void *queue) {
+    SpscHeader *header = spscheader(queue);
+    size_t head = atomic_load_explicit(&header->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&header->tail, memory_order_acquire);
+    return tail - head;
+}
+
+size_t __spsc_capacity(void *queue) {
+    SpscHeader *header = spscheader(queue);
+    return header->mask + 1;
+}
+
+void __spsc_destroy(void *queue) {
+    SpscHeader *header = spscheader(queue);
+    free(header);
+}
+
+#endif // COLLECTIONS_SPSC_IMPLEMENTATION
+
+
+#endif // COLLECTIONS_SPSC_H
@@ -190,6 +190,17 @@ typedef struct TableNode TableNode;
 
 #define TABLE_CAPACITY 100
 
+/**
+ * Allocation hooks for the bucket array and the entry nodes. Define both
+ * before including the implementation to use another allocator; `TABLE_FREE`
+ * receives the size that was requested, so sized allocators such as pool.h
+ * can serve the fixed-size nodes.
+ */
+#ifndef TABLE_MALLOC
+#define TABLE_MALLOC(size)      malloc(size)
+#define TABLE_FREE(p, size)     free(p)
+#endif
+
 /**
  * @brief Structure containing the essential metadata for a generic hash table.
  *
@@ -225,6 +236,9 @@ struct TableNode {
 
 #define tableheader(p)          ((TableHeader *)p - 1)
 
+#define __table_node_size__(header)     (sizeof(TableNode) + (header)->key_size + (header)->value_size)
+#define __table_block_size__            (sizeof(TableHeader) + TABLE_CAPACITY * sizeof(TableNode *))
+
 static inline uint64_t __hash(const void *data, size_t len) {
     const unsigned char *bytes = (const unsigned char *)data;
     uint64_t hash = 1469598103934665603ull;  // FNV offset basis
@@ -247,7 +261,7 @@ size_t __table_get_index__(void *table, void *key) {
 TableNode *__table_node_create__(void *table, void *key, void *value) {
     TableHeader *header = tableheader(table);
 
-    TableNode *node = (TableNode *)malloc(sizeof(TableNode) + header->key_size + header->value_size);
+    TableNode *node = (TableNode *)TABLE_MALLOC(__table_node_size__(header));
     if(!node) {
         fprintf(stderr, "__table_node_create__ failed: cannot allocate memory\n");
         exit(EXIT_FAILURE);
@@ -265,11 +279,12 @@ TableNode *__table_node_create__(void *table, void *key, void *value) {
 
 
 void *__table_create(size_t key_size, size_t value_size) {
-    void *p = calloc(1, sizeof(TableHeader) + TABLE_CAPACITY * sizeof(TableNode *));
+    void *p = TABLE_MALLOC(__table_block_size__);
     if(!p) {
         fprintf(stderr, "__table_create failed: cannot allocate memory.\n");
         exit(EXIT_FAILURE);
     }
+    memset(p, 0, __table_block_size__);
 
     TableHeader *header = (TableHeader *)p;
     header->key_size    = key_size;
@@ -342,7 +357,7 @@ void __table_delete(void *table, void *key) {
     if(!current) return;
 
     prev->next = current->next;
-    free(current);
+    TABLE_FREE(current, __table_node_size__(header));
 }
 
 bool __table_exists(void *table, void *key) {
@@ -399,11 +414,11 @@ void __table_destroy(void *table) {
         TableNode *current = head;
         while(current != NULL) {
             TableNode *next = current->next;
-            free(current);
+            TABLE_FREE(current, __table_node_size__(header));
             current = next;
         }
     }
-    free(header);
+    TABLE_FREE(header, __table_block_size__);
 }
 
 
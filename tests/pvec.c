@@ -0,0 +1,197 @@
+#define COLLECTIONS_ARRAY_IMPLEMENTATION
+#define COLLECTIONS_PVEC_IMPLEMENTATION
+#include "array.h"
+#include "pvec.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint64_t state = 88172645463325252ull;
+
+static uint32_t next(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (uint32_t)state;
+}
+
+// A live version and the plain array it should always match.
+typedef struct {
+    PVec(uint64_t)  v;
+    uint64_t        *model;
+} Version;
+
+static uint64_t *copy(uint64_t *p) {
+    return array_insert_n(uint64_t, array_create(uint64_t), 0, p, array_length(p));
+}
+
+static void check(Version *s) {
+    size_t n = array_length(s->model);
+    assert(pvec_length(s->v) == n);
+    for(size_t i = 0; i < n; ++i) assert(pvec_at(uint64_t, s->v, i) == s->model[i]);
+
+    for(size_t i = 0, count; i < n; i += count) {
+        const uint64_t *run = pvec_chunk(uint64_t, s->v, i, &count);
+        assert(count >= 1 && count <= 32 && i + count <= n);
+        for(size_t k = 0; k < count; ++k) assert(run[k] == s->model[i + k]);
+    }
+
+    uint64_t *flat = pvec_to_array(uint64_t, s->v);
+    assert(array_length(flat) == n);
+    for(size_t i = 0; i < n; ++i) assert(flat[i] == s->model[i]);
+    array_destroy(flat);
+}
+
+static void drop(Version *s) {
+    pvec_release(s->v);
+    array_destroy(s->model);
+}
+
+// Grows one element at a time past three trie levels, then shrinks back to empty.
+static void test_grow_and_shrink(void) {
+    const size_t n = 32 * 32 * 32 + 32 * 32 + 100;
+    Version s = { pvec_create(uint64_t), array_create(uint64_t) };
+    // Lengths around leaf and level boundaries to keep a clone of.
+    const size_t marks[] = { 1, 32, 33, 64, 1056, 1057, 32 * 32 * 32 + 32, n };
+    Version snapshots[8];
+    size_t taken = 0;
+
+    for(size_t i = 0; i < n; ++i) {
+        if(i % 2) pvec_transient_push(uint64_t, &s.v, i);
+        else {
+            PVec(uint64_t) w = pvec_push(uint64_t, s.v, i);
+            pvec_release(s.v);
+            s.v = w;
+        }
+        s.model = array_insert(uint64_t, s.model, i, i);
+        if(taken < 8 && i + 1 == marks[taken]) snapshots[taken++] = (Version){ pvec_clone(s.v), copy(s.model) };
+    }
+    check(&s);
+
+    while(array_length(s.model) > 0) {
+        size_t len = array_length(s.model);
+        if(len % 3) pvec_transient_pop(&s.v);
+        else {
+            PVec(uint64_t) w = pvec_pop(s.v);
+            pvec_release(s.v);
+            s.v = w;
+        }
+        array_truncate(s.model, len - 1);
+        if(len % 1000 == 0 || len < 70) check(&s);
+    }
+    check(&s);
+    drop(&s);
+
+    // The clones taken on the way up share nodes with everything above.
+    assert(taken == 8);
+    for(size_t i = 0; i < taken; ++i) {
+        check(&snapshots[i]);
+        drop(&snapshots[i]);
+    }
+}
+
+static void test_from_array(void) {
+    size_t sizes[] = { 0, 1, 31, 32, 33, 64, 1056, 1057, 40000 };
+    for(size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); ++k) {
+        uint64_t *p = array_create(uint64_t);
+        for(size_t i = 0; i < sizes[k]; ++i) p = array_insert(uint64_t, p, i, next());
+        Version s = { pvec_from_array(uint64_t, p), p };
+        check(&s);
+        drop(&s);
+    }
+}
+
+// Random persistent and transient updates across versions that share nodes.
+static void test_random_versions(void) {
+    enum { SLOTS = 8 };
+    Version slots[SLOTS];
+    for(size_t i = 0; i < SLOTS; ++i) slots[i] = (Version){ pvec_create(uint64_t), array_create(uint64_t) };
+    uint64_t *items = array_create(uint64_t);
+
+    for(int round = 0; round < 6000; ++round) {
+        Version *src = &slots[next() % SLOTS];
+        Version *dst = &slots[next() % SLOTS];
+        size_t len = array_length(src->model);
+        uint64_t x = next();
+        PVec(uint64_t) w;
+        uint64_t *m;
+
+        switch(next() % 10) {
+        case 0: // persistent push into another slot
+            w = pvec_push(uint64_t, src->v, x);
+            m = array_insert(uint64_t, copy(src->model), len, x);
+            drop(dst);
+            *dst = (Version){ w, m };
+            break;
+        case 1: // persistent set
+            if(len == 0) break;
+            w = pvec_set(uint64_t, src->v, x % len, x);
+            m = copy(src->model);
+            m[x % len] = x;
+            drop(dst);
+            *dst = (Version){ w, m };
+            break;
+        case 2: // persistent pop
+            if(len == 0) break;
+            w = pvec_pop(src->v);
+            m = copy(src->model);
+            array_truncate(m, len - 1);
+            drop(dst);
+            *dst = (Version){ w, m };
+            break;
+        case 3: // clone
+            if(src == dst) break;
+            w = pvec_clone(src->v);
+            m = copy(src->model);
+            drop(dst);
+            *dst = (Version){ w, m };
+            break;
+        case 4: // release and start over
+            drop(dst);
+            *dst = (Version){ pvec_create(uint64_t), array_create(uint64_t) };
+            break;
+        case 5:
+            pvec_transient_push(uint64_t, &src->v, x);
+            src->model = array_insert(uint64_t, src->model, len, x);
+            break;
+        case 6: {
+            if(len > 6000) break;
+            size_t n = next() % (x % 4 ? 40 : 1200);
+            array_clear(items);
+            for(size_t i = 0; i < n; ++i) items = array_insert(uint64_t, items, i, next());
+            pvec_transient_append_n(uint64_t, &src->v, items, n);
+            src->model = array_insert_n(uint64_t, src->model, len, items, n);
+            break;
+        }
+        case 7:
+        case 8:
+            if(len == 0) break;
+            pvec_transient_set(uint64_t, &src->v, x % len, x);
+            src->model[x % len] = x;
+            break;
+        default:
+            for(size_t k = next() % 40; k > 0 && len > 0; --k, --len) pvec_transient_pop(&src->v);
+            array_truncate(src->model, len);
+            break;
+        }
+
+        check(src);
+        check(dst);
+        if(round % 64 == 0) for(size_t i = 0; i < SLOTS; ++i) check(&slots[i]);
+    }
+
+    for(size_t i = 0; i < SLOTS; ++i) {
+        check(&slots[i]);
+        drop(&slots[i]);
+    }
+    array_destroy(items);
+}
+
+int main(void) {
+    test_grow_and_shrink();
+    test_from_array();
+    test_random_versions();
+    puts("pvec: ok");
+    return 0;
+}
@@ -0,0 +1,129 @@
+#define COLLECTIONS_ARRAY_IMPLEMENTATION
+#define COLLECTIONS_SORTED_IMPLEMENTATION
+#include "array.h"
+#include "sorted.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint64_t state = 88172645463325252ull;
+
+static uint32_t next(void) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (uint32_t)state;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// A sorted list of `n` values below `range`; repeats are kept unless `strict`.
+static uint32_t *random_list(size_t n, uint32_t range, bool strict) {
+    uint32_t *p = array_create(uint32_t);
+    for(size_t i = 0; i < n; ++i) p = array_insert(uint32_t, p, array_length(p), next() % range);
+    array_sort(p, cmp_u32);
+    if(strict) {
+        size_t m = 0;
+        for(size_t i = 0; i < array_length(p); ++i) if(m == 0 || p[m - 1] != p[i]) p[m++] = p[i];
+        array_truncate(p, m);
+    }
+    return p;
+}
+
+// The expected merge: concatenate, sort, and optionally drop repeats.
+static uint32_t *reference(uint32_t **lists, size_t k, bool unique) {
+    uint32_t *all = array_create(uint32_t);
+    for(size_t i = 0; i < k; ++i) all = array_insert_n(uint32_t, all, array_length(all), lists[i], array_length(lists[i]));
+    array_sort(all, cmp_u32);
+    if(unique) {
+        size_t m = 0;
+        for(size_t i = 0; i < array_length(all); ++i) if(m == 0 || all[m - 1] != all[i]) all[m++] = all[i];
+        array_truncate(all, m);
+    }
+    return all;
+}
+
+static void expect(uint32_t *got, uint32_t *want) {
+    assert(array_length(got) == array_length(want));
+    for(size_t i = 0; i < array_length(want); ++i) assert(got[i] == want[i]);
+    array_destroy(got);
+    array_destroy(want);
+}
+
+static void check_merges(uint32_t **lists, size_t k) {
+    expect(sorted_merge(array_create(uint32_t), lists, k), reference(lists, k, false));
+    expect(sorted_merge_unique(array_create(uint32_t), lists, k), reference(lists, k, true));
+}
+
+// sorted_merge_unique accepts lists with repeated values, including two
+// lists of very different sizes, where sorted_union would gallop.
+static void test_merge_unique_repeats(void) {
+    uint32_t *single = array_create(uint32_t), *pairs = array_create(uint32_t);
+    single = array_insert(uint32_t, single, 0, 7);
+    for(uint32_t v = 0; v < 50; ++v) {
+        pairs = array_insert(uint32_t, pairs, array_length(pairs), v);
+        pairs = array_insert(uint32_t, pairs, array_length(pairs), v);
+    }
+    uint32_t *lists[] = { single, pairs };
+    check_merges(lists, 2);
+    lists[0] = pairs;
+    lists[1] = single;
+    check_merges(lists, 2);
+
+    uint32_t *fives = array_create(uint32_t), *evens = array_create(uint32_t);
+    fives = array_insert(uint32_t, fives, 0, 5);
+    fives = array_insert(uint32_t, fives, 1, 5);
+    for(uint32_t v = 0; v < 400; v += 2) evens = array_insert(uint32_t, evens, array_length(evens), v);
+    lists[0] = fives;
+    lists[1] = evens;
+    check_merges(lists, 2);
+
+    array_destroy(single);
+    array_destroy(pairs);
+    array_destroy(fives);
+    array_destroy(evens);
+}
+
+static void test_merge_random(void) {
+    uint32_t *lists[9];
+    for(int round = 0; round < 200; ++round) {
+        size_t k = 1 + next() % 9;
+        for(size_t i = 0; i < k; ++i) lists[i] = random_list(next() % (i % 2 ? 8 : 600), 1 + next() % 500, false);
+        check_merges(lists, k);
+        for(size_t i = 0; i < k; ++i) array_destroy(lists[i]);
+    }
+}
+
+static void test_union_intersect(void) {
+    for(int round = 0; round < 200; ++round) {
+        uint32_t range = 1 + next() % 5000;
+        uint32_t *a = random_list(next() % 2000, range, true);
+        uint32_t *b = random_list(next() % (round % 2 ? 20 : 2000), range, true);
+        uint32_t *lists[] = { a, b };
+
+        expect(sorted_union(array_create(uint32_t), a, b), reference(lists, 2, true));
+
+        uint32_t *want = array_create(uint32_t);
+        for(size_t i = 0, j = 0; i < array_length(a) && j < array_length(b);) {
+            if(a[i] < b[j]) ++i;
+            else if(b[j] < a[i]) ++j;
+            else { want = array_insert(uint32_t, want, array_length(want), a[i]); ++i; ++j; }
+        }
+        expect(sorted_intersect(array_create(uint32_t), a, b), want);
+
+        array_destroy(a);
+        array_destroy(b);
+    }
+}
+
+int main(void) {
+    test_merge_unique_repeats();
+    test_merge_random();
+    test_union_intersect();
+    puts("sorted: ok");
+    return 0;
+}
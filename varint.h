@@ -0,0 +1,421 @@
+#ifndef COLLECTIONS_VARINT_H
+#define COLLECTIONS_VARINT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/**
+ * @brief Upper bound on the bytes `varint_encode` writes for `n` values.
+ */
+#define VARINT_MAX_BYTES(n)         (10 * (size_t)(n))
+
+/**
+ * @brief Upper bound on the bytes `varint_group_encode` writes for `n` values.
+ */
+#define VARINT_GROUP_MAX_BYTES(n)   (8 * (size_t)(n) + 2 * (((size_t)(n) + 3) / 4))
+
+/**
+ * @brief Maps signed to unsigned integers so that small magnitudes stay small.
+ *
+ * 0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ... (as in Protocol Buffers).
+ */
+static inline uint64_t varint_zigzag_encode(int64_t v) {
+    return ((uint64_t)v << 1) ^ (0 - ((uint64_t)v >> 63));
+}
+
+/**
+ * @brief Inverse of `varint_zigzag_encode`.
+ */
+static inline int64_t varint_zigzag_decode(uint64_t u) {
+    return (int64_t)((u >> 1) ^ (0 - (u & 1)));
+}
+
+/**
+ * @brief Encodes values as LEB128 varints (7 bits per byte, high bit set on
+ * all but the last byte), the format of Protocol Buffers and DWARF.
+ *
+ * Runs of values below 128 are stored 16 at a time, and values of up to 56
+ * bits are written with one unaligned 8-byte store instead of a loop over
+ * their bytes.
+ *
+ * @param values Values to encode.
+ * @param n Number of values.
+ * @param out Destination with room for `VARINT_MAX_BYTES(n)` bytes.
+ * @return Number of bytes written.
+ */
+size_t varint_encode(const uint64_t *values, size_t n, uint8_t *out);
+
+/**
+ * @brief Zigzag-maps and encodes signed values. See `varint_encode`.
+ */
+size_t varint_encode_signed(const int64_t *values, size_t n, uint8_t *out);
+
+/**
+ * @brief Decodes up to `n` LEB128 varints.
+ *
+ * The length of each value comes from the mask of continuation bits in an
+ * 8-byte load, so values of up to 8 bytes decode without a branch per byte,
+ * and 16 single-byte values are decoded at once when the next 16 bytes have
+ * no continuation bit. Decoding stops before a value cut off by the end of
+ * the input, so a stream can be decoded chunk by chunk: keep the bytes past
+ * `*used` and prepend them to the next chunk.
+ *
+ * Example:
+ * ```c
+ * size_t used;
+ * size_t got = varint_decode(buf, len, values, capacity, &used);
+ * if (got == ARRAY_NPOS) { ... malformed input ... }
+ * ```
+ *
+ * @param in Encoded bytes.
+ * @param size Number of bytes available.
+ * @param out Destination for at most `n` values.
+ * @param n Maximum number of values to decode.
+ * @param used Receives the number of bytes consumed.
+ * @return Number of values decoded, or `ARRAY_NPOS` if a value is longer
+ *         than 10 bytes or overflows 64 bits.
+ */
+size_t varint_decode(const uint8_t *in, size_t size, uint64_t *out, size_t n, size_t *used);
+
+/**
+ * @brief Decodes zigzag-mapped signed values. See `varint_decode`.
+ */
+size_t varint_decode_signed(const uint8_t *in, size_t size, int64_t *out, size_t n, size_t *used);
+
+/**
+ * @brief Encodes values in group varint format.
+ *
+ * Values are stored four at a time: a 2-byte little-endian tag holding the
+ * byte length minus one of each value in 3 bits, followed by the values'
+ * significant bytes, little-endian. A group decodes with four unaligned
+ * loads and masks and no data-dependent branch, which is faster than LEB128
+ * but not compatible with it. The last group may hold fewer than four
+ * values; the reader must know `n`.
+ *
+ * @param values Values to encode.
+ * @param n Number of values.
+ * @param out Destination with room for `VARINT_GROUP_MAX_BYTES(n)` bytes.
+ * @return Number of bytes written.
+ */
+size_t varint_group_encode(const uint64_t *values, size_t n, uint8_t *out);
+
+/**
+ * @brief Decodes up to `n` values written by `varint_group_encode`.
+ *
+ * Stops before a group cut off by the end of the input.
+ *
+ * @param in Encoded bytes.
+ * @param size Number of bytes available.
+ * @param out Destination for at most `n` values.
+ * @param n Number of values that were encoded (or that remain to decode).
+ * @param used Receives the number of bytes consumed.
+ * @return Number of values decoded.
+ */
+size_t varint_group_decode(const uint8_t *in, size_t size, uint64_t *out, size_t n, size_t *used);
+
+/**
+ * @brief Appends the LEB128 encoding of `n` values to a byte array.
+ *
+ * Example:
+ * ```c
+ * Array(uint8_t) wire = array_create(uint8_t);
+ * wire = varint_append(wire, ids, array_length(ids));
+ * ```
+ *
+ * @param buf Destination `Array(uint8_t)`.
+ * @param values Values to encode.
+ * @param n Number of values.
+ * @return The (possibly moved) destination array.
+ */
+uint8_t *varint_append(uint8_t *buf, const uint64_t *values, size_t n);
+
+/**
+ * @brief Appends the zigzag LEB128 encoding of `n` signed values to a byte array.
+ */
+uint8_t *varint_append_signed(uint8_t *buf, const int64_t *values, size_t n);
+
+/**
+ * @brief Decodes a whole buffer of LEB128 varints into a new array.
+ *
+ * The program exits if the buffer is malformed or ends in the middle of a value.
+ *
+ * @param in Encoded bytes.
+ * @param size Number of bytes.
+ * @return A new `Array(uint64_t)`.
+ */
+uint64_t *varint_decode_array(const uint8_t *in, size_t size);
+
+/**
+ * @brief Decodes a whole buffer of zigzag LEB128 varints into a new `Array(int64_t)`.
+ */
+int64_t *varint_decode_signed_array(const uint8_t *in, size_t size);
+
+
+#ifdef COLLECTIONS_VARINT_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+
+#define __VARINT_HIGH_BITS      UINT64_C(0x8080808080808080)
+
+static inline uint64_t __varint_load64__(const uint8_t *p) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+static inline void __varint_store64__(uint8_t *p, uint64_t word) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    memcpy(p, &word, 8);
+}
+
+// Gathers the 7-bit payloads of up to eight varint bytes into one integer.
+static inline uint64_t __varint_compact__(uint64_t x) {
+    return (x & UINT64_C(0x7f))
+         | ((x >> 1) & UINT64_C(0x3f80))
+         | ((x >> 2) & UINT64_C(0x1fc000))
+         | ((x >> 3) & UINT64_C(0xfe00000))
+         | ((x >> 4) & UINT64_C(0x7f0000000))
+         | ((x >> 5) & UINT64_C(0x3f800000000))
+         | ((x >> 6) & UINT64_C(0x1fc0000000000))
+         | ((x >> 7) & UINT64_C(0xfe000000000000));
+}
+
+// Inverse of __varint_compact__ for values below 2^56.
+static inline uint64_t __varint_spread__(uint64_t v) {
+    return (v & UINT64_C(0x7f))
+         | ((v & UINT64_C(0x3f80)) << 1)
+         | ((v & UINT64_C(0x1fc000)) << 2)
+         | ((v & UINT64_C(0xfe00000)) << 3)
+         | ((v & UINT64_C(0x7f0000000)) << 4)
+         | ((v & UINT64_C(0x3f800000000)) << 5)
+         | ((v & UINT64_C(0x1fc0000000000)) << 6)
+         | ((v & UINT64_C(0xfe000000000000)) << 7);
+}
+
+static inline unsigned __varint_width__(uint64_t v) {
+    return v == 0 ? 0 : 64 - (unsigned)__builtin_clzll(v);
+}
+
+static inline size_t __varint_encode_one__(uint64_t v, uint8_t *out) {
+    size_t len = 0;
+    while(v >= 0x80) {
+        out[len++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[len++] = (uint8_t)v;
+    return len;
+}
+
+// Decodes one value byte by byte. Returns its length, 0 if the input ends
+// first, or ARRAY_NPOS if it is malformed.
+static inline size_t __varint_decode_one__(const uint8_t *in, size_t avail, uint64_t *out) {
+    uint64_t v = 0;
+    for(size_t i = 0; i < avail && i < 10; ++i) {
+        uint8_t byte = in[i];
+        if(i == 9 && byte > 1) return ARRAY_NPOS;
+        v |= (uint64_t)(byte & 0x7f) << (7 * i);
+        if(!(byte & 0x80)) {
+            *out = v;
+            return i + 1;
+        }
+    }
+    return avail >= 10 ? ARRAY_NPOS : 0;
+}
+
+// Encoder body shared by the unsigned and zigzag entry points; MAP converts
+// one input element to the unsigned value to encode.
+#define __VARINT_ENCODE_DEFINE__(NAME, T, MAP)                                              \
+size_t NAME(const T *values, size_t n, uint8_t *out) {                                      \
+    size_t pos = 0;                                                                         \
+    for(size_t i = 0; i < n; i += 16) {                                                     \
+        size_t m = n - i < 16 ? n - i : 16;                                                 \
+        uint64_t any = 0;                                                                   \
+        for(size_t k = 0; k < m; ++k) any |= MAP(values[i + k]);                            \
+        if(any < 0x80) {                                                                    \
+            /* A run of single-byte values: narrow them in one pass. */                     \
+            for(size_t k = 0; k < m; ++k) out[pos + k] = (uint8_t)MAP(values[i + k]);       \
+            pos += m;                                                                       \
+            continue;                                                                       \
+        }                                                                                   \
+        for(size_t k = 0; k < m; ++k) {                                                     \
+            uint64_t v = MAP(values[i + k]);                                                \
+            if(v < (UINT64_C(1) << 56)) {                                                   \
+                /* At most 8 bytes: one store, continuation bits on all but the last. */    \
+                /* No separate 1-byte case: lengths are unpredictable in mixed data. */     \
+                unsigned len = (__varint_width__(v | 1) + 6) / 7;                           \
+                uint64_t more = __VARINT_HIGH_BITS & ((UINT64_C(1) << (8 * (len - 1))) - 1); \
+                __varint_store64__(out + pos, __varint_spread__(v) | more);                 \
+                pos += len;                                                                 \
+            } else {                                                                        \
+                pos += __varint_encode_one__(v, out + pos);                                 \
+            }                                                                               \
+        }                                                                                   \
+    }                                                                                       \
+    return pos;                                                                             \
+}
+
+#define __varint_identity__(v)      ((uint64_t)(v))
+
+__VARINT_ENCODE_DEFINE__(varint_encode, uint64_t, __varint_identity__)
+__VARINT_ENCODE_DEFINE__(varint_encode_signed, int64_t, varint_zigzag_encode)
+
+size_t varint_decode(const uint8_t *in, size_t size, uint64_t *out, size_t n, size_t *used) {
+    size_t pos = 0, count = 0;
+    while(count < n) {
+        size_t avail = size - pos;
+        if(avail >= 8) {
+            uint64_t lo = __varint_load64__(in + pos);
+            if((lo & __VARINT_HIGH_BITS) == 0 && avail >= 16 && n - count >= 16 &&
+               (__varint_load64__(in + pos + 8) & __VARINT_HIGH_BITS) == 0) {
+                for(size_t k = 0; k < 16; ++k) out[count + k] = in[pos + k];
+                pos   += 16;
+                count += 16;
+                continue;
+            }
+            // The lowest clear high bit ends the value; keep the bytes up to it.
+            uint64_t stops = ~lo & __VARINT_HIGH_BITS;
+            if(stops) {
+                out[count++] = __varint_compact__(lo & (stops ^ (stops - 1)));
+                pos += (size_t)(__builtin_ctzll(stops) >> 3) + 1;
+                continue;
+            }
+        }
+
+        // Values longer than 8 bytes, and the last few bytes of the input.
+        size_t len = __varint_decode_one__(in + pos, avail, &out[count]);
+        if(len == ARRAY_NPOS) return ARRAY_NPOS;
+        if(len == 0) break;
+        pos   += len;
+        count += 1;
+    }
+    *used = pos;
+    return count;
+}
+
+size_t varint_decode_signed(const uint8_t *in, size_t size, int64_t *out, size_t n, size_t *used) {
+    uint64_t *raw = (uint64_t *)out;
+    size_t count = varint_decode(in, size, raw, n, used);
+    if(count == ARRAY_NPOS) return ARRAY_NPOS;
+    for(size_t i = 0; i < count; ++i) out[i] = varint_zigzag_decode(raw[i]);
+    return count;
+}
+
+size_t varint_group_encode(const uint64_t *values, size_t n, uint8_t *out) {
+    size_t pos = 0;
+    for(size_t i = 0; i < n; i += 4) {
+        size_t m = n - i < 4 ? n - i : 4;
+        size_t p = pos + 2;
+        unsigned tag = 0;
+        for(size_t k = 0; k < m; ++k) {
+            uint64_t v = values[i + k];
+            unsigned len = v == 0 ? 1 : (__varint_width__(v) + 7) / 8;
+            __varint_store64__(out + p, v);
+            tag |= (len - 1) << (3 * k);
+            p += len;
+        }
+        out[pos]     = (uint8_t)tag;
+        out[pos + 1] = (uint8_t)(tag >> 8);
+        pos = p;
+    }
+    return pos;
+}
+
+size_t varint_group_decode(const uint8_t *in, size_t size, uint64_t *out, size_t n, size_t *used) {
+    static const uint64_t masks[9] = {
+        0, UINT64_C(0xff), UINT64_C(0xffff), UINT64_C(0xffffff), UINT64_C(0xffffffff),
+        UINT64_C(0xffffffffff), UINT64_C(0xffffffffffff), UINT64_C(0xffffffffffffff), ~UINT64_C(0),
+    };
+
+    size_t pos = 0, count = 0;
+    while(count < n) {
+        size_t avail = size - pos;
+        size_t m = n - count < 4 ? n - count : 4;
+        if(avail < 2) break;
+        unsigned tag = (unsigned)in[pos] | (unsigned)in[pos + 1] << 8;
+
+        // A group is at most 34 bytes; with that much input every load is in bounds.
+        if(avail >= 34) {
+            size_t p = pos + 2;
+            for(size_t k = 0; k < m; ++k) {
+                size_t len = ((tag >> (3 * k)) & 7) + 1;
+                out[count + k] = __varint_load64__(in + p) & masks[len];
+                p += len;
+            }
+            pos    = p;
+            count += m;
+            continue;
+        }
+
+        size_t need = 2;
+        for(size_t k = 0; k < m; ++k) need += ((tag >> (3 * k)) & 7) + 1;
+        if(need > avail) break;
+
+        size_t p = pos + 2;
+        for(size_t k = 0; k < m; ++k) {
+            size_t len = ((tag >> (3 * k)) & 7) + 1;
+            uint64_t v = 0;
+            for(size_t b = 0; b < len; ++b) v |= (uint64_t)in[p + b] << (8 * b);
+            out[count + k] = v;
+            p += len;
+        }
+        pos    = p;
+        count += m;
+    }
+    *used = pos;
+    return count;
+}
+
+uint8_t *varint_append(uint8_t *buf, const uint64_t *values, size_t n) {
+    size_t start = array_length(buf);
+    buf = array_insert_n(uint8_t, buf, start, NULL, VARINT_MAX_BYTES(n));
+    array_truncate(buf, start + varint_encode(values, n, buf + start));
+    return buf;
+}
+
+uint8_t *varint_append_signed(uint8_t *buf, const int64_t *values, size_t n) {
+    size_t start = array_length(buf);
+    buf = array_insert_n(uint8_t, buf, start, NULL, VARINT_MAX_BYTES(n));
+    array_truncate(buf, start + varint_encode_signed(values, n, buf + start));
+    return buf;
+}
+
+// Every value ends with exactly one byte whose high bit is clear.
+static size_t __varint_count__(const uint8_t *in, size_t size) {
+    size_t count = 0;
+    for(size_t i = 0; i < size; ++i) count += !(in[i] & 0x80);
+    return count;
+}
+
+static void *__varint_decode_array__(const uint8_t *in, size_t size, bool zigzag, const char *fn) {
+    size_t n = __varint_count__(in, size);
+    uint64_t *out = array_insert_n(uint64_t, array_create(uint64_t), 0, NULL, n);
+
+    size_t used;
+    size_t count = zigzag ? varint_decode_signed(in, size, (int64_t *)out, n, &used)
+                          : varint_decode(in, size, out, n, &used);
+    if(count != n || used != size) {
+        fprintf(stderr, "%s failed: malformed or truncated input.\n", fn);
+        exit(EXIT_FAILURE);
+    }
+    return out;
+}
+
+uint64_t *varint_decode_array(const uint8_t *in, size_t size) {
+    return __varint_decode_array__(in, size, false, "varint_decode_array");
+}
+
+int64_t *varint_decode_signed_array(const uint8_t *in, size_t size) {
+    return __varint_decode_array__(in, size, true, "varint_decode_signed_array");
+}
+
+#endif // COLLECTIONS_VARINT_IMPLEMENTATION
+#endif // COLLECTIONS_VARINT_H